@@ -0,0 +1,907 @@
+/*
+ * rpiz - https://github.com/bp0/rpiz
+ * Copyright (C) 2017  Burt P. <pburt0@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <pthread.h>
+#include "util.h"
+#include "cpu.h"
+#include "board.h"
+#include "bench.h"
+#include "eigen_cache.h"
+#include "cpu_sampler.h"
+#include "cpuinfo_ctx.h"
+#include "cpu_fleet.h"
+#include "fields_live.h"
+#include "cpu_shm.h"
+
+static long long time_ns(void) {
+    struct timespec tv;
+    clock_gettime(CLOCK_MONOTONIC, &tv);
+    return (long long)tv.tv_sec*1000000000LL + tv.tv_nsec;
+}
+
+/* a flags line longer than 1500 characters, like recent x86 server parts */
+static const char fixture_flags[] =
+    "fpu vme de pse tsc msr pae mce cx8 apic sep mtrr pge mca cmov pat pse36 clflush dts acpi mmx fxsr sse sse2 "
+    "ss ht tm pbe syscall nx pdpe1gb rdtscp lm constant_tsc art arch_perfmon pebs bts rep_good nopl xtopology "
+    "nonstop_tsc cpuid aperfmperf tsc_known_freq pni pclmulqdq dtes64 monitor ds_cpl vmx smx est tm2 ssse3 "
+    "sdbg fma cx16 xtpr pdcm pcid dca sse4_1 sse4_2 x2apic movbe popcnt tsc_deadline_timer aes xsave avx f16c "
+    "rdrand lahf_lm abm 3dnowprefetch cpuid_fault epb cat_l3 cat_l2 cdp_l3 invpcid_single intel_ppin cdp_l2 ssbd "
+    "mba ibrs ibpb stibp ibrs_enhanced tpr_shadow flexpriority ept vpid ept_ad fsgsbase tsc_adjust bmi1 hle avx2 "
+    "smep bmi2 erms invpcid rtm cqm rdt_a avx512f avx512dq rdseed adx smap avx512ifma clflushopt clwb intel_pt "
+    "avx512cd sha_ni avx512bw avx512vl xsaveopt xsavec xgetbv1 xsaves cqm_llc cqm_occup_llc cqm_mbm_total "
+    "cqm_mbm_local split_lock_detect avx_vnni avx512_bf16 wbnoinvd dtherm ida arat pln pts hwp hwp_act_window "
+    "hwp_epp hwp_pkg_req vnmi avx512vbmi umip pku ospke waitpkg avx512_vbmi2 gfni vaes vpclmulqdq avx512_vnni "
+    "avx512_bitalg tme avx512_vpopcntdq la57 rdpid bus_lock_detect cldemote movdiri movdir64b enqcmd fsrm "
+    "md_clear serialize tsxldtrk pconfig arch_lbr ibt amx_bf16 avx512_fp16 amx_tile amx_int8 flush_l1d "
+    "arch_capabilities avx512_4vnniw avx512_4fmaps avx512_vp2intersect hypervisor tsc_scale vmcb_clean "
+    "flushbyasid decodeassists pausefilter pfthreshold v_vmsave_vmload vgif x2avic v_spec_ctrl vnmi_avic "
+    "perfmon_v2 amd_lbr_v2 sme sev sev_es sev_snp debug_swap avx_ifma avx_vnni_int8 avx_ne_convert prefetchiti";
+
+static char *gen_fixture(int threads) {
+    char *buff, *p;
+    int i, sz = threads * (sizeof(fixture_flags) + 1024) + 1;
+    buff = malloc(sz);
+    if (!buff) return NULL;
+    p = buff;
+    for (i = 0; i < threads; i++) {
+        p += sprintf(p,
+            "processor\t: %d\n"
+            "vendor_id\t: GenuineIntel\n"
+            "cpu family\t: 6\n"
+            "model\t\t: 143\n"
+            "model name\t: Intel(R) Xeon(R) Platinum 8480+\n"
+            "stepping\t: 8\n"
+            "cpu MHz\t\t: 2000.000\n"
+            "cache size\t: 107520 KB\n"
+            "physical id\t: %d\n"
+            "siblings\t: %d\n"
+            "core id\t\t: %d\n"
+            "cpu cores\t: %d\n"
+            "fpu\t\t: yes\n"
+            "flags\t\t: %s\n"
+            "bugs\t\t: spectre_v1 spectre_v2 spec_store_bypass swapgs eibrs_pbrsb\n"
+            "bogomips\t: 4000.00\n"
+            "clflush size\t: 64\n"
+            "address sizes\t: 46 bits physical, 57 bits virtual\n"
+            "power management:\n"
+            "\n",
+            i, i / (threads / 2), threads / 2, (i % (threads / 2)) / 2, threads / 4, fixture_flags);
+    }
+    return buff;
+}
+
+#define BENCH_KV_THREADS 512
+#define BENCH_KV_ROUNDS 50
+static int bench_kv(void) {
+    char *fixture;
+    kv_scan *kv; kv_slice key, value;
+    long long start, elapsed;
+    int r, lines = 0, flags_len = 0;
+
+    fixture = gen_fixture(BENCH_KV_THREADS);
+    if (!fixture) return 1;
+
+    start = time_ns();
+    for (r = 0; r < BENCH_KV_ROUNDS; r++) {
+        lines = 0;
+        kv = kv_new(fixture);
+        while( kv_next(kv, &key, &value) ) {
+            if (KV_IS(&key, "flags"))
+                flags_len = value.len;
+            lines++;
+        }
+        kv_free(kv);
+    }
+    elapsed = time_ns() - start;
+
+    printf("kv: %d threads, %d bytes, %d lines, flags line %d chars (fixture %d)\n",
+        BENCH_KV_THREADS, (int)strlen(fixture), lines, flags_len, (int)strlen(fixture_flags));
+    printf("kv: %0.2f ns/line, %0.2f us/scan\n",
+        (double)elapsed / ((double)lines * BENCH_KV_ROUNDS),
+        (double)elapsed / 1000.0 / BENCH_KV_ROUNDS);
+    free(fixture);
+    return (flags_len == (int)strlen(fixture_flags)) ? 0 : 1;
+}
+
+#define BENCH_STRLIST_THREADS 1024
+static int bench_strlist(void) {
+    cpu_string_list *each_flag, *distinct;
+    const char *cur, *next;
+    char tmp[64];
+    long long start, elapsed_flags, elapsed_distinct;
+    int i, adds = 0, ok;
+
+    /* every thread adds every flag, like process_flags() on a flat cpuinfo */
+    each_flag = strlist_new();
+    start = time_ns();
+    for (i = 0; i < BENCH_STRLIST_THREADS; i++) {
+        cur = fixture_flags;
+        while (*cur) {
+            next = strchr(cur, ' ');
+            if (!next) next = cur + strlen(cur);
+            strlist_add_n(each_flag, cur, next - cur);
+            adds++;
+            cur = (*next) ? next + 1 : next;
+        }
+    }
+    elapsed_flags = time_ns() - start;
+
+    /* one distinct string per thread, like cpukhz_max_str on a big box */
+    distinct = strlist_new();
+    start = time_ns();
+    for (i = 0; i < BENCH_STRLIST_THREADS * 64; i++) {
+        sprintf(tmp, "%d", i);
+        strlist_add(distinct, tmp);
+    }
+    elapsed_distinct = time_ns() - start;
+
+    ok = (strlist_find(each_flag, "avx512f") >= 0
+        && each_flag->strs[strlist_find(each_flag, "avx512f")].ref_count == BENCH_STRLIST_THREADS
+        && distinct->count == BENCH_STRLIST_THREADS * 64);
+
+    printf("strlist: %d threads x %d flags: %0.2f ns/add\n",
+        BENCH_STRLIST_THREADS, each_flag->count, (double)elapsed_flags / adds);
+    printf("strlist: %d distinct strings: %0.2f ns/add\n",
+        distinct->count, (double)elapsed_distinct / distinct->count);
+    strlist_free(each_flag);
+    strlist_free(distinct);
+    return ok ? 0 : 1;
+}
+
+#define BENCH_FEATURE_ROUNDS 10000000
+static int bench_feature(void) {
+    char flag[32] = "";
+    const char *all;
+    long long start, elapsed_str, elapsed_id;
+    volatile int sink = 0;
+    int i, id, len;
+
+    cpu_init();
+    all = cpu_all_flags();
+    if (!all) {
+        cpu_cleanup();
+        return 1;
+    }
+    len = strcspn(all, " ");
+    if (len > 31) len = 31;
+    memcpy(flag, all, len);
+
+    start = time_ns();
+    for (i = 0; i < BENCH_FEATURE_ROUNDS; i++)
+        sink += cpu_has_flag(flag);
+    elapsed_str = time_ns() - start;
+
+    id = cpu_feature_id(flag);
+    start = time_ns();
+    for (i = 0; i < BENCH_FEATURE_ROUNDS; i++)
+        sink += cpu_has_feature(id);
+    elapsed_id = time_ns() - start;
+
+    printf("feature: cpu_has_flag(\"%s\"): %0.2f ns/call\n", flag, (double)elapsed_str / BENCH_FEATURE_ROUNDS);
+    printf("feature: cpu_has_feature(%d): %0.2f ns/call\n", id, (double)elapsed_id / BENCH_FEATURE_ROUNDS);
+    cpu_cleanup();
+    return 0;
+}
+
+#define BENCH_FREQ_ROUNDS 200
+#define BENCH_FREQ_HZ 1000
+#define BENCH_FREQ_MS 500
+static int bench_freq(void) {
+    freq_sampler *fs;
+    freq_sample buff[4096];
+    freq_stats st;
+    struct timespec ts = { 0, 10000000 };
+    cpu_mask *online;
+    long long start, elapsed_old, elapsed_new, wall, read = 0;
+    int r, cpu, n;
+    long long sink = 0; /* kHz over many rounds overflows an int */
+
+    fs = freq_sampler_new(NULL, 1 << 16);
+    n = freq_sampler_cpus(fs);
+    if (!n) {
+        printf("freq: no cpufreq/scaling_cur_freq, try --root with a sysfs tree\n");
+        freq_sampler_free(fs);
+        return 0;
+    }
+
+    online = get_cpu_online();
+    start = time_ns();
+    for (r = 0; r < BENCH_FREQ_ROUNDS; r++)
+        CPUMASK_FOR_EACH(cpu, online)
+            sink += get_cpu_int("cpufreq/scaling_cur_freq", cpu);
+    elapsed_old = time_ns() - start;
+    cpumask_free(online);
+
+    start = time_ns();
+    for (r = 0; r < BENCH_FREQ_ROUNDS; r++)
+        sink += freq_sampler_sample(fs);
+    elapsed_new = time_ns() - start;
+    while ((r = freq_sampler_read(fs, buff, 4096)) > 0);
+
+    printf("freq: %d cpus, get_cpu_int(): %0.0f ns/read, pread sampler: %0.0f ns/read\n",
+        n, (double)elapsed_old / BENCH_FREQ_ROUNDS / n, (double)elapsed_new / BENCH_FREQ_ROUNDS / n);
+
+    freq_sampler_free(fs);
+    fs = freq_sampler_new(NULL, 1 << 16);
+    start = time_ns();
+    freq_sampler_start(fs, BENCH_FREQ_HZ);
+    while (time_ns() - start < BENCH_FREQ_MS * 1000000LL) {
+        nanosleep(&ts, NULL);
+        read += freq_sampler_read(fs, buff, 4096);
+    }
+    freq_sampler_stop(fs);
+    read += freq_sampler_read(fs, buff, 4096);
+    wall = time_ns() - start;
+
+    printf("freq: %d Hz for %d ms: %lld passes, %lld samples read, %lld dropped\n",
+        BENCH_FREQ_HZ, BENCH_FREQ_MS, freq_sampler_passes(fs), read, freq_sampler_dropped(fs));
+    printf("freq: overhead %0.1f us/pass, %0.2f%% of one cpu\n",
+        (double)freq_sampler_overhead_ns(fs) / 1000.0 / freq_sampler_passes(fs),
+        100.0 * freq_sampler_overhead_ns(fs) / wall);
+    online = get_cpu_online();
+    if (freq_sampler_stats(fs, cpumask_next(online, -1), &st))
+        printf("freq: cpu%d min %d max %d mean %0.0f khz over %d samples\n",
+            cpumask_next(online, -1), st.min, st.max, st.mean, st.count);
+    cpumask_free(online);
+    freq_sampler_free(fs);
+    return (sink == 0);
+}
+
+#define BENCH_BATCH_ROUNDS 5
+static const char *batch_mode_str(int mode) {
+    switch (mode) {
+        case READ_BATCH_URING:
+            return "io_uring";
+        case READ_BATCH_THREADS:
+            return "threads";
+        default:
+            return "serial";
+    }
+}
+
+static int bench_batch(void) {
+    static const char *items[] = {
+        "cpufreq/scaling_min_freq",
+        "cpufreq/scaling_max_freq",
+        "cpufreq/scaling_cur_freq",
+    };
+    static const int modes[] = { READ_BATCH_SERIAL, READ_BATCH_THREADS, READ_BATCH_URING };
+    cpu_mask *online;
+    read_req *reqs;
+    long long start, elapsed_read, elapsed_init;
+    int *ids, n = 0, cpu, m, r, used = 0, ok;
+
+    online = get_cpu_online();
+    ids = malloc(sizeof(int) * (cpumask_count(online) + 1));
+    if (!ids) return 1;
+    CPUMASK_FOR_EACH(cpu, online)
+        ids[n++] = cpu;
+    cpumask_free(online);
+
+    for (m = 0; m < (int)(sizeof(modes) / sizeof(modes[0])); m++) {
+        read_batch_set_mode(modes[m]);
+        ok = 0;
+        start = time_ns();
+        for (r = 0; r < BENCH_BATCH_ROUNDS; r++) {
+            reqs = read_cpu_batch(ids, n, items, 3);
+            if (reqs && reqs[2].len > 0) ok++;
+            free(reqs);
+        }
+        elapsed_read = time_ns() - start;
+        reqs = malloc(sizeof(read_req));
+        if (reqs) {
+            util_path(reqs->path, READ_REQ_PATH, "/sys/devices/system/cpu/online");
+            used = read_batch(reqs, 1);
+            free(reqs);
+        }
+
+        start = time_ns();
+        for (r = 0; r < BENCH_BATCH_ROUNDS; r++) {
+            cpu_init();
+            cpu_detect_all();
+            cpu_cleanup();
+        }
+        elapsed_init = time_ns() - start;
+
+        printf("batch: %-8s (ran as %s) %d cpus, %d files: read %0.1f us, detect %0.1f us%s\n",
+            batch_mode_str(modes[m]), batch_mode_str(used), n, n * 3,
+            (double)elapsed_read / 1000.0 / BENCH_BATCH_ROUNDS,
+            (double)elapsed_init / 1000.0 / BENCH_BATCH_ROUNDS,
+            ok ? "" : " (no cpufreq files)");
+    }
+    read_batch_set_mode(READ_BATCH_AUTO);
+    free(ids);
+    return 0;
+}
+
+#define BENCH_INIT_ROUNDS 5
+static int bench_init(void) {
+    static const int jobs[] = { 1, 2, 4, 8, 0 };
+    long long start, elapsed;
+    int j, r;
+
+    for (j = 0; j < (int)(sizeof(jobs) / sizeof(jobs[0])); j++) {
+        par_set_jobs(jobs[j]);
+        start = time_ns();
+        for (r = 0; r < BENCH_INIT_ROUNDS; r++) {
+            cpu_init();
+            cpu_detect_all();
+            cpu_cleanup();
+        }
+        elapsed = time_ns() - start;
+        printf("init: %d jobs%s: detect %0.1f us\n", par_jobs(), jobs[j] ? "" : " (auto)",
+            (double)elapsed / 1000.0 / BENCH_INIT_ROUNDS);
+    }
+    par_set_jobs(0);
+    return 0;
+}
+
+/* board and cpu detection with a probe session each, then sharing one */
+static int bench_probe(void) {
+    probe_stats st;
+    long long start, elapsed;
+    int shared, r;
+
+    for (shared = 0; shared < 2; shared++) {
+        probe_reset_stats();
+        start = time_ns();
+        for (r = 0; r < BENCH_INIT_ROUNDS; r++) {
+            if (shared) probe_begin();
+            board_init();
+            cpu_init();
+            cpu_detect_all();
+            if (shared) probe_end();
+            board_cleanup();
+            cpu_cleanup();
+        }
+        elapsed = time_ns() - start;
+        probe_get_stats(&st);
+        printf("probe: %s: %lld files opened, %lld bytes read, %lld reads shared, %0.1f us per init\n",
+            shared ? "shared session" : "separate sessions",
+            st.opened / BENCH_INIT_ROUNDS, st.bytes / BENCH_INIT_ROUNDS, st.hits / BENCH_INIT_ROUNDS,
+            (double)elapsed / 1000.0 / BENCH_INIT_ROUNDS);
+    }
+    return 0;
+}
+
+/* full detection with no cache file, then reading the one it left */
+#define BENCH_CACHE_FILE "/tmp/cpuinfo-bench.cache"
+static int bench_cache(void) {
+    probe_stats st;
+    long long start, elapsed;
+    int warm, r;
+
+    probe_cache_set_file(BENCH_CACHE_FILE);
+    for (warm = 0; warm < 2; warm++) {
+        probe_reset_stats();
+        elapsed = 0;
+        for (r = 0; r < BENCH_INIT_ROUNDS; r++) {
+            if (!warm)
+                unlink(BENCH_CACHE_FILE);
+            start = time_ns();
+            probe_begin();
+            board_init();
+            cpu_init();
+            cpu_detect_all();
+            probe_end();
+            elapsed += time_ns() - start;
+            board_cleanup();
+            cpu_cleanup();
+        }
+        probe_get_stats(&st);
+        printf("cache: %s: %lld files opened, %lld from the cache file, %0.1f us per init\n",
+            warm ? "warm" : "cold", st.opened / BENCH_INIT_ROUNDS, st.stored / BENCH_INIT_ROUNDS,
+            (double)elapsed / 1000.0 / BENCH_INIT_ROUNDS);
+    }
+    unlink(BENCH_CACHE_FILE);
+    probe_cache_set_file(NULL);
+    return 0;
+}
+
+/* several contexts on the same root, one after another and on threads */
+#define BENCH_CTX_COUNT 8
+
+typedef struct {
+    cpuinfo_ctx *ctx;
+    unsigned long long sum; /* of every tag and value */
+} ctx_job;
+
+static unsigned long long fields_sum(unsigned long long h, rpiz_fields *f) {
+    char *t, *n, *v;
+    while (f) {
+        fields_get(f, &t, &n, &v);
+        while (t && *t) h = (h ^ (unsigned char)*t++) * 0x100000001b3ULL;
+        while (v && *v) h = (h ^ (unsigned char)*v++) * 0x100000001b3ULL;
+        f = fields_next(f);
+    }
+    return h;
+}
+
+static void *ctx_detect(void *data) {
+    ctx_job *j = data;
+    cpuinfo_ctx *prev = cpuinfo_ctx_use(j->ctx);
+    cpu_detect_all();
+    j->sum = fields_sum(0xcbf29ce484222325ULL, cpu_fields());
+    j->sum = fields_sum(j->sum, cpu_topology_fields());
+    j->sum = fields_sum(j->sum, cpu_cache_fields());
+    j->sum = fields_sum(j->sum, cpu_tier_fields());
+    cpuinfo_ctx_use(prev);
+    return NULL;
+}
+
+static int bench_ctx(void) {
+    ctx_job jobs[BENCH_CTX_COUNT];
+    pthread_t threads[BENCH_CTX_COUNT];
+    long long start, elapsed[2];
+    int threaded, i, started, agree = 1;
+
+    for (threaded = 0; threaded < 2; threaded++) {
+        for (i = 0; i < BENCH_CTX_COUNT; i++) {
+            jobs[i].ctx = cpuinfo_ctx_new(util_root());
+            jobs[i].sum = 0;
+        }
+        start = time_ns();
+        if (threaded) {
+            for (started = 0; started < BENCH_CTX_COUNT; started++)
+                if (pthread_create(&threads[started], NULL, ctx_detect, &jobs[started]) != 0)
+                    break;
+            for (i = 0; i < started; i++)
+                pthread_join(threads[i], NULL);
+            /* anything that did not get a thread runs here */
+            for (i = started; i < BENCH_CTX_COUNT; i++)
+                ctx_detect(&jobs[i]);
+        } else {
+            for (i = 0; i < BENCH_CTX_COUNT; i++)
+                ctx_detect(&jobs[i]);
+        }
+        elapsed[threaded] = time_ns() - start;
+        for (i = 0; i < BENCH_CTX_COUNT; i++) {
+            if (jobs[i].sum != jobs[0].sum)
+                agree = 0;
+            cpuinfo_ctx_free(jobs[i].ctx);
+        }
+    }
+    printf("ctx: %d contexts: %0.1f us one after another, %0.1f us on %d threads, results %s\n",
+        BENCH_CTX_COUNT, (double)elapsed[0] / 1000.0, (double)elapsed[1] / 1000.0, BENCH_CTX_COUNT,
+        agree ? "agree" : "DIFFER");
+    return !agree;
+}
+
+/* per-thread fields the way the arch procs add them, then looked up */
+#define BENCH_FIELDS_THREADS 1024
+#define BENCH_FIELDS_PER_THREAD 9
+#define BENCH_FIELDS_REFRESH 100
+static int bench_fields(void) {
+    rpiz_fields *f = NULL, *nf;
+    char tag[64], name[64], *value;
+    long long start, elapsed_add, elapsed_get, elapsed_cpu;
+    int i, k, n = 0, found = 0;
+
+    start = time_ns();
+    for (i = 0; i < BENCH_FIELDS_THREADS; i++)
+        for (k = 0; k < BENCH_FIELDS_PER_THREAD; k++) {
+            sprintf(tag, "cpu.thread[%d].item%d", i, k);
+            sprintf(name, "[%d] item %d", i, k);
+            nf = fields_update_bytag(f, tag, 0, 1, name, NULL, strdup(tag));
+            if (!f) f = nf;
+            n++;
+        }
+    elapsed_add = time_ns() - start;
+
+    start = time_ns();
+    for (i = 0; i < BENCH_FIELDS_THREADS; i++)
+        for (k = 0; k < BENCH_FIELDS_PER_THREAD; k++) {
+            sprintf(tag, "cpu.thread[%d].item%d", i, k);
+            if (fields_get_bytag(f, tag, NULL, &value) && strcmp(value, tag) == 0)
+                found++;
+        }
+    elapsed_get = time_ns() - start;
+    fields_free(f);
+
+    printf("fields: %d fields: %0.1f ns/add, %0.1f ns/get by tag\n",
+        n, (double)elapsed_add / n, (double)elapsed_get / n);
+
+    /* all of this root's cpu fields */
+    cpu_init();
+    cpu_all_flags();
+    start = time_ns();
+    f = cpu_fields();
+    elapsed_cpu = time_ns() - start;
+    for (k = 0, nf = f; nf; nf = fields_next(nf))
+        k++;
+    printf("fields: cpu_fields(), %d fields in %0.1f us\n", k, (double)elapsed_cpu / 1000.0);
+
+    /* what a poller pays: re-read the live values, then text into its own buffer */
+    f = cpu_numa_fields();
+    for (k = 0, nf = f; nf; nf = fields_next(nf))
+        k++;
+    start = time_ns();
+    for (i = 0; i < BENCH_FIELDS_REFRESH; i++) {
+        fields_refresh(f);
+        for (nf = f; nf; nf = fields_next(nf))
+            fields_format(nf, name, sizeof(name));
+    }
+    elapsed_cpu = time_ns() - start;
+    printf("fields: cpu_numa_fields() refresh + format, %d fields in %0.1f us\n", k, (double)elapsed_cpu / BENCH_FIELDS_REFRESH / 1000.0);
+    cpu_cleanup();
+    return found != n;
+}
+
+/* readers of the live fields: each one pays for the sysfs reads, or
+ * copies what a background tick published */
+#define BENCH_LIVE_ROUNDS 1000
+#define BENCH_LIVE_READERS 4
+#define BENCH_LIVE_INTERVAL_MS 10
+#define BENCH_LIVE_MS 300
+
+typedef struct {
+    fields_live *live;
+    long long snaps;
+    int backwards; /* a generation older than the one before */
+} live_job;
+
+static void *live_reader(void *data) {
+    live_job *j = data;
+    fields_snap *snap = fields_snap_new(j->live);
+    long long start = time_ns(), gen, last = 0;
+    while (time_ns() - start < BENCH_LIVE_MS * 1000000LL) {
+        gen = fields_live_snapshot(j->live, snap);
+        if (gen < last)
+            j->backwards++;
+        last = gen;
+        j->snaps++;
+    }
+    fields_snap_free(snap);
+    return NULL;
+}
+
+static int bench_live(void) {
+    fields_live *live;
+    rpiz_fields *lists[2], *f;
+    live_job jobs[BENCH_LIVE_READERS];
+    pthread_t threads[BENCH_LIVE_READERS];
+    char *value;
+    long long start, elapsed, snaps = 0;
+    int i, r, n, is_live, started, backwards = 0;
+
+    cpu_init();
+    board_init();
+    lists[0] = board_fields();
+    lists[1] = cpu_numa_fields();
+    live = fields_live_new();
+    for (i = 0; i < 2; i++)
+        fields_live_add(live, lists[i]);
+    n = fields_live_count(live);
+    if (!n) {
+        printf("live: no live fields here\n");
+        fields_live_free(live);
+        board_cleanup();
+        cpu_cleanup();
+        return 0;
+    }
+
+    start = time_ns();
+    for (r = 0; r < BENCH_LIVE_ROUNDS; r++)
+        for (i = 0; i < 2; i++)
+            for (f = lists[i]; f; f = fields_next(f))
+                if (fields_info(f, NULL, NULL, &is_live) >= 0 && is_live)
+                    fields_get(f, NULL, NULL, &value);
+    elapsed = time_ns() - start;
+    printf("live: %d live fields, fields_get() on the reader: %0.1f us per pass\n",
+        n, (double)elapsed / 1000.0 / BENCH_LIVE_ROUNDS);
+
+    fields_live_start(live, BENCH_LIVE_INTERVAL_MS);
+    start = time_ns();
+    for (started = 0; started < BENCH_LIVE_READERS; started++) {
+        memset(&jobs[started], 0, sizeof(live_job));
+        jobs[started].live = live;
+        if (pthread_create(&threads[started], NULL, live_reader, &jobs[started]) != 0)
+            break;
+    }
+    for (i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+        snaps += jobs[i].snaps;
+        backwards += jobs[i].backwards;
+    }
+    elapsed = time_ns() - start;
+    fields_live_stop(live);
+    /* wall time over all the readers, so it is per snapshot only with a cpu each */
+    if (snaps)
+        printf("live: %d readers for %d ms, ticks every %d ms: %0.1f M snapshots/s, %lld ticks, %lld retries%s\n",
+            started, BENCH_LIVE_MS, BENCH_LIVE_INTERVAL_MS, snaps * 1000.0 / elapsed,
+            fields_live_ticks(live), fields_live_retries(live), backwards ? ", WENT BACKWARDS" : "");
+    fields_live_free(live);
+    board_cleanup();
+    cpu_cleanup();
+    return backwards != 0;
+}
+
+/* what each process pays for one tag: detecting it, or a segment lookup;
+ * a writer thread publishes meanwhile, as the daemon would */
+#define BENCH_SHM_NAME "/cpuinfo-bench"
+#define BENCH_SHM_ROUNDS 20
+#define BENCH_SHM_LOOKUPS 100000
+#define BENCH_SHM_INTERVAL_MS 10
+
+typedef struct {
+    cpu_shm *shm;
+    int stop;
+} shm_job;
+
+static void *shm_writer(void *data) {
+    shm_job *j = data;
+    struct timespec ts = { 0, BENCH_SHM_INTERVAL_MS * 1000000L };
+    while (!__atomic_load_n(&j->stop, __ATOMIC_ACQUIRE)) {
+        cpu_shm_publish(j->shm);
+        nanosleep(&ts, NULL);
+    }
+    return NULL;
+}
+
+static int bench_shm(void) {
+    rpiz_fields *lists[5];
+    cpu_shm *reader;
+    cpu_shm_core *cores;
+    shm_job job;
+    pthread_t thread;
+    char tag[64], buff[256], *value;
+    long long start, elapsed_detect, elapsed_find, elapsed_get, elapsed_cores;
+    int r, i, n, found = 0;
+
+    snprintf(tag, sizeof(tag), "cpu.count");
+    start = time_ns();
+    for (r = 0; r < BENCH_SHM_ROUNDS; r++) {
+        cpu_init();
+        found += fields_get_bytag(cpu_fields(), tag, NULL, &value);
+        cpu_cleanup();
+    }
+    elapsed_detect = time_ns() - start;
+
+    cpu_init();
+    lists[0] = cpu_fields();
+    lists[1] = cpu_usable_info_fields();
+    lists[2] = cpu_topology_fields();
+    lists[3] = cpu_numa_fields();
+    lists[4] = cpu_cache_fields();
+    job.shm = cpu_shm_create(BENCH_SHM_NAME, lists, 5);
+    job.stop = 0;
+    if (!job.shm) {
+        printf("shm: cannot create %s\n", BENCH_SHM_NAME);
+        cpu_cleanup();
+        return 0;
+    }
+    cpu_shm_publish(job.shm);
+    reader = cpu_shm_open(BENCH_SHM_NAME);
+    n = cpu_shm_cpus(reader);
+    cores = malloc(sizeof(cpu_shm_core) * (n + 1));
+    if (!reader || !cores || pthread_create(&thread, NULL, shm_writer, &job) != 0) {
+        free(cores);
+        cpu_shm_close(reader);
+        cpu_shm_close(job.shm);
+        cpu_cleanup();
+        return 1;
+    }
+
+    start = time_ns();
+    for (r = 0; r < BENCH_SHM_LOOKUPS; r++)
+        found += (cpu_shm_find(reader, tag) >= 0);
+    elapsed_find = time_ns() - start;
+    i = cpu_shm_find(reader, "numa.node[0].mem_free");
+    if (i < 0) i = cpu_shm_find(reader, tag);
+    start = time_ns();
+    for (r = 0; r < BENCH_SHM_LOOKUPS; r++)
+        found += (cpu_shm_get(reader, i, buff, sizeof(buff)) >= 0);
+    elapsed_get = time_ns() - start;
+    start = time_ns();
+    for (r = 0; r < BENCH_SHM_LOOKUPS; r++)
+        found += (cpu_shm_cores(reader, cores, n) == n);
+    elapsed_cores = time_ns() - start;
+
+    __atomic_store_n(&job.stop, 1, __ATOMIC_RELEASE);
+    pthread_join(thread, NULL);
+    printf("shm: %d fields, %d cpus, %lld publishes\n", cpu_shm_count(reader), n, cpu_shm_gen(reader));
+    printf("shm: %s: %0.1f us detecting, %0.1f ns to find, %0.1f ns to copy a live value, %0.1f ns for every cpu\n",
+        tag, (double)elapsed_detect / 1000.0 / BENCH_SHM_ROUNDS,
+        (double)elapsed_find / BENCH_SHM_LOOKUPS, (double)elapsed_get / BENCH_SHM_LOOKUPS,
+        (double)elapsed_cores / BENCH_SHM_LOOKUPS);
+    free(cores);
+    cpu_shm_close(reader);
+    cpu_shm_close(job.shm);
+    cpu_cleanup();
+    return found != BENCH_SHM_ROUNDS + BENCH_SHM_LOOKUPS * 3;
+}
+
+/* a monitor polling every cell of the thread table, and the same
+ * cells looked up as flat tags where there are some */
+#define BENCH_TABLE_ROUNDS 100
+static int bench_table(void) {
+    cpu_table *t;
+    rpiz_fields *f;
+    char tag[128], *value;
+    long long start, elapsed_cells, elapsed_refresh, elapsed_tags, sum = 0;
+    int r, row, col, rows, cols, cells = 0, tags = 0;
+
+    cpu_init();
+    t = cpu_thread_table();
+    rows = cpu_table_rows(t);
+    cols = cpu_table_cols(t);
+
+    start = time_ns();
+    for (r = 0; r < BENCH_TABLE_ROUNDS; r++)
+        for (col = 0; col < cols; col++)
+            for (row = 0; row < rows; row++) {
+                switch (cpu_table_col_type(t, col)) {
+                    case CELL_STR:
+                        sum += !!cpu_table_str(t, col, row);
+                        break;
+                    case CELL_INT:
+                        sum += cpu_table_int(t, col, row);
+                        break;
+                    case CELL_REG64:
+                        sum += (long long)(cpu_table_reg64(t, col, row) & 0xff);
+                        break;
+                }
+                cells++;
+            }
+    elapsed_cells = time_ns() - start;
+
+    start = time_ns();
+    cpu_table_refresh(t);
+    elapsed_refresh = time_ns() - start;
+
+    f = cpu_fields();
+    start = time_ns();
+    for (r = 0; r < BENCH_TABLE_ROUNDS; r++)
+        for (col = 0; col < cols; col++)
+            for (row = 0; row < rows; row++) {
+                sprintf(tag, "cpu.thread[%d].%s", row, cpu_table_col_name(t, col));
+                if (fields_get_bytag(f, tag, NULL, &value))
+                    tags++;
+            }
+    elapsed_tags = time_ns() - start;
+
+    printf("table: %d rows x %d cols: %0.1f ns/cell, refresh %0.1f us (sum %lld)\n",
+        rows, cols, cells ? (double)elapsed_cells / cells : 0.0, (double)elapsed_refresh / 1000.0, sum);
+    if (tags)
+        printf("table: %d flat tags: %0.1f ns/tag\n", tags / BENCH_TABLE_ROUNDS, (double)elapsed_tags / tags);
+    cpu_cleanup();
+    return 0;
+}
+
+/* the same host many times over, one thread and then the whole pool */
+#define BENCH_FLEET_HOSTS 512
+static int bench_fleet(void) {
+    const char *roots[BENCH_FLEET_HOSTS];
+    cpu_fleet *f;
+    int i, pass, jobs = par_jobs(), known[2] = { 0, 0 };
+
+    for (i = 0; i < BENCH_FLEET_HOSTS; i++)
+        roots[i] = util_root();
+    for (pass = 0; pass < 2; pass++) {
+        par_set_jobs(pass ? jobs : 1);
+        f = cpu_fleet_new();
+        if (!f) break;
+        known[pass] = cpu_fleet_scan(f, roots, BENCH_FLEET_HOSTS);
+        printf("fleet: %d hosts on %d thread%s: %0.1f hosts/s, %d recognized\n",
+            cpu_fleet_hosts(f), par_jobs(), (par_jobs() > 1) ? "s" : "",
+            cpu_fleet_hosts_per_sec(f), known[pass]);
+        cpu_fleet_free(f);
+    }
+    par_set_jobs(jobs);
+    return known[0] != known[1];
+}
+
+/* one field, in process and as a whole "cpuinfo --get" run */
+#define BENCH_GET_ROUNDS 20
+static int bench_get(void) {
+    static char tag[] = "cpu.count";
+    char exe[512], *argv[6], *value;
+    probe_stats st;
+    long long start, elapsed;
+    posix_spawn_file_actions_t fa;
+    pid_t pid;
+    int r, n = 0, status;
+
+    for (r = 0; r < 2; r++) {
+        probe_reset_stats();
+        start = time_ns();
+        cpu_init();
+        if (r) cpu_detect_all();
+        fields_get_bytag(cpu_fields(), tag, NULL, &value);
+        printf("get: %s%s = %s in %0.1f us", tag, r ? " after full detection" : "", value,
+            (double)(time_ns() - start) / 1000.0);
+        cpu_cleanup();
+        probe_get_stats(&st);
+        printf(", %lld files opened, %lld bytes read\n", st.opened, st.bytes);
+    }
+
+    r = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+    if (r <= 0) return 0;
+    exe[r] = 0;
+    argv[n++] = exe;
+    if (*util_root()) {
+        argv[n++] = "--root";
+        argv[n++] = (char*)util_root();
+    }
+    argv[n++] = "--get";
+    argv[n++] = tag;
+    argv[n] = NULL;
+    posix_spawn_file_actions_init(&fa);
+    posix_spawn_file_actions_addopen(&fa, 1, "/dev/null", O_WRONLY, 0);
+    start = time_ns();
+    for (r = 0; r < BENCH_GET_ROUNDS; r++) {
+        if (posix_spawn(&pid, exe, &fa, NULL, argv, environ) != 0)
+            break;
+        waitpid(pid, &status, 0);
+    }
+    elapsed = time_ns() - start;
+    posix_spawn_file_actions_destroy(&fa);
+    if (r)
+        printf("get: cpuinfo --get %s: %0.1f us per run, end to end\n", tag,
+            (double)elapsed / 1000.0 / r);
+    return 0;
+}
+
+static struct {
+    const char *name;
+    int (*func)(void);
+} bench_tab[] = {
+    { "kv", bench_kv },
+    { "strlist", bench_strlist },
+    { "feature", bench_feature },
+    { "freq", bench_freq },
+    { "batch", bench_batch },
+    { "init", bench_init },
+    { "probe", bench_probe },
+    { "get", bench_get },
+    { "cache", bench_cache },
+    { "ctx", bench_ctx },
+    { "fields", bench_fields },
+    { "live", bench_live },
+    { "shm", bench_shm },
+    { "table", bench_table },
+    { "fleet", bench_fleet },
+    { "gemm", eigen_cache_bench },
+    { NULL, NULL },
+};
+
+int bench_run(const char *name) {
+    int i = 0, ret = 0, found = 0;
+    while(bench_tab[i].name != NULL) {
+        if (!name || strcmp(name, "all") == 0 || strcmp(name, bench_tab[i].name) == 0) {
+            ret |= bench_tab[i].func();
+            found = 1;
+        }
+        i++;
+    }
+    if (!found) {
+        printf("unknown benchmark: %s\n", name);
+        return 1;
+    }
+    return ret;
+}
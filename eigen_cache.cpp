@@ -0,0 +1,171 @@
+/*
+ * rpiz - https://github.com/bp0/rpiz
+ * Copyright (C) 2017  Burt P. <pburt0@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+#include <time.h>
+
+#include "Eigen/Core"
+#include "Eigen/Dense"
+
+#include "eigen_cache.h"
+
+using namespace Eigen;
+
+/* L3 falls back to L2, for the many ARM parts without one */
+static int sizes_for_cpu(cpu_caches *c, int cpu, long *l1, long *l2, long *l3) {
+    *l1 = cpu_caches_size(c, cpu, 1);
+    *l2 = cpu_caches_size(c, cpu, 2);
+    *l3 = cpu_caches_size(c, cpu, 3);
+    if (!*l1 || !*l2)
+        return 0;
+    if (!*l3)
+        *l3 = *l2;
+    return 1;
+}
+
+int eigen_cache_apply_cpu(cpu_caches *c, int cpu) {
+    long l1, l2, l3;
+    if (!sizes_for_cpu(c, cpu, &l1, &l2, &l3))
+        return 0;
+    eigen_cache_set(l1, l2, l3);
+    return 1;
+}
+
+int eigen_cache_apply_mask(cpu_caches *c, const cpu_mask *cpus) {
+    long l1, l2, l3, m1 = 0, m2 = 0, m3 = 0;
+    int cpu;
+    CPUMASK_FOR_EACH(cpu, cpus) {
+        if (!sizes_for_cpu(c, cpu, &l1, &l2, &l3))
+            continue;
+        if (!m1 || l1 < m1) m1 = l1;
+        if (!m2 || l2 < m2) m2 = l2;
+        if (!m3 || l3 < m3) m3 = l3;
+    }
+    if (!m1)
+        return 0;
+    eigen_cache_set(m1, m2, m3);
+    return 1;
+}
+
+int eigen_cache_apply_affinity(cpu_caches *c) {
+    cpu_set_t set;
+    cpu_mask *m;
+    int i, ret;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0)
+        return eigen_cache_apply_cpu(c, sched_getcpu());
+    m = cpumask_new(CPU_SETSIZE);
+    if (!m)
+        return 0;
+    for (i = 0; i < CPU_SETSIZE; i++)
+        if (CPU_ISSET(i, &set))
+            cpumask_set(m, i);
+    ret = eigen_cache_apply_mask(c, m);
+    cpumask_free(m);
+    return ret;
+}
+
+void eigen_cache_get(long *l1, long *l2, long *l3) {
+    std::ptrdiff_t a, b, c;
+    internal::manage_caching_sizes(GetAction, &a, &b, &c);
+    if (l1) *l1 = a;
+    if (l2) *l2 = b;
+    if (l3) *l3 = c;
+}
+
+void eigen_cache_set(long l1, long l2, long l3) {
+    setCpuCacheSizes(l1, l2, l3);
+}
+
+/* about 2^26 multiply-adds per timed run, so 512 is not 4000x slower */
+#define BENCH_GEMM_WORK (1LL << 26)
+#define BENCH_GEMM_REPEAT 9
+
+static long long time_ns(void) {
+    struct timespec tv;
+    clock_gettime(CLOCK_MONOTONIC, &tv);
+    return (long long)tv.tv_sec * 1000000000LL + tv.tv_nsec;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* the dynamic sizes main.cpp uses, fixed size products do not use the
+ * cache sizes at all */
+static double bench_gemm_once(const MatrixXd &d1, const MatrixXd &d2, MatrixXd &d3, int rounds) {
+    long long start;
+    int i;
+
+    d3.noalias() = d1 * d2 * d1.transpose(); /* warm up */
+    start = time_ns();
+    for (i = 0; i < rounds; i++)
+        d3.noalias() = d1 * d2 * d1.transpose();
+    return (double)(time_ns() - start) / rounds / 1000.0;
+}
+
+/* alternate the two configurations so neither gets a warmer cache or
+ * clock, and report the median of each */
+static void bench_gemm_dim(int dim, const long def[3], const long sys[3]) {
+    MatrixXd d1 = MatrixXd::Random(dim, dim);
+    MatrixXd d2 = MatrixXd::Random(dim, dim);
+    MatrixXd d3(dim, dim);
+    double t_def[BENCH_GEMM_REPEAT], t_sys[BENCH_GEMM_REPEAT];
+    int i, rounds = BENCH_GEMM_WORK / ((long long)dim * dim * dim * 2);
+
+    if (rounds < 3)
+        rounds = 3;
+
+    for (i = 0; i < BENCH_GEMM_REPEAT; i++) {
+        eigen_cache_set(def[0], def[1], def[2]);
+        t_def[i] = bench_gemm_once(d1, d2, d3, rounds);
+        eigen_cache_set(sys[0], sys[1], sys[2]);
+        t_sys[i] = bench_gemm_once(d1, d2, d3, rounds);
+    }
+    qsort(t_def, BENCH_GEMM_REPEAT, sizeof(double), cmp_double);
+    qsort(t_sys, BENCH_GEMM_REPEAT, sizeof(double), cmp_double);
+    printf("gemm:   %dx%d ABAt: default %0.1f us, sysfs %0.1f us (median of %d)\n",
+        dim, dim, t_def[BENCH_GEMM_REPEAT / 2], t_sys[BENCH_GEMM_REPEAT / 2], BENCH_GEMM_REPEAT);
+}
+
+int eigen_cache_bench(void) {
+    static const int dims[] = { 32, 132, 512 };
+    cpu_caches *c = cpu_caches_new();
+    long def[3], sys[3];
+    unsigned int i;
+
+    eigen_cache_get(&def[0], &def[1], &def[2]);
+    if (!eigen_cache_apply_affinity(c)) {
+        printf("gemm: no cache sizes in sysfs\n");
+        cpu_caches_free(c);
+        return 1;
+    }
+    eigen_cache_get(&sys[0], &sys[1], &sys[2]);
+    printf("gemm: eigen default (L1 %ldK, L2 %ldK, L3 %ldK)\n", def[0] / 1024, def[1] / 1024, def[2] / 1024);
+    printf("gemm: sysfs (L1 %ldK, L2 %ldK, L3 %ldK)\n", sys[0] / 1024, sys[1] / 1024, sys[2] / 1024);
+    for (i = 0; i < sizeof(dims) / sizeof(dims[0]); i++)
+        bench_gemm_dim(dims[i], def, sys);
+    eigen_cache_set(def[0], def[1], def[2]);
+    cpu_caches_free(c);
+    return 0;
+}
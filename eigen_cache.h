@@ -0,0 +1,51 @@
+/*
+ * rpiz - https://github.com/bp0/rpiz
+ * Copyright (C) 2017  Burt P. <pburt0@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+#ifndef _EIGEN_CACHE_H_
+#define _EIGEN_CACHE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "cpu_cache.h"
+
+/* Eigen only knows how to query x86 CPUID for its GEMM blocking sizes and
+ * falls back to built-in defaults elsewhere. These pass the sysfs cache
+ * sizes to Eigen::setCpuCacheSizes() instead.
+ *
+ * Eigen keeps the sizes in one process-wide static, not per thread, so
+ * re-applying after pinning a thread only helps when the threads running
+ * products share a cluster. eigen_cache_apply_affinity() uses the smallest
+ * sizes over the calling thread's affinity mask, which is safe for any cpu
+ * the thread may land on. All return 1 if sizes were applied. */
+int eigen_cache_apply_cpu(cpu_caches *, int cpu);
+int eigen_cache_apply_mask(cpu_caches *, const cpu_mask *cpus);
+int eigen_cache_apply_affinity(cpu_caches *);
+void eigen_cache_get(long *l1, long *l2, long *l3);
+void eigen_cache_set(long l1, long l2, long l3);
+
+int eigen_cache_bench(void); /* cpuinfo --bench gemm */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
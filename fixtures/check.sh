@@ -0,0 +1,92 @@
+#!/bin/sh
+# Replays the captured trees next to this script through cpuinfo --root
+# and compares each field with what the tree was made to show.
+# Run from the top of the repo after make, or with CPUINFO=path.
+
+CPUINFO=${CPUINFO:-./out/cpuinfo}
+DIR=$(dirname "$0")
+fail=0
+
+run() { # args; reuses the last output when the args repeat
+    if [ "$*" != "$ran" ]; then
+        ran="$*"
+        out=$("$CPUINFO" "$@" 2>&1)
+    fi
+}
+
+line() { # tag; prints "Name = value" of the first "[tag] Name = value"
+    printf '%s\n' "$out" | awk -v t="[$1] " 'index($0, t) == 1 { print substr($0, length(t) + 1); exit }'
+}
+
+check() { # tree tag expected-value
+    run --root "$DIR/$1"
+    got=$(line "$2")
+    got=${got#*= }
+    if [ "$got" = "$3" ]; then
+        echo "ok   $1 $2"
+    else
+        echo "FAIL $1 $2: got \"$got\", expected \"$3\""
+        fail=1
+    fi
+}
+
+check_fleet() { # tag expected "Name = value"
+    run --fleet "$DIR/fleet"
+    got=$(line "$1")
+    if [ "$got" = "$2" ]; then
+        echo "ok   fleet $1"
+    else
+        echo "FAIL fleet $1: got \"$got\", expected \"$2\""
+        fail=1
+    fi
+}
+
+# two packages of two cores with two threads each; core ids repeat per
+# package and cpus 0-3 are the first threads
+check topo2x2x2 topo.desc "2 packages, 2 dies, 2 clusters, 4 cores, 8 threads"
+check topo2x2x2 topo.packages "2"
+check topo2x2x2 topo.dies "2"
+check topo2x2x2 topo.clusters "2"
+check topo2x2x2 topo.cores "4"
+check topo2x2x2 topo.threads "8"
+
+# two nodes with their own meminfo; the /proc/meminfo next to them
+# covers the whole machine and must not be used for node0
+check numa2 numa.count "2"
+check numa2 "numa.node[0].cpus" "0-1"
+check numa2 "numa.node[1].cpus" "2-3"
+check numa2 "numa.node[0].distance" "10 21"
+check numa2 "numa.node[1].distance" "21 10"
+check numa2 "numa.node[0].mem_total" "1000000 kB"
+check numa2 "numa.node[0].mem_free" "200000 kB"
+check numa2 "numa.node[1].mem_total" "2048000 kB"
+check numa2 "numa.node[1].mem_free" "1536000 kB"
+
+# cgroup v1, quota and cpuset set at two levels, the nested one is tighter
+check cgroup_v1 usable.cgroup "v1 /docker/abc"
+check cgroup_v1 usable.cpus "2-5"
+check cgroup_v1 usable.count "4"
+check cgroup_v1 usable.quota "2.50 cpus (250000/100000 us)"
+check cgroup_v1 usable.parallelism "3"
+
+# cgroup v2, the nested cpu.max is "max" so the parent's quota applies
+check cgroup_v2 usable.cgroup "v2 /user.slice/app.scope"
+check cgroup_v2 usable.cpus "0-2,6"
+check cgroup_v2 usable.count "4"
+check cgroup_v2 usable.quota "2.00 cpus (200000/100000 us)"
+check cgroup_v2 usable.parallelism "2"
+
+# four captured hosts: a Pi-style arm, two x86 that differ by avx512f,
+# and a riscv
+check_fleet fleet.hosts "Hosts = 4"
+check_fleet fleet.unknown "Not Recognized = 0"
+check_fleet fleet.arch.arm "arm = 1 hosts (25.0%)"
+check_fleet fleet.arch.x86 "x86 = 2 hosts (50.0%)"
+check_fleet fleet.arch.riscv "riscv = 1 hosts (25.0%)"
+check_fleet "fleet.model[0]" "Intel(R) Xeon(R) Gold 6130 CPU @ 2.10GHz = 2 hosts (50.0%)"
+check_fleet "fleet.decoded_name[1]" "ARM Cortex-A53 r0p4 (AArch64) = 2 threads (25.0%)"
+check_fleet "fleet.x86.flag[0]" "avx = 2 hosts (100.0%)"
+check_fleet "fleet.x86.flag[11]" "avx512f = 1 hosts (50.0%)"
+check_fleet "fleet.riscv.flag[6]" "RV64 = 1 hosts (100.0%)"
+
+exit $fail
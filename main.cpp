@@ -1,9 +1,12 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sched.h> // for sched_setaffinity()
 #include <unistd.h> // for getpid()
 #include <sys/types.h>
 #include <sched.h>
 #include <time.h>
+#include <signal.h>
 using namespace std;
 
 #include "Eigen/Core"
@@ -16,18 +19,135 @@ extern "C" {
 #endif
 #include "board.h"
 #include "cpu.h"
+#include "bench.h"
+#include "util.h"
+#include "eigen_cache.h"
+#include "cpu_place.h"
+#include "cpu_fleet.h"
+#include "cpu_shm.h"
 #ifdef __cplusplus
 }
 #endif
 
+/* one worker on the fastest physical core we are allowed to use */
 void set_cpu() {
-    cpu_set_t cpu_set;
-    CPU_ZERO(&cpu_set);
-    CPU_SET(0, &cpu_set);
-    sched_setaffinity(getpid(), sizeof(cpu_set_t), &cpu_set);
+    place_plan *plan = place_plan_new(cpu_topology(), cpu_tier_info(), 1,
+        PLACE_SPREAD | PLACE_NO_SMT | PLACE_PERFORMANCE | PLACE_AFFINITY);
+    place_apply_worker(plan, 0);
+    place_plan_free(plan);
     printf("sched_getcpu = %d\n", sched_getcpu());
 }
 
+static rpiz_fields *board_fields_once() {
+    static int done = 0;
+    if (!done) {
+        board_init();
+        done = 1;
+    }
+    return board_fields();
+}
+
+/* where each tag prefix comes from, so --get reads no more than it needs */
+static const struct {
+    const char *prefix;
+    rpiz_fields *(*fields)(void);
+} field_src[] = {
+    { "board.",   board_fields_once },
+    { "summary.", board_fields_once },
+    { "summary.", cpu_fields },
+    { "cpu.",     cpu_fields },
+    { "usable.",  cpu_usable_info_fields },
+    { "topo.",    cpu_topology_fields },
+    { "tiers.",   cpu_tier_fields },
+    { "numa.",    cpu_numa_fields },
+    { "cache.",   cpu_cache_fields },
+};
+
+/* prints the value of each tag, one per line, returns 1 if any is unknown */
+static int get_tags(char **tags, int count) {
+    char *value;
+    int i, k, found, ret = 0;
+    for (i = 0; i < count; i++) {
+        found = 0;
+        for (k = 0; !found && k < (int)(sizeof(field_src) / sizeof(field_src[0])); k++) {
+            if (strncmp(tags[i], field_src[k].prefix, strlen(field_src[k].prefix)) != 0)
+                continue;
+            found = fields_get_bytag(field_src[k].fields(), tags[i], NULL, &value);
+        }
+        if (found)
+            printf("%s\n", value ? value : "");
+        else {
+            fprintf(stderr, "unknown field: %s\n", tags[i]);
+            ret = 1;
+        }
+    }
+    return ret;
+}
+
+/* the same tags from a daemon's segment, nothing is detected here */
+static int get_tags_shm(const char *name, char **tags, int count) {
+    cpu_shm *shm = cpu_shm_open(name);
+    char value[4096];
+    int i, ret = 0;
+    if (!shm) {
+        fprintf(stderr, "no telemetry segment: %s\n", name ? name : CPU_SHM_NAME);
+        return 1;
+    }
+    for (i = 0; i < count; i++) {
+        if (cpu_shm_find(shm, tags[i]) < 0) {
+            fprintf(stderr, "unknown field: %s\n", tags[i]);
+            ret = 1;
+        } else if (cpu_shm_get_bytag(shm, tags[i], value, sizeof(value)) >= 0)
+            printf("%s\n", value);
+        else
+            printf("\n");
+    }
+    cpu_shm_close(shm);
+    return ret;
+}
+
+static volatile sig_atomic_t daemon_stop = 0;
+static void daemon_signal(int sig) {
+    (void)sig;
+    daemon_stop = 1;
+}
+
+/* publishes every interval_ms until SIGINT or SIGTERM */
+static int run_daemon(const char *name, int interval_ms) {
+    rpiz_fields *lists[] = {
+        board_fields(), cpu_fields(), cpu_usable_info_fields(), cpu_topology_fields(),
+        cpu_tier_fields(), cpu_numa_fields(), cpu_cache_fields(),
+    };
+    struct sigaction sa;
+    struct timespec next;
+    long long period = interval_ms * 1000000LL;
+    cpu_shm *shm;
+
+    shm = cpu_shm_create(name, lists, sizeof(lists) / sizeof(lists[0]));
+    if (!shm) {
+        fprintf(stderr, "cannot create telemetry segment: %s\n", name ? name : CPU_SHM_NAME);
+        return 1;
+    }
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = daemon_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (!daemon_stop) {
+        cpu_shm_publish(shm);
+        next.tv_sec += period / 1000000000LL;
+        next.tv_nsec += period % 1000000000LL;
+        while (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        /* a signal ends the sleep early, then the loop */
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+    }
+    cpu_shm_close(shm);
+    return 0;
+}
+
 static int64_t time_us() {
     struct timespec tv;
     clock_gettime(CLOCK_MONOTONIC, &tv); // CLOCK_REALTIME CLOCK_MONOTONIC
@@ -53,16 +173,99 @@ double calculate_pi(int accuracy) {
 int main(int argc, char* argv[])
 {
     rpiz_fields *bf, *pf;
-    board_init();
-    cpu_init();
+    const char *root = NULL, *shm_name = NULL;
+    probe_stats st;
+    char *get[64];
+    int i, stats = 0, gets = 0, daemon = 0, interval_ms = 1000;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--root") == 0 && i + 1 < argc)
+            root = argv[++i];
+        else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc)
+            par_set_jobs(atoi(argv[++i]));
+        else if (strcmp(argv[i], "--stats") == 0)
+            stats = 1;
+        else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc)
+            probe_cache_set_file(argv[++i]);
+        else if (strcmp(argv[i], "--get") == 0 && i + 1 < argc) {
+            if (gets < (int)(sizeof(get) / sizeof(get[0])))
+                get[gets++] = argv[i + 1];
+            i++;
+        }
+        else if (strcmp(argv[i], "--daemon") == 0)
+            daemon = 1;
+        else if (strcmp(argv[i], "--interval") == 0 && i + 1 < argc)
+            interval_ms = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--shm") == 0 && i + 1 < argc)
+            shm_name = argv[++i];
+        else if (strcmp(argv[i], "--fleet") == 0 && i + 1 < argc) {
+            /* every subdirectory a captured host, only the summary is printed */
+            cpu_fleet *fleet = cpu_fleet_new();
+            if (!fleet) return 1;
+            cpu_fleet_scan_dir(fleet, argv[++i]);
+            fields_dump(cpu_fleet_fields(fleet));
+            i = !cpu_fleet_hosts(fleet);
+            cpu_fleet_free(fleet);
+            return i;
+        }
+        else if (strcmp(argv[i], "--bench") == 0) {
+            util_set_root(root);
+            return bench_run((i + 1 < argc) ? argv[i + 1] : NULL);
+        }
+    }
+
+    if (gets && shm_name && !daemon)
+        return get_tags_shm(shm_name, get, gets);
+
+    if (gets) {
+        /* only the parts these tags come from are read */
+        util_set_root(root);
+        cpu_init();
+        probe_begin();
+        i = get_tags(get, gets);
+        probe_end();
+        board_cleanup();
+        cpu_cleanup();
+        return i;
+    }
+
+    /* one probe session, so board and cpu detection share what they read */
+    util_set_root(root);
+    probe_begin();
+    board_init_root(root);
+    cpu_init_root(root);
+    cpu_detect_all();
+    probe_end();
+    if (daemon) {
+        i = run_daemon(shm_name, (interval_ms > 0) ? interval_ms : 1000);
+        board_cleanup();
+        cpu_cleanup();
+        return i;
+    }
+    if (stats) {
+        probe_get_stats(&st);
+        printf("probe: %lld files opened, %lld bytes read, %lld reads shared, %lld from the cache file\n",
+            st.opened, st.bytes, st.hits, st.stored);
+    }
     bf = board_fields();
     fields_dump(bf);
     pf = cpu_fields();
     fields_dump(pf);
-    board_cleanup();
-    cpu_cleanup();
+    fields_dump(cpu_usable_info_fields());
+    fields_dump(cpu_topology_fields());
+    fields_dump(cpu_tier_fields());
+    fields_dump(cpu_numa_fields());
+    fields_dump(cpu_cache_fields());
 
     set_cpu();
+    /* after pinning, the sizes for the cpus this thread can run on */
+    if (eigen_cache_apply_affinity(cpu_cache_info())) {
+        long l1, l2, l3;
+        eigen_cache_get(&l1, &l2, &l3);
+        printf("eigen cache sizes: L1 %ldK, L2 %ldK, L3 %ldK\n", l1 / 1024, l2 / 1024, l3 / 1024);
+    }
+    board_cleanup();
+    cpu_cleanup();
 #ifdef __CUDACC__
     printf("__CUDACC__\n");
 #endif
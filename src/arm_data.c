@@ -21,6 +21,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <pthread.h>
 #include "arm_data.h"
 
 #ifndef _
@@ -38,46 +39,8 @@
 static struct {
     char *name, *meaning;
 } tab_flag_meaning[] = {
-    /* arm/hw_cap */
-    { "swp",      N_("SWP instruction (atomic read-modify-write)") },
-    { "half",     N_("Half-word loads and stores") },
-    { "thumb",    N_("Thumb (16-bit instruction set)") },
-    { "26bit",    N_("26-Bit Model (Processor status register folded into program counter)") },
-    { "fastmult", N_("32x32->64-bit multiplication") },
-    { "fpa",      N_("Floating point accelerator") },
-    { "vfp",      N_("VFP (early SIMD vector floating point instructions)") },
-    { "edsp",     N_("DSP extensions (the 'e' variant of the ARM9 CPUs, and all others above)") },
-    { "java",     N_("Jazelle (Java bytecode accelerator)") },
-    { "iwmmxt",   N_("SIMD instructions similar to Intel MMX") },
-    { "crunch",   N_("MaverickCrunch coprocessor (if kernel support enabled)") },
-    { "thumbee",  N_("ThumbEE") },
-    { "neon",     N_("Advanced SIMD/NEON on AArch32") },
-    { "evtstrm",  N_("kernel event stream using generic architected timer") },
-    { "vfpv3",    N_("VFP version 3") },
-    { "vfpv3d16", N_("VFP version 3 with 16 D-registers") },
-    { "vfpv4",    N_("VFP version 4 with fast context switching") },
-    { "vfpd32",   N_("VFP with 32 D-registers") },
-    { "tls",      N_("TLS register") },
-    { "idiva",    N_("SDIV and UDIV hardware division in ARM mode") },
-    { "idivt",    N_("SDIV and UDIV hardware division in Thumb mode") },
-    { "lpae",     N_("40-bit Large Physical Address Extension") },
-    /* arm/hw_cap2 */
-    { "pmull",    N_("64x64->128-bit F2m multiplication (arch>8)") },
-    { "aes",      N_("Crypto:AES (arch>8)") },
-    { "sha1",     N_("Crypto:SHA1 (arch>8)") },
-    { "sha2",     N_("Crypto:SHA2 (arch>8)") },
-    { "crc32",    N_("CRC32 checksum instructions (arch>8)") },
-    /* arm64/hw_cap */
-    { "fp",       NULL },
-    { "asimd",    N_("Advanced SIMD/NEON on AArch64 (arch>8)") },
-    { "atomics",  NULL },
-    { "fphp",     NULL },
-    { "asimdhp",  NULL },
-    { "cpuid",    NULL },
-    { "asimdrdm", NULL },
-    { "jscvt",    NULL },
-    { "fcma",     NULL },
-    { "lrcpc",    NULL },
+#define ARM_FLAG_ENTRY(id, name, meaning) { name, meaning },
+    ARM_FLAG_TABLE(ARM_FLAG_ENTRY)
     { NULL, NULL }
 };
 
@@ -135,18 +98,28 @@ static struct {
 static char all_flags[1024] = "";
 
 #define APPEND_FLAG(f) strcat(all_flags, f); strcat(all_flags, " ");
-const char *arm_flag_list() {
-    int i = 0, built = 0;
-    built = strlen(all_flags);
-    if (!built) {
-        while(tab_flag_meaning[i].name != NULL) {
-            APPEND_FLAG(tab_flag_meaning[i].name);
-            i++;
-        }
+static pthread_once_t all_flags_once = PTHREAD_ONCE_INIT;
+
+static void build_all_flags(void) {
+    int i = 0;
+    while(tab_flag_meaning[i].name != NULL) {
+        APPEND_FLAG(tab_flag_meaning[i].name);
+        i++;
     }
+}
+
+/* built once, never changed after */
+const char *arm_flag_list() {
+    pthread_once(&all_flags_once, build_all_flags);
     return all_flags;
 }
 
+const char *arm_flag_name(int id) {
+    if (id >= 0 && id < ARM_FLAG_N_KNOWN)
+        return tab_flag_meaning[id].name;
+    return NULL;
+}
+
 const char *arm_flag_meaning(const char *flag) {
     int i = 0;
     if (flag)
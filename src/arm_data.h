@@ -21,6 +21,14 @@
 #ifndef _ARMDATA_H_
 #define _ARMDATA_H_
 
+#include "arm_flags.h"
+
+#define ARM_FLAG_ENUM(id, name, meaning) ARM_FLAG_##id,
+typedef enum {
+    ARM_FLAG_TABLE(ARM_FLAG_ENUM)
+    ARM_FLAG_N_KNOWN
+} arm_flag_id;
+
 /* table lookups */
 const char *arm_implementer(const char *code);
 const char *arm_part(const char *imp_code, const char *part_code);
@@ -36,5 +44,6 @@ char *arm_decoded_name(
 /* cpu flags from /proc/cpuinfo */
 const char *arm_flag_list(void);                  /* list of all known flags */
 const char *arm_flag_meaning(const char *flag);  /* lookup flag meaning */
+const char *arm_flag_name(int id);               /* name of a known arm_flag_id */
 
 #endif
@@ -0,0 +1,68 @@
+/*
+ * rpiz - https://github.com/bp0/rpiz
+ * Copyright (C) 2017  Burt P. <pburt0@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+#ifndef _ARMFLAGS_H_
+#define _ARMFLAGS_H_
+
+/* flags known to arm_data.c; the order defines the arm_flag_id values
+ * X(id, name, meaning) */
+#define ARM_FLAG_TABLE(X) \
+    /* arm/hw_cap */ \
+    X(SWP,      "swp",      N_("SWP instruction (atomic read-modify-write)")) \
+    X(HALF,     "half",     N_("Half-word loads and stores")) \
+    X(THUMB,    "thumb",    N_("Thumb (16-bit instruction set)")) \
+    X(26BIT,    "26bit",    N_("26-Bit Model (Processor status register folded into program counter)")) \
+    X(FASTMULT, "fastmult", N_("32x32->64-bit multiplication")) \
+    X(FPA,      "fpa",      N_("Floating point accelerator")) \
+    X(VFP,      "vfp",      N_("VFP (early SIMD vector floating point instructions)")) \
+    X(EDSP,     "edsp",     N_("DSP extensions (the 'e' variant of the ARM9 CPUs, and all others above)")) \
+    X(JAVA,     "java",     N_("Jazelle (Java bytecode accelerator)")) \
+    X(IWMMXT,   "iwmmxt",   N_("SIMD instructions similar to Intel MMX")) \
+    X(CRUNCH,   "crunch",   N_("MaverickCrunch coprocessor (if kernel support enabled)")) \
+    X(THUMBEE,  "thumbee",  N_("ThumbEE")) \
+    X(NEON,     "neon",     N_("Advanced SIMD/NEON on AArch32")) \
+    X(EVTSTRM,  "evtstrm",  N_("kernel event stream using generic architected timer")) \
+    X(VFPV3,    "vfpv3",    N_("VFP version 3")) \
+    X(VFPV3D16, "vfpv3d16", N_("VFP version 3 with 16 D-registers")) \
+    X(VFPV4,    "vfpv4",    N_("VFP version 4 with fast context switching")) \
+    X(VFPD32,   "vfpd32",   N_("VFP with 32 D-registers")) \
+    X(TLS,      "tls",      N_("TLS register")) \
+    X(IDIVA,    "idiva",    N_("SDIV and UDIV hardware division in ARM mode")) \
+    X(IDIVT,    "idivt",    N_("SDIV and UDIV hardware division in Thumb mode")) \
+    X(LPAE,     "lpae",     N_("40-bit Large Physical Address Extension")) \
+    /* arm/hw_cap2 */ \
+    X(PMULL,    "pmull",    N_("64x64->128-bit F2m multiplication (arch>8)")) \
+    X(AES,      "aes",      N_("Crypto:AES (arch>8)")) \
+    X(SHA1,     "sha1",     N_("Crypto:SHA1 (arch>8)")) \
+    X(SHA2,     "sha2",     N_("Crypto:SHA2 (arch>8)")) \
+    X(CRC32,    "crc32",    N_("CRC32 checksum instructions (arch>8)")) \
+    /* arm64/hw_cap */ \
+    X(FP,       "fp",       NULL) \
+    X(ASIMD,    "asimd",    N_("Advanced SIMD/NEON on AArch64 (arch>8)")) \
+    X(ATOMICS,  "atomics",  NULL) \
+    X(FPHP,     "fphp",     NULL) \
+    X(ASIMDHP,  "asimdhp",  NULL) \
+    X(CPUID,    "cpuid",    NULL) \
+    X(ASIMDRDM, "asimdrdm", NULL) \
+    X(JSCVT,    "jscvt",    NULL) \
+    X(FCMA,     "fcma",     NULL) \
+    X(LRCPC,    "lrcpc",    NULL)
+
+#endif
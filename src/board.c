@@ -19,6 +19,8 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
+#include "util.h"
 #include "board.h"
 #include "board_dt.h"
 #include "board_dmi.h"
@@ -32,44 +34,88 @@ typedef enum {
     BT_N_TYPES,
 } board_type;
 
-struct {
+struct board_state {
     board_type type;
     dt_board *dt;
     rpi_board *rpi;
     dmi_board *dmi;
-} board;
+};
+
+static board_state default_board;
+static __thread board_state *cur_board = NULL;
+
+static board_state *cur(void) {
+    return cur_board ? cur_board : &default_board;
+}
+
+board_state *board_state_new(void) {
+    board_state *s = malloc(sizeof(board_state));
+    if (s)
+        memset(s, 0, sizeof(*s));
+    return s;
+}
+
+void board_state_free(board_state *s) {
+    board_state *prev;
+    if (s && s != &default_board) {
+        prev = board_state_use(s);
+        board_cleanup();
+        board_state_use(prev == s ? NULL : prev);
+        free(s);
+    }
+}
+
+board_state *board_state_use(board_state *s) {
+    board_state *prev = cur_board;
+    cur_board = s;
+    return prev;
+}
 
 int board_init() {
+    board_state *b = cur();
+    probe_begin();
     if (dt_board_check()) {
         if (rpi_board_check()) {
-            board.rpi = rpi_board_new();
-            board.type = BT_RPI;
+            b->rpi = rpi_board_new();
+            b->type = BT_RPI;
         } else {
-            board.dt = dt_board_new();
-            board.type = BT_DT;
+            b->dt = dt_board_new();
+            b->type = BT_DT;
         }
     } else if (dmi_board_check()) {
-        board.dmi = dmi_board_new();
-        board.type = BT_DMI;
+        b->dmi = dmi_board_new();
+        b->type = BT_DMI;
     } else
-        board.type = BT_UNKNOWN;
+        b->type = BT_UNKNOWN;
+    probe_end();
     return 1;
 }
 
+int board_init_root(const char *root) {
+    util_set_root(root);
+    return board_init();
+}
+
 void board_cleanup() {
-    if (board.dt) dt_board_free(board.dt);
-    if (board.rpi) rpi_board_free(board.rpi);
-    if (board.dmi) dmi_board_free(board.dmi);
+    board_state *b = cur();
+    if (b->dt) dt_board_free(b->dt);
+    if (b->rpi) rpi_board_free(b->rpi);
+    if (b->dmi) dmi_board_free(b->dmi);
+    b->dt = NULL;
+    b->rpi = NULL;
+    b->dmi = NULL;
+    b->type = BT_UNKNOWN;
 }
 
 rpiz_fields *board_fields() {
-    switch (board.type) {
+    board_state *b = cur();
+    switch (b->type) {
         case (BT_DT):
-            return dt_board_fields(board.dt);
+            return dt_board_fields(b->dt);
         case (BT_RPI):
-            return rpi_board_fields(board.rpi);
+            return rpi_board_fields(b->rpi);
         case (BT_DMI):
-            return dmi_board_fields(board.dmi);
+            return dmi_board_fields(b->dmi);
         default:
             return NULL;
     }
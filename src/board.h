@@ -23,7 +23,15 @@
 
 #include "fields.h"
 
+/* Works on the calling thread's current board_state, or a shared
+ * default one, see cpu_state in cpu.h */
+typedef struct board_state board_state;
+board_state *board_state_new(void);
+void board_state_free(board_state *); /* does board_cleanup() */
+board_state *board_state_use(board_state *); /* for this thread, NULL for the default, returns the previous */
+
 int board_init(void);
+int board_init_root(const char *root); /* read /proc and /sys below root, see util_set_root() */
 void board_cleanup(void);
 
 rpiz_fields *board_fields(void);
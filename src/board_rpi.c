@@ -134,33 +134,24 @@ static int rpi_find_board(const char *r_code) {
     return 0;
 }
 
-#ifndef PROC_CPUINFO
-#define PROC_CPUINFO "/proc/cpuinfo"
-#endif
-
 #define CHECK_KV(k, v)  \
-    if (strncmp(k, key, (strlen(k) < strlen(key)) ? strlen(k) : strlen(key)) == 0) { \
-        if (b->v != NULL) free(b->v);                                                \
-        b->v = malloc(strlen(value) + 1);                                      \
-        if (b->v) strcpy(b->v, value); }
+    if (KV_IS(&key, k)) {                                \
+        if (b->v != NULL) free(b->v);                    \
+        b->v = malloc(value.len + 1);                    \
+        if (b->v) kv_slice_copy(b->v, value.len + 1, &value); }
 
 static int rpi_get_cpuinfo_data(rpi_board *b) {
-    char *cpuinfo;
-    kv_scan *kv; char *key, *value;
-
-    cpuinfo = get_file_contents(PROC_CPUINFO);
-    if (!cpuinfo) return 0;
-
-    kv = kv_new(cpuinfo);
-    if (kv) {
-        while( kv_next(kv, &key, &value) ) {
-            CHECK_KV("Revision", revision);
-            CHECK_KV("Serial",   serial);
-            CHECK_KV("Hardware", soc);
-        }
+    kv_scan *kv; kv_slice key, value;
+
+    kv = kv_new_file(PROC_CPUINFO);
+    if (!kv) return 0;
+
+    while( kv_next(kv, &key, &value) ) {
+        CHECK_KV("Revision", revision);
+        CHECK_KV("Serial",   serial);
+        CHECK_KV("Hardware", soc);
     }
     kv_free(kv);
-    free(cpuinfo);
     return 1;
 }
 
@@ -292,46 +283,37 @@ int rpi_board_overvolt(rpi_board *s) {
 }
 
 float rpi_soc_temp() {
-    char *tmp = NULL;
+    char tmp[32];
     float temp = 0.0f;
-    tmp = get_file_contents("/sys/class/thermal/thermal_zone0/temp");
-    if (tmp != NULL)
+    /* read every time the live field is, so into the stack */
+    if (get_file_buff("/sys/class/thermal/thermal_zone0/temp", tmp, sizeof(tmp)) > 0)
         temp = (float)atoi(tmp);
     if (temp)
         temp /= 1000.0f;
-    free(tmp);
     return temp;
 }
 
-static char* rpi_soc_temp_str(void *s) {
-    float t = rpi_soc_temp();
-    char *buff;
-    s = s; /* avoid a warning */
-    buff = malloc(128);
-    if (buff)
-        snprintf(buff, 127, "%0.2f'C", t);
-    return buff;
+static int rpi_soc_temp_value(void *s, rpiz_value *v) {
+    v->d = rpi_soc_temp();
+    return 1;
 }
 
-static char* rpi_board_overvolt_str(rpi_board *s) {
-    char *buff = NULL;
-    if (s) {
-        buff = malloc(128);
-        if (buff)
-            snprintf(buff, 127, "%s", (rpi_board_overvolt(s)) ? "yes (warranty void!)" : "never" );
-    }
-    return buff;
+static const char* rpi_board_overvolt_str(rpi_board *s) {
+    if (s)
+        return (rpi_board_overvolt(s)) ? "yes (warranty void!)" : "never";
+    return NULL;
 }
 
 #define ADDFIELD(t, l, o, n, f) fields_update_bytag(s->fields, t, l, o, n, (rpiz_fields_get_func)f, (void*)s)
 #define ADDFIELDSTR(t, l, o, n, str) fields_update_bytag(s->fields, t, l, o, n, NULL, (void*)str)
+#define ADDFIELDV(t, l, n, y, f) fields_update_value_bytag(s->fields, t, l, n, y, (rpiz_fields_value_func)f, (void*)s)
 rpiz_fields *rpi_board_fields(rpi_board *s) {
     if (s) {
         if (!s->fields) {
             /* first insert creates */
             s->fields =
             ADDFIELD("summary.board_name",  0, 0, "Board Name", rpi_board_desc );
-            ADDFIELD("summary.rpi_temp",    1, 1, "SOC Temp",   rpi_soc_temp_str );
+            ADDFIELDV("summary.rpi_temp",   1, "SOC Temp", FIELD_CELSIUS, rpi_soc_temp_value );
             ADDFIELD("board.rpi_name",      0, 0, "Model", rpi_board_desc );
             ADDFIELD("board.rpi_intro",     0, 0, "Introduction", rpi_board_intro );
             ADDFIELD("board.rpi_mfgby",     0, 0, "Manufacturer", rpi_board_mfgby );
@@ -341,8 +323,8 @@ rpiz_fields *rpi_board_fields(rpi_board *s) {
             ADDFIELDSTR("board.rpi_soc",    0, 0, "SOC (reported)", s->soc );
             ADDFIELD("board.rpi_rcode",     0, 0, "RCode", rpi_board_rcode );
             ADDFIELD("board.rpi_serial",    0, 0, "Serial Number", rpi_board_serial );
-            ADDFIELD("board.rpi_overvolt",  0, 1, "Overvolt", rpi_board_overvolt_str );
-            ADDFIELD("board.rpi_temp",      1, 1, "SOC Temp",   rpi_soc_temp_str );
+            ADDFIELD("board.rpi_overvolt",  0, 0, "Overvolt", rpi_board_overvolt_str );
+            ADDFIELDV("board.rpi_temp",     1, "SOC Temp", FIELD_CELSIUS, rpi_soc_temp_value );
         }
         return s->fields;
     }
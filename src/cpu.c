@@ -19,6 +19,8 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
+#include "util.h"
 #include "cpu.h"
 #include "cpu_arm.h"
 #include "arm_data.h"
@@ -26,6 +28,11 @@
 #include "x86_data.h"
 #include "cpu_riscv.h"
 #include "riscv_data.h"
+#include "cpu_cache.h"
+#include "cpu_topo.h"
+#include "cpu_numa.h"
+#include "cpu_usable.h"
+#include "cpu_tiers.h"
 
 typedef enum {
     PT_UNKNOWN = 0,
@@ -35,80 +42,298 @@ typedef enum {
     PT_N_TYPES,
 } cpu_type;
 
-struct {
+struct cpu_state {
     cpu_type type;
     union {
         arm_proc *arm;
         x86_proc *x86;
         riscv_proc *riscv;
     };
-} cpu;
+    cpu_caches *caches;
+    cpu_topo *topo;
+    numa_nodes *numa;
+    cpu_usable *usable;
+    cpu_tiers *tiers;
+    int loaded; /* NEED_* parts read */
+};
 
-int cpu_init() {
-    cpu.type = PT_UNKNOWN;
+static cpu_state default_cpu;
+static __thread cpu_state *cur_cpu = NULL;
+
+static cpu_state *cur(void) {
+    return cur_cpu ? cur_cpu : &default_cpu;
+}
+
+cpu_state *cpu_state_new(void) {
+    cpu_state *s = malloc(sizeof(cpu_state));
+    if (s)
+        memset(s, 0, sizeof(*s));
+    return s;
+}
 
+void cpu_state_free(cpu_state *s) {
+    cpu_state *prev;
+    if (s && s != &default_cpu) {
+        prev = cpu_state_use(s);
+        cpu_cleanup();
+        cpu_state_use(prev == s ? NULL : prev);
+        free(s);
+    }
+}
+
+cpu_state *cpu_state_use(cpu_state *s) {
+    cpu_state *prev = cur_cpu;
+    cur_cpu = s;
+    return prev;
+}
+
+/* each part is read the first time something asks for it */
+#define NEED_PROC   0x01
+#define NEED_CACHES 0x02
+#define NEED_TOPO   0x04
+#define NEED_NUMA   0x08
+#define NEED_USABLE 0x10
+#define NEED_TIERS  0x20
+
+static const char *type_names[PT_N_TYPES] = { NULL, "arm", "x86", "riscv" };
+
+/* the parser for the architecture this was built for */
+static cpu_type build_type(void) {
 #if defined(__arm__) || defined(__aarch64__)
-    cpu.arm = arm_proc_new();
-    cpu.type = PT_ARM;
+    return PT_ARM;
+#elif defined(__i386__) || defined(__x86_64__)
+    return PT_X86;
+#elif defined(__riscv32__) || defined(__riscv64__)
+    return PT_RISCV;
+#else
+    return PT_UNKNOWN;
 #endif
+}
 
-#if defined(__i386__) || defined(__x86_64__)
-    cpu.x86 = x86_proc_new();
-    cpu.type = PT_X86;
-#endif
+/* the parser for a cpuinfo, by keys only one architecture writes */
+static cpu_type guess_type(void) {
+    kv_scan *kv; kv_slice key, value;
+    cpu_type t = PT_UNKNOWN;
+    kv = kv_new_file(PROC_CPUINFO);
+    if (kv) {
+        while (t == PT_UNKNOWN && kv_next(kv, &key, &value) ) {
+            if (KV_IS(&key, "vendor_id") || KV_IS(&key, "cpu family"))
+                t = PT_X86;
+            else if (KV_IS(&key, "CPU implementer") || KV_IS(&key, "Features"))
+                t = PT_ARM;
+            else if (KV_IS(&key, "isa") || KV_IS(&key, "hart"))
+                t = PT_RISCV;
+        }
+        kv_free(kv);
+    }
+    return t;
+}
 
-#if defined(__riscv32__) || defined(__riscv64__)
-    cpu.riscv = riscv_proc_new();
-    cpu.type = PT_RISCV;
-#endif
+static void load_proc(void *data) {
+    cpu_state *c = data;
+    /* the guess and the parser read cpuinfo once between them */
+    probe_begin();
+    if (c->type == PT_UNKNOWN)
+        c->type = guess_type();
+    if (c->type == PT_UNKNOWN)
+        c->type = build_type();
+    switch (c->type) {
+        case (PT_ARM):
+            c->arm = arm_proc_new();
+            break;
+        case (PT_X86):
+            c->x86 = x86_proc_new();
+            break;
+        case (PT_RISCV):
+            c->riscv = riscv_proc_new();
+            break;
+        default:
+            break;
+    }
+    probe_end();
+}
+
+static void load_caches(void *data) { ((cpu_state*)data)->caches = cpu_caches_new(); }
+static void load_topo(void *data) { ((cpu_state*)data)->topo = cpu_topo_new(); }
+static void load_numa(void *data) { ((cpu_state*)data)->numa = numa_nodes_new(); }
+static void load_usable(void *data) { ((cpu_state*)data)->usable = cpu_usable_new(); }
+static void load_tiers(void *data) { ((cpu_state*)data)->tiers = cpu_tiers_new(); }
+
+#define NEED(bit, func) lazy_once(&c->loaded, bit, func, c)
 
+int cpu_init() {
+    cpu_state *c = cur();
+    c->loaded = 0;
+    /* a captured tree can be from any architecture, so it is
+     * told by its cpuinfo when the processor is first read */
+    if (*util_root())
+        c->type = PT_UNKNOWN;
+    else
+        c->type = build_type();
     return 1;
 }
 
+int cpu_set_arch(const char *arch) {
+    cpu_state *c = cur();
+    int t;
+    if (c->loaded & NEED_PROC)
+        return 0;
+    if (!arch) {
+        c->type = PT_UNKNOWN;
+        return 1;
+    }
+    for (t = PT_UNKNOWN + 1; t < PT_N_TYPES; t++)
+        if (strcmp(arch, type_names[t]) == 0) {
+            c->type = t;
+            return 1;
+        }
+    return 0;
+}
+
+const char *cpu_arch(void) {
+    cpu_state *c = cur();
+    NEED(NEED_PROC, load_proc);
+    return type_names[c->type];
+}
+
+void cpu_detect_all() {
+    cpu_state *c = cur();
+    probe_begin();
+    cpu_all_flags();
+    switch (c->type) {
+        case (PT_ARM):
+            arm_proc_desc(c->arm);
+            break;
+        case (PT_X86):
+            x86_proc_desc(c->x86);
+            break;
+        case (PT_RISCV):
+            riscv_proc_desc(c->riscv);
+            break;
+        default:
+            break;
+    }
+    cpu_cache_info();
+    cpu_topology();
+    cpu_numa();
+    cpu_usable_info();
+    cpu_tier_info();
+    probe_end();
+}
+
+int cpu_init_root(const char *root) {
+    util_set_root(root);
+    return cpu_init();
+}
+
 void cpu_cleanup() {
-    switch (cpu.type) {
+    cpu_state *c = cur();
+    switch (c->type) {
         case (PT_ARM):
-            if (cpu.arm) arm_proc_free(cpu.arm);
+            if (c->arm) arm_proc_free(c->arm);
             break;
         case (PT_X86):
-            if (cpu.x86) x86_proc_free(cpu.x86);
+            if (c->x86) x86_proc_free(c->x86);
             break;
         case (PT_RISCV):
-            if (cpu.riscv) riscv_proc_free(cpu.riscv);
+            if (c->riscv) riscv_proc_free(c->riscv);
             break;
         default:
             break;
     }
+    c->x86 = NULL;
+    cpu_caches_free(c->caches);
+    c->caches = NULL;
+    cpu_topo_free(c->topo);
+    c->topo = NULL;
+    numa_nodes_free(c->numa);
+    c->numa = NULL;
+    cpu_usable_free(c->usable);
+    c->usable = NULL;
+    cpu_tiers_free(c->tiers);
+    c->tiers = NULL;
+    c->loaded = 0;
 }
 
 const char *cpu_all_flags(void) {
-    switch (cpu.type) {
+    cpu_state *c = cur();
+    NEED(NEED_PROC, load_proc);
+    switch (c->type) {
         case (PT_ARM):
-            return arm_flag_list();
+            return arm_proc_flag_list(c->arm);
         case (PT_X86):
-            return x86_flag_list();
+            return x86_proc_flag_list(c->x86);
         case (PT_RISCV):
-            return riscv_ext_list();
+            return riscv_proc_flag_list(c->riscv);
         default:
             return NULL;
     }
 }
 
 int cpu_has_flag(const char *flag) {
-    switch (cpu.type) {
+    cpu_state *c = cur();
+    NEED(NEED_PROC, load_proc);
+    switch (c->type) {
+        case (PT_ARM):
+            return arm_proc_has_flag(c->arm, flag);
+        case (PT_X86):
+            return x86_proc_has_flag(c->x86, flag);
+        case (PT_RISCV):
+            return riscv_proc_has_flag(c->riscv, flag);
+        default:
+            return 0;
+    }
+}
+
+int cpu_feature_id(const char *flag) {
+    cpu_state *c = cur();
+    NEED(NEED_PROC, load_proc);
+    switch (c->type) {
+        case (PT_ARM):
+            return arm_proc_flag_id(c->arm, flag);
+        case (PT_X86):
+            return x86_proc_flag_id(c->x86, flag);
+        case (PT_RISCV):
+            return riscv_proc_flag_id(c->riscv, flag);
+        default:
+            return -1;
+    }
+}
+
+int cpu_has_feature(int id) {
+    cpu_state *c = cur();
+    NEED(NEED_PROC, load_proc);
+    switch (c->type) {
+        case (PT_ARM):
+            return arm_proc_has_feature(c->arm, id);
+        case (PT_X86):
+            return x86_proc_has_feature(c->x86, id);
+        case (PT_RISCV):
+            return riscv_proc_has_feature(c->riscv, id);
+        default:
+            return 0;
+    }
+}
+
+int cpu_thread_has_feature(int thread, int id) {
+    cpu_state *c = cur();
+    NEED(NEED_PROC, load_proc);
+    switch (c->type) {
         case (PT_ARM):
-            return arm_proc_has_flag(cpu.arm, flag);
+            return arm_proc_core_has_feature(c->arm, thread, id);
         case (PT_X86):
-            return x86_proc_has_flag(cpu.x86, flag);
+            return x86_proc_thread_has_feature(c->x86, thread, id);
         case (PT_RISCV):
-            return riscv_proc_has_flag(cpu.riscv, flag);
+            return riscv_proc_core_has_feature(c->riscv, thread, id);
         default:
             return 0;
     }
 }
 
 const char *cpu_flag_meaning(const char *flag) {
-    switch (cpu.type) {
+    cpu_state *c = cur();
+    NEED(NEED_PROC, load_proc);
+    switch (c->type) {
         case (PT_ARM):
             return arm_flag_meaning(flag);
         case (PT_X86):
@@ -120,16 +345,157 @@ const char *cpu_flag_meaning(const char *flag) {
     }
 }
 
+int cpu_threads(void) {
+    cpu_state *c = cur();
+    NEED(NEED_PROC, load_proc);
+    switch (c->type) {
+        case (PT_ARM):
+            return arm_proc_cores(c->arm);
+        case (PT_X86):
+            return x86_proc_threads(c->x86);
+        case (PT_RISCV):
+            return riscv_proc_cores(c->riscv);
+        default:
+            return 0;
+    }
+}
+
+const char *cpu_thread_model_name(int thread) {
+    cpu_state *c = cur();
+    NEED(NEED_PROC, load_proc);
+    switch (c->type) {
+        case (PT_ARM):
+            return arm_proc_core_model_name(c->arm, thread);
+        case (PT_X86):
+            return x86_proc_thread_model_name(c->x86, thread);
+        case (PT_RISCV):
+            return riscv_proc_core_model_name(c->riscv, thread);
+        default:
+            return NULL;
+    }
+}
+
+const char *cpu_thread_decoded_name(int thread) {
+    cpu_state *c = cur();
+    NEED(NEED_PROC, load_proc);
+    switch (c->type) {
+        case (PT_ARM):
+            return arm_proc_core_decoded_name(c->arm, thread);
+        default:
+            return NULL;
+    }
+}
+
+int cpu_thread_khz_max(int thread) {
+    cpu_state *c = cur();
+    NEED(NEED_PROC, load_proc);
+    switch (c->type) {
+        case (PT_ARM):
+            return arm_proc_core_khz_max(c->arm, thread);
+        case (PT_X86):
+            return x86_proc_thread_khz_max(c->x86, thread);
+        case (PT_RISCV):
+            return riscv_proc_core_khz_max(c->riscv, thread);
+        default:
+            return 0;
+    }
+}
+
+cpu_table *cpu_thread_table(void) {
+    cpu_state *c = cur();
+    NEED(NEED_PROC, load_proc);
+    switch (c->type) {
+        case (PT_ARM):
+            return arm_proc_table(c->arm);
+        case (PT_X86):
+            return x86_proc_table(c->x86);
+        case (PT_RISCV):
+            return riscv_proc_table(c->riscv);
+        default:
+            return NULL;
+    }
+}
+
 rpiz_fields *cpu_fields() {
-    switch (cpu.type) {
+    cpu_state *c = cur();
+    NEED(NEED_PROC, load_proc);
+    switch (c->type) {
         case (PT_ARM):
-            return arm_proc_fields(cpu.arm);
+            return arm_proc_fields(c->arm);
         case (PT_X86):
-            return x86_proc_fields(cpu.x86);
+            return x86_proc_fields(c->x86);
         case (PT_RISCV):
-            return riscv_proc_fields(cpu.riscv);
+            return riscv_proc_fields(c->riscv);
         default:
             return NULL;
     }
     return NULL;
 }
+
+cpu_caches *cpu_cache_info() {
+    cpu_state *c = cur();
+    NEED(NEED_CACHES, load_caches);
+    return c->caches;
+}
+
+rpiz_fields *cpu_cache_fields() {
+    cpu_state *c = cur();
+    NEED(NEED_CACHES, load_caches);
+    return cpu_caches_fields(c->caches);
+}
+
+cpu_topo *cpu_topology() {
+    cpu_state *c = cur();
+    NEED(NEED_TOPO, load_topo);
+    return c->topo;
+}
+
+rpiz_fields *cpu_topology_fields() {
+    cpu_state *c = cur();
+    NEED(NEED_TOPO, load_topo);
+    return cpu_topo_fields(c->topo);
+}
+
+numa_nodes *cpu_numa() {
+    cpu_state *c = cur();
+    NEED(NEED_NUMA, load_numa);
+    return c->numa;
+}
+
+rpiz_fields *cpu_numa_fields() {
+    cpu_state *c = cur();
+    NEED(NEED_NUMA, load_numa);
+    return numa_nodes_fields(c->numa);
+}
+
+cpu_usable *cpu_usable_info() {
+    cpu_state *c = cur();
+    NEED(NEED_USABLE, load_usable);
+    return c->usable;
+}
+
+int cpu_parallelism() {
+    cpu_state *c = cur();
+    NEED(NEED_USABLE, load_usable);
+    if (c->usable)
+        return c->usable->parallelism;
+    return 1;
+}
+
+rpiz_fields *cpu_usable_info_fields() {
+    cpu_state *c = cur();
+    NEED(NEED_USABLE, load_usable);
+    return cpu_usable_fields(c->usable);
+}
+
+cpu_tiers *cpu_tier_info() {
+    cpu_state *c = cur();
+    NEED(NEED_TIERS, load_tiers);
+    return c->tiers;
+}
+
+rpiz_fields *cpu_tier_fields() {
+    cpu_state *c = cur();
+    NEED(NEED_TIERS, load_tiers);
+    return cpu_tiers_fields(c->tiers);
+}
@@ -22,14 +22,68 @@
 #define _CPU_H_
 
 #include "fields.h"
+#include "cpu_table.h"
+#include "cpu_cache.h"
+#include "cpu_topo.h"
+#include "cpu_numa.h"
+#include "cpu_usable.h"
+#include "cpu_tiers.h"
 
+/* Everything below works on the calling thread's current cpu_state, or
+ * a shared default one. A state owns all it reads, so threads using
+ * different states do not share anything. */
+typedef struct cpu_state cpu_state;
+cpu_state *cpu_state_new(void);
+void cpu_state_free(cpu_state *); /* does cpu_cleanup() */
+cpu_state *cpu_state_use(cpu_state *); /* for this thread, NULL for the default, returns the previous */
+
+/* cpu_init() reads nothing, each part is read on first use */
 int cpu_init(void);
+int cpu_init_root(const char *root); /* read /proc and /sys below root, see util_set_root() */
+void cpu_detect_all(void); /* read every part now, sharing one probe session */
 void cpu_cleanup(void);
 
+/* "arm", "x86" or "riscv". The parser is the build architecture's,
+ * unless a sysroot is set, then it is picked from that cpuinfo.
+ * cpu_set_arch() forces one (NULL to pick from cpuinfo), only after
+ * cpu_init() and before the processor is read, returns 0 otherwise. */
+int cpu_set_arch(const char *arch);
+const char *cpu_arch(void); /* NULL if not known */
+
 const char *cpu_all_flags(void);
 int cpu_has_flag(const char *flag); /* returns core count with flag */
 const char *cpu_flag_meaning(const char *flag);
 
+/* feature ids are the arch enum (x86_flag_id, arm_flag_id, riscv_ext_id),
+ * or a dynamic id from cpu_feature_id() for flags not in the tables */
+int cpu_feature_id(const char *flag); /* -1 if no core has flag */
+int cpu_has_feature(int id); /* returns core count with feature */
+int cpu_thread_has_feature(int thread, int id);
+
+int cpu_threads(void);
+const char *cpu_thread_model_name(int thread);
+const char *cpu_thread_decoded_name(int thread); /* NULL where the arch has no decoder */
+int cpu_thread_khz_max(int thread);
+
+/* the same per-thread data as columns, see cpu_table.h; the
+ * cpu.thread[N].* fields are rendered from it */
+cpu_table *cpu_thread_table(void);
 rpiz_fields *cpu_fields(void);
 
+cpu_caches *cpu_cache_info(void); /* enumerated once, on first use */
+rpiz_fields *cpu_cache_fields(void);
+
+cpu_topo *cpu_topology(void); /* built once, on first use */
+rpiz_fields *cpu_topology_fields(void);
+
+numa_nodes *cpu_numa(void); /* read once, on first use */
+rpiz_fields *cpu_numa_fields(void);
+
+cpu_usable *cpu_usable_info(void); /* read once, on first use */
+int cpu_parallelism(void); /* threads worth running, see cpu_usable */
+rpiz_fields *cpu_usable_info_fields(void);
+
+cpu_tiers *cpu_tier_info(void); /* read once, on first use */
+rpiz_fields *cpu_tier_fields(void);
+
 #endif
@@ -23,16 +23,16 @@
 #include <string.h>
 #include "util.h"
 #include "cpu_arm.h"
-
-#define MAX_CORES 128
+#include "cpu_table.h"
 
 static int search_for_flag(char *flags, const char *flag) {
-    char *p = strstr(flags, flag);
+    char *p;
     int l = strlen(flag);
     int front = 0, back = 0;
     //DEBUG printf("search_for_flag( %x, \"%s\")\n", flags, flag);
-    if (strlen(flag) == 0 || strchr(flag, ' ') )
+    if (!flags || strlen(flag) == 0 || strchr(flag, ' ') )
         return 0;
+    p = strstr(flags, flag);
     while (p) {
         if (p == flags) front = 1;
         else if (*(p - 1) == ' ') front = 1;
@@ -46,9 +46,6 @@ static int search_for_flag(char *flags, const char *flag) {
 }
 
 typedef struct {
-    int id;
-    int cpukhz_min, cpukhz_max, cpukhz_cur;
-
     unsigned long long reg_midr_el1;
     unsigned long long reg_revidr_el1;
 
@@ -75,35 +72,88 @@ struct arm_proc {
     cpu_string_list *cpu_revision;
     cpu_string_list *cpukhz_max_str;
 
-    cpu_string_list *each_flag;
+    char *all_flags; /* the known flags, then any others seen, after LAZY_FLAGS */
+    cpu_flagset *flagset; /* arm_flag_id bits, then unknown flags */
 
     char cpu_name[256];
     char *cpu_desc;
     int max_khz;
+    /* per-core storage is sized to the cpuinfo: the arm_core
+     * array holds the strings, while ids and frequencies are kept
+     * as contiguous columns */
     int core_count;
-    arm_core cores[MAX_CORES];
+    int core_alloc;
+    arm_core *cores;
+    int *core_id;
+    int *khz_min, *khz_max, *khz_cur;
 
+    int lazy; /* LAZY_* parts done */
     rpiz_fields *fields;
+    cpu_table *table;
 };
 
-#define CHECK_FOR(k) (strncmp(k, key, (strlen(k) < strlen(key)) ? strlen(k) : strlen(key)) == 0)
-#define GET_STR(k, s) if (CHECK_FOR(k)) { p->cores[core].s = strlist_add(p->s, value); continue; }
+/* parts not needed to count cores, made on first use */
+#define LAZY_FREQ  0x01
+#define LAZY_DESC  0x02
+#define LAZY_FLAGS 0x04
+
+#define CHECK_FOR(k) KV_IS(&key, k)
+#define GET_STR(k, s) if (CHECK_FOR(k)) { p->cores[core].s = strlist_add_n(p->s, value.str, value.len); continue; }
 #define FIN_PROC() if (core >= 0) if (!p->cores[core].model_name) { p->cores[core].model_name = strlist_add(p->model_name, rep_pname); }
 
 #define REDUP(f) if(p->cores[di].f && !p->cores[i].f) { p->cores[i].f = strlist_add(p->f, p->cores[di].f); }
 
-#ifndef PROC_CPUINFO
-#define PROC_CPUINFO "/proc/cpuinfo"
-#endif
+#define RESIZE_COL(c, n) { void *tmp = realloc(p->c, sizeof(*p->c) * (n)); if (!tmp) return 0; p->c = tmp; }
+static int resize_cores(arm_proc *p, int n) {
+    if (n < 1) n = 1;
+    RESIZE_COL(cores, n);
+    RESIZE_COL(core_id, n);
+    RESIZE_COL(khz_min, n);
+    RESIZE_COL(khz_max, n);
+    RESIZE_COL(khz_cur, n);
+    p->core_alloc = n;
+    return 1;
+}
+
+static int new_core(arm_proc *p, int core, int id) {
+    int n = p->core_alloc ? p->core_alloc : 8;
+    if (core >= p->core_alloc) {
+        while (n <= core) n *= 2;
+        if (!resize_cores(p, n))
+            return 0;
+    }
+    memset(&p->cores[core], 0, sizeof(arm_core));
+    p->core_id[core] = id;
+    p->khz_min[core] = p->khz_max[core] = p->khz_cur[core] = 0;
+    return 1;
+}
+
+typedef struct {
+    arm_proc *p;
+    char **dn;
+} decode_job;
+
+/* only reads p, the strings are interned afterwards in core order */
+static void decode_core(void *data, int i) {
+    decode_job *j = data;
+    j->dn[i] = arm_decoded_name(
+            j->p->cores[i].cpu_implementer, j->p->cores[i].cpu_part,
+            j->p->cores[i].cpu_variant, j->p->cores[i].cpu_revision,
+            j->p->cores[i].cpu_architecture, j->p->cores[i].model_name);
+}
 
 static int scan_cpu(arm_proc* p) {
-    kv_scan *kv; char *key, *value;
+    kv_scan *kv; kv_slice key, value;
     int core = -1;
     int i, di;
     char rep_pname[256] = "";
-    char tmp_maxfreq[128] = "";
-    char *tmp_dn = NULL;
-    char *tmp_reg = NULL;
+    static const char *id_regs[] = {
+        "regs/identification/midr_el1",
+        "regs/identification/revidr_el1",
+    };
+    read_req *regs;
+    decode_job job;
+    char **dn;
 
     if (!p) return 0;
 
@@ -111,20 +161,20 @@ static int scan_cpu(arm_proc* p) {
     if (kv) {
         while( kv_next(kv, &key, &value) ) {
             if (CHECK_FOR("Processor")) {
-                strcpy(rep_pname, value);
+                kv_slice_copy(rep_pname, sizeof(rep_pname), &value);
                 continue;
             }
 
             if (CHECK_FOR("Hardware")) {
-                strcpy(p->cpu_name, value);
+                kv_slice_copy(p->cpu_name, sizeof(p->cpu_name), &value);
                 continue;
             }
 
             if (CHECK_FOR("processor")) {
                 FIN_PROC();
+                if (!new_core(p, core + 1, atoi(value.str)))
+                    break;
                 core++;
-                memset(&p->cores[core], 0, sizeof(arm_core));
-                p->cores[core].id = atoi(value);
                 continue;
             }
 
@@ -134,9 +184,9 @@ static int scan_cpu(arm_proc* p) {
                      || CHECK_FOR("flags") ) {
                     /* this cpuinfo doesn't provide processor : n
                      * there is prolly only one core */
+                    if (!new_core(p, core + 1, 0))
+                        break;
                     core++;
-                    memset(&p->cores[core], 0, sizeof(arm_core));
-                    p->cores[core].id = 0;
                 }
             }
             if (core >= 0) {
@@ -160,6 +210,8 @@ static int scan_cpu(arm_proc* p) {
         return 0;
 
     p->core_count = core + 1;
+    /* trim to size */
+    resize_cores(p, p->core_count);
 
     /* re-duplicate missing data for /proc/cpuinfo variant that de-duplicated it */
     di = p->core_count - 1;
@@ -177,34 +229,44 @@ static int scan_cpu(arm_proc* p) {
     }
 
     /* data not from /proc/cpuinfo */
+    regs = read_cpu_batch(p->core_id, p->core_count, id_regs, 2);
+    dn = calloc(p->core_count + 1, sizeof(char*));
+    if (dn) {
+        job.p = p;
+        job.dn = dn;
+        par_for(p->core_count, decode_core, &job);
+    }
     for (i = 0; i < p->core_count; i++) {
         /* id registers (aarch64) */
-        tmp_reg = get_cpu_str("regs/identification/midr_el1", p->cores[i].id);
-        if (tmp_reg) p->cores[i].reg_midr_el1 = strtoll(tmp_reg, NULL, 0);
-        free(tmp_reg);
-        tmp_reg = get_cpu_str("regs/identification/revidr_el1", p->cores[i].id);
-        if (tmp_reg) p->cores[i].reg_revidr_el1 = strtoll(tmp_reg, NULL, 0);
-        free(tmp_reg);
-
-        /* decoded names */
-        tmp_dn = arm_decoded_name(
-                p->cores[i].cpu_implementer, p->cores[i].cpu_part,
-                p->cores[i].cpu_variant, p->cores[i].cpu_revision,
-                p->cores[i].cpu_architecture, p->cores[i].model_name);
-        p->cores[i].decoded_name = strlist_add(p->decoded_name, tmp_dn);
-        free(tmp_dn); tmp_dn = NULL;
-
-        /* freq */
-        get_cpu_freq(p->cores[i].id, &p->cores[i].cpukhz_min, &p->cores[i].cpukhz_max, &p->cores[i].cpukhz_cur);
-        sprintf(tmp_maxfreq, "%d", p->cores[i].cpukhz_max);
-        p->cores[i].cpukhz_max_str = strlist_add(p->cpukhz_max_str, tmp_maxfreq);
-        if (p->cores[i].cpukhz_max > p->max_khz)
-            p->max_khz = p->cores[i].cpukhz_max;
+        if (regs && regs[i * 2].len > 0)
+            p->cores[i].reg_midr_el1 = strtoll(regs[i * 2].buff, NULL, 0);
+        if (regs && regs[i * 2 + 1].len > 0)
+            p->cores[i].reg_revidr_el1 = strtoll(regs[i * 2 + 1].buff, NULL, 0);
+
+        /* decoded names, interned in core order */
+        if (dn) {
+            p->cores[i].decoded_name = strlist_add(p->decoded_name, dn[i]);
+            free(dn[i]);
+        }
     }
 
+    free(regs);
+    free(dn);
     return 1;
 }
 
+static void scan_freq(arm_proc *p) {
+    char tmp_maxfreq[128];
+    int i;
+    get_cpu_freq_batch(p->core_id, p->core_count, p->khz_min, p->khz_max, p->khz_cur);
+    for (i = 0; i < p->core_count; i++) {
+        sprintf(tmp_maxfreq, "%d", p->khz_max[i]);
+        p->cores[i].cpukhz_max_str = strlist_add(p->cpukhz_max_str, tmp_maxfreq);
+        if (p->khz_max[i] > p->max_khz)
+            p->max_khz = p->khz_max[i];
+    }
+}
+
 static char *gen_cpu_desc(arm_proc *p) {
     char *ret = NULL;
     char tmp[1024];
@@ -233,43 +295,96 @@ static char *gen_cpu_desc(arm_proc *p) {
     return ret;
 }
 
-#define APPEND_FLAG(f) strcat(all_flags, f); strcat(all_flags, " ");
+/* list + flag + " " */
+static char *append_flag(char *list, const char *flag) {
+    int l = strlen(list), fl = strlen(flag);
+    char *tmp = realloc(list, l + fl + 2);
+    if (!tmp) return list;
+    memcpy(tmp + l, flag, fl);
+    tmp[l + fl] = ' ';
+    tmp[l + fl + 1] = 0;
+    return tmp;
+}
+
+#define APPEND_FLAG(f) s->all_flags = append_flag(s->all_flags, f);
 static void process_flags(arm_proc *s) {
     char flag[16] = "";
-    char *all_flags; /* arm_data.c: static char all_flags[1024] */
     char *cur, *next;
-    int added_count = 0, i;
-    if (!s) return;
-
-    all_flags = (char*)arm_flag_list();
-    for(i = 0; i < s->flags->count; i++) {
-        if (s->flags->strs[i].str) {
-            cur = s->flags->strs[i].str;
-            next = strchr(cur, ' '); if (!next) next = strchr(cur, '\0');
-            while(next) {
-                if (next-cur <= 15) {
-                    memset(flag, 0, 16);
-                    strncpy(flag, cur, next-cur);
-                    if (strlen(flag) > 0) {
-                        /* add it to the string list, copy the flag string's ref_count */
-                        strlist_add_w(s->each_flag, flag, s->flags->strs[i].ref_count);
-
-                        /* add it to the list of known all flags, if it isn't there */
-                        if (!search_for_flag(all_flags, flag)) {
-                            APPEND_FLAG(flag);
-                            added_count++;
+    unsigned long long *sbits = NULL;
+    int added_count = 0, i, id, pass, n, flen, words = 0;
+    if (!s || !s->flagset) return;
+
+    s->all_flags = strdup(arm_flag_list());
+    if (!s->all_flags) return;
+
+    /* pass 0 gives every flag a bit, pass 1 sets the bits
+     * for each distinct flags string */
+    for(pass = 0; pass < 2; pass++) {
+        if (pass == 1) {
+            if (!flagset_alloc(s->flagset, s->core_count))
+                return;
+            words = s->flagset->words;
+            sbits = calloc((size_t)s->flags->count * words + 1, sizeof(unsigned long long));
+            if (!sbits) return;
+        }
+        for(i = 0; i < s->flags->count; i++) {
+            if (s->flags->strs[i].str) {
+                cur = s->flags->strs[i].str;
+                next = strchr(cur, ' '); if (!next) next = strchr(cur, '\0');
+                while(next) {
+                    flen = next-cur;
+                    if (flen > 0 && flen <= 15) {
+                        memcpy(flag, cur, flen);
+                        flag[flen] = 0;
+                        if (pass == 0) {
+                            n = s->flagset->ids->count;
+                            id = flagset_id(s->flagset, flag, flen, 1);
+                            /* add it to the list of known all flags, if it isn't there */
+                            if (id == n && !search_for_flag(s->all_flags, flag)) {
+                                APPEND_FLAG(flag);
+                                added_count++;
+                            }
+                        } else {
+                            id = flagset_id(s->flagset, flag, flen, 0);
+                            if (id >= 0)
+                                FLAGSET_BIT_SET(sbits + (size_t)i * words, id);
                         }
                     }
+                    if (*next == '\0') break;
+                    cur = next + 1;
+                    next = strchr(cur, ' '); if (!next) next = strchr(cur, '\0');
                 }
-                if (*next == '\0') break;
-                cur = next + 1;
-                next = strchr(cur, ' '); if (!next) next = strchr(cur, '\0');
             }
         }
     }
+
+    for(i = 0; i < s->core_count; i++) {
+        n = strlist_find(s->flags, s->cores[i].flags);
+        if (n >= 0)
+            flagset_or(s->flagset, i, sbits + (size_t)n * words);
+    }
+    flagset_count_rows(s->flagset);
+    free(sbits);
     // DEBUG printf("add_unknown_flags(): added %d previously unknown flags\n", added_count);
 }
 
+static void make_desc(arm_proc *p) {
+    p->cpu_desc = gen_cpu_desc(p);
+}
+
+static void need_freq(arm_proc *p) {
+    lazy_once(&p->lazy, LAZY_FREQ, (lazy_func)scan_freq, p);
+}
+
+static void need_desc(arm_proc *p) {
+    need_freq(p);
+    lazy_once(&p->lazy, LAZY_DESC, (lazy_func)make_desc, p);
+}
+
+static void need_flags(arm_proc *p) {
+    lazy_once(&p->lazy, LAZY_FLAGS, (lazy_func)process_flags, p);
+}
+
 arm_proc *arm_proc_new(void) {
     arm_proc *s = malloc( sizeof(arm_proc) );
     if (s) {
@@ -283,13 +398,11 @@ arm_proc *arm_proc_new(void) {
         s->cpu_revision = strlist_new();
         s->decoded_name = strlist_new();
         s->cpukhz_max_str = strlist_new();
-        s->each_flag = strlist_new();
+        s->flagset = flagset_new(arm_flag_name, ARM_FLAG_N_KNOWN);
         if (!scan_cpu(s)) {
             arm_proc_free(s);
             return NULL;
         }
-        s->cpu_desc = gen_cpu_desc(s);
-        process_flags(s);
     }
     return s;
 }
@@ -305,8 +418,15 @@ void arm_proc_free(arm_proc *s) {
         strlist_free(s->cpu_revision);
         strlist_free(s->decoded_name);
         strlist_free(s->cpukhz_max_str);
-        strlist_free(s->each_flag);
+        flagset_free(s->flagset);
+        free(s->all_flags);
         fields_free(s->fields);
+        cpu_table_free(s->table);
+        free(s->cores);
+        free(s->core_id);
+        free(s->khz_min);
+        free(s->khz_max);
+        free(s->khz_cur);
         free(s->cpu_desc);
         free(s);
     }
@@ -320,20 +440,48 @@ const char *arm_proc_name(arm_proc *s) {
 }
 
 const char *arm_proc_desc(arm_proc *s) {
-    if (s)
+    if (s) {
+        need_desc(s);
         return s->cpu_desc;
+    }
     else
         return NULL;
 }
 
-int arm_proc_has_flag(arm_proc *s, const char *flag) {
-    int i;
+const char *arm_proc_flag_list(arm_proc *s) {
+    /* flags not in the table are appended as they are processed */
+    if (s) {
+        need_flags(s);
+        if (s->all_flags)
+            return s->all_flags;
+    }
+    return arm_flag_list();
+}
+
+int arm_proc_flag_id(arm_proc *s, const char *flag) {
     if (s && flag) {
-        for (i = 0; i < s->each_flag->count; i++) {
-            //DEBUG printf("(%s)...[%d/%d] %s %d\n", flag, i, s->each_flag->count, s->each_flag->strs[i].str, s->each_flag->strs[i].ref_count);
-            if (strcmp(s->each_flag->strs[i].str, flag) == 0)
-                return s->each_flag->strs[i].ref_count;
-        }
+        need_flags(s);
+        return flagset_id(s->flagset, flag, strlen(flag), 0);
+    }
+    return -1;
+}
+
+int arm_proc_has_flag(arm_proc *s, const char *flag) {
+    return arm_proc_has_feature(s, arm_proc_flag_id(s, flag));
+}
+
+int arm_proc_has_feature(arm_proc *s, int id) {
+    if (s) {
+        need_flags(s);
+        return flagset_count(s->flagset, id);
+    }
+    return 0;
+}
+
+int arm_proc_core_has_feature(arm_proc *s, int core, int id) {
+    if (s) {
+        need_flags(s);
+        return flagset_test(s->flagset, core, id);
     }
     return 0;
 }
@@ -349,7 +497,7 @@ int arm_proc_core_from_id(arm_proc *s, int id) {
     int i = 0;
     if (s)
         for (i = 0; i < s->core_count; i++ )
-            if (s->cores[i].id == id)
+            if (s->core_id[i] == id)
                 return i;
 
     return -1;
@@ -358,23 +506,43 @@ int arm_proc_core_from_id(arm_proc *s, int id) {
 int arm_proc_core_id(arm_proc *s, int core) {
     if (s)
         if (core >= 0 && core < s->core_count)
-            return s->cores[core].id;
+            return s->core_id[core];
 
     return 0;
 }
 
-int arm_proc_core_khz_min(arm_proc *s, int core) {
+const char *arm_proc_core_model_name(arm_proc *s, int core) {
     if (s)
         if (core >= 0 && core < s->core_count)
-            return s->cores[core].cpukhz_min;
+            return s->cores[core].model_name;
+
+    return NULL;
+}
+
+const char *arm_proc_core_decoded_name(arm_proc *s, int core) {
+    if (s)
+        if (core >= 0 && core < s->core_count)
+            return s->cores[core].decoded_name;
+
+    return NULL;
+}
+
+int arm_proc_core_khz_min(arm_proc *s, int core) {
+    if (s)
+        if (core >= 0 && core < s->core_count) {
+            need_freq(s);
+            return s->khz_min[core];
+        }
 
     return 0;
 }
 
 int arm_proc_core_khz_max(arm_proc *s, int core) {
     if (s)
-        if (core >= 0 && core < s->core_count)
-            return s->cores[core].cpukhz_max;
+        if (core >= 0 && core < s->core_count) {
+            need_freq(s);
+            return s->khz_max[core];
+        }
 
     return 0;
 }
@@ -382,27 +550,82 @@ int arm_proc_core_khz_max(arm_proc *s, int core) {
 int arm_proc_core_khz_cur(arm_proc *s, int core) {
     if (s)
         if (core >= 0 && core < s->core_count) {
-            get_cpu_freq(s->cores[core].id, NULL, NULL, &s->cores[core].cpukhz_cur);
-            return s->cores[core].cpukhz_cur;
+            need_freq(s);
+            get_cpu_freq(s->core_id[core], NULL, NULL, &s->khz_cur[core]);
+            return s->khz_cur[core];
         }
     return 0;
 }
 
-static char* arm_proc_cores_str(arm_proc *s) {
-    char *buff = NULL;
+static int arm_proc_cores_value(arm_proc *s, rpiz_value *v) {
+    v->i = arm_proc_cores(s);
+    return 1;
+}
+
+static char *implementer_flat(const cpu_table *t, int col, int row) {
+    arm_proc *s = cpu_table_data(t);
+    char bv[256];
+    sprintf(bv, "[%s] %s", s->cores[row].cpu_implementer, arm_implementer(s->cores[row].cpu_implementer) );
+    return strdup(bv);
+}
+
+static char *architecture_flat(const cpu_table *t, int col, int row) {
+    arm_proc *s = cpu_table_data(t);
+    char bv[256];
+    sprintf(bv, "[%s] %s", s->cores[row].cpu_architecture, arm_arch_more(s->cores[row].cpu_architecture) );
+    return strdup(bv);
+}
+
+static char *part_flat(const cpu_table *t, int col, int row) {
+    arm_proc *s = cpu_table_data(t);
+    char bv[256];
+    sprintf(bv, "[%s] %s", s->cores[row].cpu_part, arm_part(s->cores[row].cpu_implementer, s->cores[row].cpu_part) );
+    return strdup(bv);
+}
+
+static void refresh_khz_cur(arm_proc *s) {
+    get_cpu_freq_cur_batch(s->core_id, s->core_count, s->khz_cur);
+}
+
+#define ADDCOL(n, l, t, f, fl, ff) cpu_table_add(s->table, n, l, t, &s->cores[0].f, sizeof(arm_core), fl, ff)
+#define ADDCOLINT(n, c, fl) cpu_table_add(s->table, n, NULL, CELL_INT, s->c, sizeof(int), fl, NULL)
+/* the flat fields use it without the freq columns, so only
+ * arm_proc_table() reads those */
+static cpu_table *make_table(arm_proc *s) {
     if (s) {
-        buff = malloc(128);
-        if (buff)
-            snprintf(buff, 127, "%d", arm_proc_cores(s) );
+        if (!s->table) {
+            s->table = cpu_table_new(s->core_count, s->core_id, s);
+            if (!s->table) return NULL;
+            ADDCOL("model_name",       "linux name",     CELL_STR,   model_name,       COL_FLAT, NULL);
+            ADDCOL("decoded_name",     "decoded name",   CELL_STR,   decoded_name,     COL_FLAT, NULL);
+            ADDCOL("cpu_implementer",  "implementer",    CELL_STR,   cpu_implementer,  COL_FLAT, implementer_flat);
+            ADDCOL("cpu_architecture", "architecture",   CELL_STR,   cpu_architecture, COL_FLAT, architecture_flat);
+            ADDCOL("cpu_part",         "part",           CELL_STR,   cpu_part,         COL_FLAT, part_flat);
+            ADDCOL("cpu_variant",      "variant",        CELL_STR,   cpu_variant,      COL_FLAT, NULL);
+            ADDCOL("cpu_revision",     "revision",       CELL_STR,   cpu_revision,     COL_FLAT, NULL);
+            ADDCOL("reg_midr_el1",     "reg_midr_el1",   CELL_REG64, reg_midr_el1,     COL_FLAT, NULL);
+            ADDCOL("reg_revidr_el1",   "reg_revidr_el1", CELL_REG64, reg_revidr_el1,   COL_FLAT, NULL);
+            ADDCOL("flags",            NULL,             CELL_STR,   flags,            0,        NULL);
+            ADDCOLINT("khz_min", khz_min, 0);
+            ADDCOLINT("khz_max", khz_max, 0);
+            ADDCOLINT("khz_cur", khz_cur, COL_LIVE);
+            cpu_table_set_refresh(s->table, (cpu_table_refresh_func)refresh_khz_cur);
+        }
+        return s->table;
     }
-    return buff;
+    return NULL;
+}
+
+cpu_table *arm_proc_table(arm_proc *s) {
+    if (s)
+        need_freq(s);
+    return make_table(s);
 }
 
 #define ADDFIELD(t, l, o, n, f) fields_update_bytag(s->fields, t, l, o, n, (rpiz_fields_get_func)f, (void*)s)
 #define ADDFIELDSTR(t, l, o, n, str) fields_update_bytag(s->fields, t, l, o, n, NULL, (void*)str)
+#define ADDFIELDV(t, l, n, y, f) fields_update_value_bytag(s->fields, t, l, n, y, (rpiz_fields_value_func)f, (void*)s)
 rpiz_fields *arm_proc_fields(arm_proc *s) {
-    int i;
-    char bn[256] = "", bt[256] = "", bv[256] = "", *bvp;
     if (s) {
         if (!s->fields) {
             /* first insert creates */
@@ -410,56 +633,8 @@ rpiz_fields *arm_proc_fields(arm_proc *s) {
             ADDFIELD("summary.proc_desc", 0, 0, "Proccesor", arm_proc_desc );
             ADDFIELD("cpu.name",          0, 0, "Proccesor Name", arm_proc_name );
             ADDFIELD("cpu.desc",          0, 0, "Proccesor Description", arm_proc_desc );
-            ADDFIELD("cpu.count",         0, 1, "Core Count", arm_proc_cores_str );
-
-            for(i = 0; i < s->core_count; i++) {
-                sprintf(bt, "cpu.thread[%d].model_name", i);
-                sprintf(bn, "[%d] linux name", s->cores[i].id);
-                sprintf(bv, "%s", s->cores[i].model_name);
-                bvp = strdup(bv); ADDFIELDSTR(bt, 0, 1, bn, bvp);
-
-                sprintf(bt, "cpu.thread[%d].decoded_name", i);
-                sprintf(bn, "[%d] decoded name", s->cores[i].id);
-                sprintf(bv, "%s", s->cores[i].decoded_name);
-                bvp = strdup(bv); ADDFIELDSTR(bt, 0, 1, bn, bvp);
-
-                sprintf(bt, "cpu.thread[%d].cpu_implementer", i);
-                sprintf(bn, "[%d] implementer", s->cores[i].id);
-                sprintf(bv, "[%s] %s", s->cores[i].cpu_implementer, arm_implementer(s->cores[i].cpu_implementer) );
-                bvp = strdup(bv); ADDFIELDSTR(bt, 0, 1, bn, bvp);
-
-                sprintf(bt, "cpu.thread[%d].cpu_architecture", i);
-                sprintf(bn, "[%d] architecture", s->cores[i].id);
-                sprintf(bv, "[%s] %s", s->cores[i].cpu_architecture, arm_arch_more(s->cores[i].cpu_architecture) );
-                bvp = strdup(bv); ADDFIELDSTR(bt, 0, 1, bn, bvp);
-
-                sprintf(bt, "cpu.thread[%d].cpu_part", i);
-                sprintf(bn, "[%d] part", s->cores[i].id);
-                sprintf(bv, "[%s] %s", s->cores[i].cpu_part, arm_part(s->cores[i].cpu_implementer, s->cores[i].cpu_part) );
-                bvp = strdup(bv); ADDFIELDSTR(bt, 0, 1, bn, bvp);
-
-                sprintf(bt, "cpu.thread[%d].cpu_variant", i);
-                sprintf(bn, "[%d] variant", s->cores[i].id);
-                sprintf(bv, "%s", s->cores[i].cpu_variant );
-                bvp = strdup(bv); ADDFIELDSTR(bt, 0, 1, bn, bvp);
-
-                sprintf(bt, "cpu.thread[%d].cpu_revision", i);
-                sprintf(bn, "[%d] revision", s->cores[i].id);
-                sprintf(bv, "%s", s->cores[i].cpu_revision );
-                bvp = strdup(bv); ADDFIELDSTR(bt, 0, 1, bn, bvp);
-
-                sprintf(bt, "cpu.thread[%d].reg_midr_el1", i);
-                sprintf(bn, "[%d] reg_midr_el1", s->cores[i].id);
-                sprintf(bv, "0x%016llx", s->cores[i].reg_midr_el1 );
-                bvp = strdup(bv); ADDFIELDSTR(bt, 0, 1, bn, bvp);
-
-                sprintf(bt, "cpu.thread[%d].reg_revidr_el1", i);
-                sprintf(bn, "[%d] reg_revidr_el1", s->cores[i].id);
-                sprintf(bv, "0x%016llx", s->cores[i].reg_revidr_el1 );
-                bvp = strdup(bv); ADDFIELDSTR(bt, 0, 1, bn, bvp);
-
-            }
-
+            ADDFIELDV("cpu.count",        0, "Core Count", FIELD_INT64, arm_proc_cores_value );
+            cpu_table_flat_fields(make_table(s), s->fields, "cpu.thread");
         }
         return s->fields;
     }
@@ -472,11 +647,11 @@ static void dump(arm_proc *p) {
     int i;
     if (p) {
         printf(".proc.cpu_name = %s\n", p->cpu_name);
-        printf(".proc.cpu_desc = %s\n", p->cpu_desc);
+        printf(".proc.cpu_desc = %s\n", arm_proc_desc(p));
         printf(".proc.max_khz = %d\n", p->max_khz);
         printf(".proc.core_count = %d\n", p->core_count);
         for(i = 0; i < p->core_count; i++) {
-            printf(".proc.core[%d].id = %d\n", i, p->cores[i].id);
+            printf(".proc.core[%d].id = %d\n", i, p->core_id[i]);
             printf(".proc.core[%d].model_name = %s\n", i, p->cores[i].model_name);
             printf(".proc.core[%d].decoded_name = %s\n", i, p->cores[i].decoded_name);
             printf(".proc.core[%d].flags = %s\n", i, p->cores[i].flags);
@@ -486,12 +661,12 @@ static void dump(arm_proc *p) {
             printf(".proc.core[%d].cpu_part = [%s] %s\n", i, p->cores[i].cpu_part, arm_part(p->cores[i].cpu_implementer, p->cores[i].cpu_part) );
             printf(".proc.core[%d].cpu_revision = %s\n", i, p->cores[i].cpu_revision);
             printf(".proc.core[%d].freq_khz(min - max / cur) = %d - %d / %d\n", i,
-                p->cores[i].cpukhz_min, p->cores[i].cpukhz_max, p->cores[i].cpukhz_cur );
+                p->khz_min[i], p->khz_max[i], p->khz_cur[i] );
             printf(".proc.core[%d].reg_midr_el1 = 0x%016llx\n", i, p->cores[i].reg_midr_el1);
             printf(".proc.core[%d].reg_revidr_el1 = 0x%016llx\n", i, p->cores[i].reg_revidr_el1);
         }
     }
-    printf(".all_flags = %s (len: %d)\n", arm_flag_list(), (int)strlen( arm_flag_list() ) );
+    printf(".all_flags = %s (len: %d)\n", arm_proc_flag_list(p), (int)strlen( arm_flag_list() ) );
 }
 
 int main(void) {
@@ -22,6 +22,7 @@
 #define _ARMCPU_H_
 
 #include "fields.h"
+#include "cpu_table.h"
 
 #include "arm_data.h"
 const char *arm_flag_list(void);
@@ -33,14 +34,21 @@ void arm_proc_free(arm_proc *);
 
 const char *arm_proc_name(arm_proc *);
 const char *arm_proc_desc(arm_proc *);
+const char *arm_proc_flag_list(arm_proc *); /* arm_flag_list() with any unknown flags seen, owned by the arm_proc */
 int arm_proc_has_flag(arm_proc *, const char *flag); /* returns core count with flag */
+int arm_proc_flag_id(arm_proc *, const char *flag); /* arm_flag_id, or a dynamic id for unknown flags, -1 if not seen */
+int arm_proc_has_feature(arm_proc *, int id); /* returns core count with flag id */
+int arm_proc_core_has_feature(arm_proc *, int core, int id);
 int arm_proc_cores(arm_proc *);
 int arm_proc_core_from_id(arm_proc *, int id); /* -1 if not found */
 int arm_proc_core_id(arm_proc *, int core);
+const char *arm_proc_core_model_name(arm_proc *, int core);
+const char *arm_proc_core_decoded_name(arm_proc *, int core);
 int arm_proc_core_khz_min(arm_proc *, int core);
 int arm_proc_core_khz_max(arm_proc *, int core);
 int arm_proc_core_khz_cur(arm_proc *, int core);
 
+cpu_table *arm_proc_table(arm_proc *); /* one row per core, owned by the arm_proc */
 rpiz_fields *arm_proc_fields(arm_proc *);
 
 #endif
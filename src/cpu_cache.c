@@ -0,0 +1,394 @@
+/*
+ * rpiz - https://github.com/bp0/rpiz
+ * Copyright (C) 2017  Burt P. <pburt0@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "cpu_cache.h"
+
+#define CACHE_MAX_INDEX 8 /* per cpu */
+
+/* where read_details() finds the rest of an instance */
+typedef struct {
+    int cpu, index;
+} cache_src;
+
+struct cpu_caches {
+    int count, alloc;
+    cpu_cache *caches;
+    cache_src *src; /* where each was read from, same order as caches */
+    cpu_string_list *keys; /* "level:type:shared_cpu_list", same order as caches */
+
+    int cpu_count; /* highest cpu + 1 */
+    int *cpu_map; /* [cpu * CACHE_MAX_INDEX + index] = cache, or -1 */
+
+    char *desc;
+    rpiz_fields *fields;
+};
+
+static const char *cache_type_str[] = {
+    [CACHE_UNIFIED] = "Unified",
+    [CACHE_DATA] = "Data",
+    [CACHE_INSTRUCTION] = "Instruction",
+    [CACHE_OTHER] = "Other",
+};
+
+const char *cpu_cache_type_str(cpu_cache_type type) {
+    if (type >= CACHE_UNIFIED && type <= CACHE_OTHER)
+        return cache_type_str[type];
+    return NULL;
+}
+
+static cpu_cache_type cache_type_from_str(const char *str) {
+    int i;
+    if (str)
+        for (i = CACHE_UNIFIED; i < CACHE_OTHER; i++)
+            if (strcmp(str, cache_type_str[i]) == 0)
+                return i;
+    return CACHE_OTHER;
+}
+
+static char *chomp(char *str) {
+    int l;
+    if (str) {
+        l = strlen(str);
+        while (l > 0 && (str[l-1] == '\n' || str[l-1] == ' '))
+            str[--l] = 0;
+    }
+    return str;
+}
+
+static char *cache_str(int cpu, int index, const char *item) {
+    char fn[128];
+    snprintf(fn, sizeof(fn), "cache/index%d/%s", index, item);
+    return chomp(get_cpu_str(fn, cpu));
+}
+
+static int cache_int(int cpu, int index, const char *item) {
+    char fn[128];
+    snprintf(fn, sizeof(fn), "cache/index%d/%s", index, item);
+    return get_cpu_int(fn, cpu);
+}
+
+/* what is needed to tell instances apart, read in parallel per cpu */
+typedef struct {
+    int cpu;
+    int count;
+    int level[CACHE_MAX_INDEX];
+    cpu_cache_type type[CACHE_MAX_INDEX];
+    char *shared[CACHE_MAX_INDEX];
+} cache_probe;
+
+static void probe_cpu(void *data, int n) {
+    cache_probe *pr = &((cache_probe*)data)[n];
+    char *type_str, tmp[32];
+    int i, level;
+
+    for (i = 0; i < CACHE_MAX_INDEX; i++) {
+        level = cache_int(pr->cpu, i, "level");
+        if (!level) break;
+        pr->level[i] = level;
+        type_str = cache_str(pr->cpu, i, "type");
+        pr->type[i] = cache_type_from_str(type_str);
+        free(type_str);
+        pr->shared[i] = cache_str(pr->cpu, i, "shared_cpu_list");
+        if (!pr->shared[i]) {
+            snprintf(tmp, sizeof(tmp), "%d", pr->cpu);
+            pr->shared[i] = strdup(tmp);
+        }
+    }
+    pr->count = i;
+}
+
+static int add_cache(cpu_caches *s, int cpu, int index, int level, cpu_cache_type type, char *shared, const char *key) {
+    cpu_cache *tmp, *c;
+    cache_src *src;
+    int alloc;
+    if (s->count == s->alloc) {
+        alloc = s->alloc ? s->alloc * 2 : 8;
+        tmp = realloc(s->caches, sizeof(cpu_cache) * alloc);
+        if (!tmp) {
+            free(shared);
+            return -1;
+        }
+        s->caches = tmp;
+        src = realloc(s->src, sizeof(cache_src) * alloc);
+        if (!src) {
+            free(shared);
+            return -1;
+        }
+        s->src = src;
+        s->alloc = alloc;
+    }
+    c = &s->caches[s->count];
+    memset(c, 0, sizeof(*c));
+    c->level = level;
+    c->type = type;
+    /* the rest is read by read_details(), from cpu/index */
+    s->src[s->count].cpu = cpu;
+    s->src[s->count].index = index;
+    c->shared_cpu_list = shared;
+    c->shared_cpus = cpumask_from_list(shared);
+    if (!c->shared_cpus) {
+        c->shared_cpus = cpumask_new(cpu + 1);
+        cpumask_set(c->shared_cpus, cpu);
+    }
+    strlist_add(s->keys, key);
+    return s->count++;
+}
+
+/* only for the first cpu in an instance */
+static void read_details(void *data, int n) {
+    cpu_caches *s = data;
+    cpu_cache *c = &s->caches[n];
+    int cpu = s->src[n].cpu, index = s->src[n].index;
+    char *size;
+    size = cache_str(cpu, index, "size");
+    c->size = get_size_str(size);
+    free(size);
+    c->line_size = cache_int(cpu, index, "coherency_line_size");
+    c->ways = cache_int(cpu, index, "ways_of_associativity");
+    c->sets = cache_int(cpu, index, "number_of_sets");
+    c->id = cache_int(cpu, index, "id");
+}
+
+static int set_cpu_map(cpu_caches *s, int cpu, int index, int cache) {
+    int *tmp, n;
+    if (cpu >= s->cpu_count) {
+        n = cpu + 1;
+        if (n < s->cpu_count * 2) n = s->cpu_count * 2;
+        tmp = realloc(s->cpu_map, sizeof(int) * n * CACHE_MAX_INDEX);
+        if (!tmp) return 0;
+        memset(tmp + s->cpu_count * CACHE_MAX_INDEX, 0xff, sizeof(int) * (n - s->cpu_count) * CACHE_MAX_INDEX);
+        s->cpu_map = tmp;
+        s->cpu_count = n;
+    }
+    s->cpu_map[cpu * CACHE_MAX_INDEX + index] = cache;
+    return 1;
+}
+
+/* dedupe in cpu order, so instance numbering does not depend on
+ * which thread read what first */
+static void merge_probe(cpu_caches *s, cache_probe *pr) {
+    char key[512];
+    int i, c;
+
+    for (i = 0; i < pr->count; i++) {
+        snprintf(key, sizeof(key), "%d:%d:%s", pr->level[i], pr->type[i], pr->shared[i]);
+        c = strlist_find(s->keys, key);
+        if (c < 0)
+            c = add_cache(s, pr->cpu, i, pr->level[i], pr->type[i], pr->shared[i], key);
+        else
+            free(pr->shared[i]);
+        if (c >= 0)
+            set_cpu_map(s, pr->cpu, i, c);
+    }
+}
+
+cpu_caches *cpu_caches_new() {
+    cpu_caches *s;
+    cpu_mask *online;
+    cache_probe *probes;
+    int cpu, i, n = 0;
+
+    s = malloc( sizeof(cpu_caches) );
+    if (s) {
+        memset(s, 0, sizeof(*s));
+        s->keys = strlist_new();
+        online = get_cpu_online();
+        probes = calloc(cpumask_count(online) + 1, sizeof(cache_probe));
+        if (probes) {
+            CPUMASK_FOR_EACH(cpu, online)
+                probes[n++].cpu = cpu;
+            par_for(n, probe_cpu, probes);
+            for (i = 0; i < n; i++)
+                merge_probe(s, &probes[i]);
+            par_for(s->count, read_details, s);
+            free(probes);
+        }
+        cpumask_free(online);
+    }
+    return s;
+}
+
+void cpu_caches_free(cpu_caches *s) {
+    int i;
+    if (s) {
+        for (i = 0; i < s->count; i++) {
+            free(s->caches[i].shared_cpu_list);
+            cpumask_free(s->caches[i].shared_cpus);
+        }
+        free(s->caches);
+        free(s->src);
+        strlist_free(s->keys);
+        free(s->cpu_map);
+        free(s->desc);
+        fields_free(s->fields);
+        free(s);
+    }
+}
+
+int cpu_caches_count(cpu_caches *s) {
+    if (s)
+        return s->count;
+    return 0;
+}
+
+const cpu_cache *cpu_caches_get(cpu_caches *s, int i) {
+    if (s)
+        if (i >= 0 && i < s->count)
+            return &s->caches[i];
+    return NULL;
+}
+
+int cpu_caches_max_level(cpu_caches *s) {
+    int i, ret = 0;
+    if (s)
+        for (i = 0; i < s->count; i++)
+            if (s->caches[i].level > ret)
+                ret = s->caches[i].level;
+    return ret;
+}
+
+const cpu_cache *cpu_caches_for_cpu(cpu_caches *s, int cpu, int level, cpu_cache_type type) {
+    const cpu_cache *c, *data = NULL;
+    int i, m;
+    if (s && cpu >= 0 && cpu < s->cpu_count) {
+        for (i = 0; i < CACHE_MAX_INDEX; i++) {
+            m = s->cpu_map[cpu * CACHE_MAX_INDEX + i];
+            if (m < 0) continue;
+            c = &s->caches[m];
+            if (c->level != level) continue;
+            if (c->type == type)
+                return c;
+            if (type == CACHE_UNIFIED && c->type == CACHE_DATA)
+                data = c;
+        }
+    }
+    return data;
+}
+
+long cpu_caches_size(cpu_caches *s, int cpu, int level) {
+    const cpu_cache *c = cpu_caches_for_cpu(s, cpu, level, CACHE_UNIFIED);
+    if (c)
+        return c->size;
+    return 0;
+}
+
+static void size_str(char *buff, int size, long bytes) {
+    if (bytes >= 1024 * 1024 && bytes % (1024 * 1024) == 0)
+        snprintf(buff, size, "%ldM", bytes / (1024 * 1024));
+    else if (bytes >= 1024)
+        snprintf(buff, size, "%ldK", bytes / 1024);
+    else
+        snprintf(buff, size, "%ld", bytes);
+}
+
+/* "L1d: 2x 32K, L1i: 2x 32K, L2: 1x 1024K, L3: 1x 32M" */
+const char *cpu_caches_desc(cpu_caches *s) {
+    char buff[1024] = "", sz[32];
+    int l = 0, i, j, n, seen;
+    const cpu_cache *c, *d;
+    if (!s) return NULL;
+    if (!s->desc) {
+        for (i = 0; i < s->count; i++) {
+            c = &s->caches[i];
+            seen = n = 0;
+            for (j = 0; j < s->count; j++) {
+                d = &s->caches[j];
+                if (d->level == c->level && d->type == c->type && d->size == c->size) {
+                    if (j < i) { seen = 1; break; }
+                    n++;
+                }
+            }
+            if (seen) continue;
+            size_str(sz, sizeof(sz), c->size);
+            l += snprintf(buff + l, sizeof(buff) - l, "%sL%d%s: %dx %s",
+                l ? ", " : "", c->level,
+                (c->type == CACHE_DATA) ? "d" : (c->type == CACHE_INSTRUCTION) ? "i" : "",
+                n, sz);
+            if (l >= (int)sizeof(buff)) break;
+        }
+        s->desc = strdup(buff);
+    }
+    return s->desc;
+}
+
+static int cpu_caches_count_value(cpu_caches *s, rpiz_value *v) {
+    v->i = cpu_caches_count(s);
+    return 1;
+}
+
+static int cpu_cache_level_value(cpu_cache *c, rpiz_value *v) {
+    v->i = c->level;
+    return 1;
+}
+
+static char *cpu_cache_size_str(cpu_cache *c) {
+    char *buff = malloc(32);
+    if (buff)
+        size_str(buff, 31, c->size);
+    return buff;
+}
+
+static int cpu_cache_line_size_value(cpu_cache *c, rpiz_value *v) {
+    v->i = c->line_size;
+    return 1;
+}
+
+static int cpu_cache_ways_value(cpu_cache *c, rpiz_value *v) {
+    v->i = c->ways;
+    return 1;
+}
+
+#define ADDFIELDC(t, l, o, n, f) fields_update_bytag(s->fields, t, l, o, n, (rpiz_fields_get_func)f, (void*)c)
+#define ADDFIELDSTR(t, l, o, n, str) fields_update_bytag(s->fields, t, l, o, n, NULL, (void*)str)
+#define ADDFIELDV(t, l, n, y, f) fields_update_value_bytag(s->fields, t, l, n, y, (rpiz_fields_value_func)f, (void*)s)
+#define ADDFIELDCV(t, l, n, y, f) fields_update_value_bytag(s->fields, t, l, n, y, (rpiz_fields_value_func)f, (void*)c)
+rpiz_fields *cpu_caches_fields(cpu_caches *s) {
+    char tag[64];
+    cpu_cache *c;
+    int i;
+    if (s) {
+        if (!s->fields) {
+            /* first insert creates */
+            s->fields =
+            ADDFIELDV("cache.count",   0, "Cache Instances", FIELD_INT64, cpu_caches_count_value );
+            ADDFIELDSTR("cache.desc", 0, 0, "Caches", cpu_caches_desc(s) );
+            for (i = 0; i < s->count; i++) {
+                c = &s->caches[i];
+                snprintf(tag, sizeof(tag), "cache.instance[%d].level", i);
+                ADDFIELDCV(tag, 0, "Level", FIELD_INT64, cpu_cache_level_value );
+                snprintf(tag, sizeof(tag), "cache.instance[%d].type", i);
+                ADDFIELDSTR(tag, 0, 0, "Type", cpu_cache_type_str(c->type) );
+                snprintf(tag, sizeof(tag), "cache.instance[%d].size", i);
+                ADDFIELDC(tag, 0, 1, "Size", cpu_cache_size_str );
+                snprintf(tag, sizeof(tag), "cache.instance[%d].line_size", i);
+                ADDFIELDCV(tag, 0, "Line Size", FIELD_INT64, cpu_cache_line_size_value );
+                snprintf(tag, sizeof(tag), "cache.instance[%d].ways", i);
+                ADDFIELDCV(tag, 0, "Ways", FIELD_INT64, cpu_cache_ways_value );
+                snprintf(tag, sizeof(tag), "cache.instance[%d].shared_cpu_list", i);
+                ADDFIELDSTR(tag, 0, 0, "Shared CPUs", c->shared_cpu_list );
+            }
+        }
+        return s->fields;
+    }
+    return NULL;
+}
@@ -0,0 +1,67 @@
+/*
+ * rpiz - https://github.com/bp0/rpiz
+ * Copyright (C) 2017  Burt P. <pburt0@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+#ifndef _CPU_CACHE_H_
+#define _CPU_CACHE_H_
+
+#include "fields.h"
+#include "util.h"
+
+typedef enum {
+    CACHE_UNIFIED = 0,
+    CACHE_DATA,
+    CACHE_INSTRUCTION,
+    CACHE_OTHER,
+} cpu_cache_type;
+
+typedef struct {
+    int level;
+    cpu_cache_type type;
+    long size; /* bytes */
+    int line_size;
+    int ways;
+    int sets;
+    int id;
+    char *shared_cpu_list;
+    cpu_mask *shared_cpus;
+} cpu_cache;
+
+typedef struct cpu_caches cpu_caches;
+
+/* one pass over /sys/devices/system/cpu/cpuN/cache/index*,
+ * instances shared by several cpus are only listed once */
+cpu_caches *cpu_caches_new(void);
+void cpu_caches_free(cpu_caches *);
+
+int cpu_caches_count(cpu_caches *);
+const cpu_cache *cpu_caches_get(cpu_caches *, int i);
+int cpu_caches_max_level(cpu_caches *);
+
+/* type CACHE_UNIFIED matches a unified cache or the data cache at that level,
+ * NULL if the cpu has no such cache */
+const cpu_cache *cpu_caches_for_cpu(cpu_caches *, int cpu, int level, cpu_cache_type type);
+long cpu_caches_size(cpu_caches *, int cpu, int level); /* data or unified, bytes */
+
+const char *cpu_cache_type_str(cpu_cache_type type);
+const char *cpu_caches_desc(cpu_caches *);
+
+rpiz_fields *cpu_caches_fields(cpu_caches *);
+
+#endif
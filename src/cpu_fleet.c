@@ -0,0 +1,346 @@
+/*
+ * rpiz - https://github.com/bp0/rpiz
+ * Copyright (C) 2017  Burt P. <pburt0@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "util.h"
+#include "cpu.h"
+#include "cpuinfo_ctx.h"
+#include "cpu_fleet.h"
+
+#define FLEET_ARCHS 3
+static const char *arch_names[FLEET_ARCHS] = { "arm", "x86", "riscv" };
+
+struct cpu_fleet {
+    int hosts;
+    int unknown;
+    long long elapsed_us;
+    int arch_hosts[FLEET_ARCHS];
+
+    cpu_string_list *model;   /* hosts with a thread of each model name */
+    cpu_string_list *decoded; /* threads with each decoded name */
+    cpu_string_list *freq;    /* threads with each max frequency */
+    cpu_string_list *flags[FLEET_ARCHS]; /* hosts with each flag on any thread */
+
+    rpiz_fields *fields;
+};
+
+/* hosts are parsed a batch at a time, so the parsed hosts waiting
+ * for the merge stay few however large the fleet is */
+#define FLEET_BATCH 256
+
+static long long time_us(void) {
+    struct timespec tv;
+    clock_gettime(CLOCK_MONOTONIC, &tv);
+    return (long long)tv.tv_sec * 1000000 + tv.tv_nsec / 1000;
+}
+
+cpu_fleet *cpu_fleet_new(void) {
+    cpu_fleet *s = malloc(sizeof(cpu_fleet));
+    int a;
+    if (s) {
+        memset(s, 0, sizeof(*s));
+        s->model = strlist_new();
+        s->decoded = strlist_new();
+        s->freq = strlist_new();
+        for (a = 0; a < FLEET_ARCHS; a++)
+            s->flags[a] = strlist_new();
+        if (!s->model || !s->decoded || !s->freq
+            || !s->flags[0] || !s->flags[1] || !s->flags[2]) {
+            cpu_fleet_free(s);
+            return NULL;
+        }
+    }
+    return s;
+}
+
+void cpu_fleet_free(cpu_fleet *s) {
+    int a;
+    if (s) {
+        if (s->model) strlist_free(s->model);
+        if (s->decoded) strlist_free(s->decoded);
+        if (s->freq) strlist_free(s->freq);
+        for (a = 0; a < FLEET_ARCHS; a++)
+            if (s->flags[a]) strlist_free(s->flags[a]);
+        fields_free(s->fields);
+        free(s);
+    }
+}
+
+typedef struct {
+    const char **roots;
+    cpuinfo_ctx **ctx;
+} scan_job;
+
+/* reads all the merge will ask for, while still on the pool */
+static void scan_host(void *data, int i) {
+    scan_job *j = data;
+    cpuinfo_ctx *prev;
+    j->ctx[i] = cpuinfo_ctx_new(j->roots[i]);
+    if (!j->ctx[i])
+        return;
+    prev = cpuinfo_ctx_use(j->ctx[i]);
+    probe_begin();
+    cpu_all_flags();
+    cpu_thread_khz_max(0);
+    probe_end();
+    cpuinfo_ctx_use(prev);
+}
+
+static int arch_index(const char *arch) {
+    int a;
+    if (arch)
+        for (a = 0; a < FLEET_ARCHS; a++)
+            if (strcmp(arch, arch_names[a]) == 0)
+                return a;
+    return -1;
+}
+
+/* counts the host in the context in use, returns 0 if not recognized */
+static int merge_host(cpu_fleet *s) {
+    const char **seen, *name, *flags, *next;
+    char flag[64], freq[32];
+    int a, i, k, n, l, khz, nseen = 0;
+
+    a = arch_index(cpu_arch());
+    n = cpu_threads();
+    if (a < 0 || n < 1)
+        return 0;
+    s->arch_hosts[a]++;
+
+    /* model names are interned per host, so a repeat is the same pointer */
+    seen = malloc(sizeof(const char *) * n);
+    if (!seen)
+        return 0;
+    for (i = 0; i < n; i++) {
+        name = cpu_thread_model_name(i);
+        for (k = 0; k < nseen; k++)
+            if (seen[k] == name)
+                break;
+        if (k == nseen) {
+            seen[nseen++] = name;
+            strlist_add(s->model, (name && *name) ? name : "(Unknown)");
+        }
+
+        /* archs without a decoder count their model name */
+        if (cpu_thread_decoded_name(i))
+            name = cpu_thread_decoded_name(i);
+        strlist_add(s->decoded, (name && *name) ? name : "(Unknown)");
+
+        khz = cpu_thread_khz_max(i);
+        if (khz > 0)
+            snprintf(freq, sizeof(freq), "%0.2f MHz", khz / 1000.0);
+        else
+            snprintf(freq, sizeof(freq), "(Unknown)");
+        strlist_add(s->freq, freq);
+    }
+    free(seen);
+
+    flags = cpu_all_flags();
+    while (flags && *flags) {
+        next = strchr(flags, ' ');
+        l = next ? next - flags : (int)strlen(flags);
+        if (l > 0 && l < (int)sizeof(flag)) {
+            memcpy(flag, flags, l);
+            flag[l] = 0;
+            if (cpu_has_flag(flag))
+                strlist_add(s->flags[a], flag);
+        }
+        flags = next ? next + 1 : NULL;
+    }
+    return 1;
+}
+
+int cpu_fleet_scan(cpu_fleet *s, const char **roots, int count) {
+    cpuinfo_ctx *ctx[FLEET_BATCH], *prev;
+    scan_job job = { NULL, ctx };
+    long long start;
+    int b, i, n, known = 0;
+
+    if (!s || !roots)
+        return 0;
+    start = time_us();
+    for (b = 0; b < count; b += FLEET_BATCH) {
+        n = (count - b < FLEET_BATCH) ? count - b : FLEET_BATCH;
+        job.roots = roots + b;
+        par_for(n, scan_host, &job);
+        /* in index order, so every run counts the same */
+        for (i = 0; i < n; i++) {
+            s->hosts++;
+            if (ctx[i]) {
+                prev = cpuinfo_ctx_use(ctx[i]);
+                if (merge_host(s))
+                    known++;
+                else
+                    s->unknown++;
+                cpuinfo_ctx_use(prev);
+                cpuinfo_ctx_free(ctx[i]);
+            } else
+                s->unknown++;
+        }
+    }
+    s->elapsed_us += time_us() - start;
+
+    /* made again with the new counts */
+    fields_free(s->fields);
+    s->fields = NULL;
+    return known;
+}
+
+int cpu_fleet_scan_dir(cpu_fleet *s, const char *dir) {
+    struct dirent **list = NULL;
+    struct stat st;
+    char **roots;
+    char path[256];
+    int i, n, count = 0, ret = 0;
+
+    if (!s || !dir)
+        return 0;
+    /* sorted, so the hosts are always in the same order */
+    n = scandir(dir, &list, NULL, alphasort);
+    if (n < 0)
+        return 0;
+    roots = malloc(sizeof(char *) * (n + 1));
+    if (roots) {
+        for (i = 0; i < n; i++) {
+            if (list[i]->d_name[0] == '.')
+                continue;
+            /* too long to be a sysroot */
+            if (snprintf(path, sizeof(path), "%s/%s", dir, list[i]->d_name) >= (int)sizeof(path))
+                continue;
+            if (stat(path, &st) == 0 && S_ISDIR(st.st_mode))
+                roots[count++] = strdup(path);
+        }
+        ret = cpu_fleet_scan(s, (const char **)roots, count);
+        for (i = 0; i < count; i++)
+            free(roots[i]);
+        free(roots);
+    }
+    for (i = 0; i < n; i++)
+        free(list[i]);
+    free(list);
+    return ret;
+}
+
+int cpu_fleet_hosts(cpu_fleet *s) {
+    if (s)
+        return s->hosts;
+    else
+        return 0;
+}
+
+int cpu_fleet_unknown(cpu_fleet *s) {
+    if (s)
+        return s->unknown;
+    else
+        return 0;
+}
+
+double cpu_fleet_hosts_per_sec(cpu_fleet *s) {
+    if (s && s->elapsed_us > 0)
+        return s->hosts * 1000000.0 / s->elapsed_us;
+    return 0;
+}
+
+static int cpu_fleet_hosts_value(cpu_fleet *s, rpiz_value *v) {
+    v->i = s->hosts;
+    return 1;
+}
+
+static int cpu_fleet_unknown_value(cpu_fleet *s, rpiz_value *v) {
+    v->i = s->unknown;
+    return 1;
+}
+
+static char *cpu_fleet_rate_str(cpu_fleet *s) {
+    char *buff = malloc(64);
+    if (buff)
+        snprintf(buff, 63, "%0.1f hosts/s (%0.2f ms)",
+            cpu_fleet_hosts_per_sec(s), s->elapsed_us / 1000.0);
+    return buff;
+}
+
+static char *count_str(int count, int total, const char *unit) {
+    char *buff = malloc(64);
+    if (buff)
+        snprintf(buff, 63, "%d %s (%0.1f%%)", count, unit,
+            total ? count * 100.0 / total : 0.0);
+    return buff;
+}
+
+/* most first, then by name */
+static int cmp_count(const void *a, const void *b) {
+    const cpu_string *sa = *(const cpu_string * const *)a, *sb = *(const cpu_string * const *)b;
+    if (sa->ref_count != sb->ref_count)
+        return (sa->ref_count > sb->ref_count) ? -1 : 1;
+    return strcmp(sa->str, sb->str);
+}
+
+#define ADDFIELD(t, l, o, n, f) fields_update_bytag(s->fields, t, l, o, n, (rpiz_fields_get_func)f, (void*)s)
+#define ADDFIELDSTR(t, l, o, n, str) fields_update_bytag(s->fields, t, l, o, n, NULL, (void*)str)
+#define ADDFIELDV(t, l, n, y, f) fields_update_value_bytag(s->fields, t, l, n, y, (rpiz_fields_value_func)f, (void*)s)
+static void add_histogram(cpu_fleet *s, const char *prefix, cpu_string_list *list, int total, const char *unit) {
+    cpu_string **sorted;
+    char tag[128];
+    int i;
+    sorted = malloc(sizeof(cpu_string *) * (list->count + 1));
+    if (!sorted)
+        return;
+    for (i = 0; i < list->count; i++)
+        sorted[i] = &list->strs[i];
+    qsort(sorted, list->count, sizeof(cpu_string *), cmp_count);
+    for (i = 0; i < list->count; i++) {
+        snprintf(tag, sizeof(tag), "%s[%d]", prefix, i);
+        ADDFIELDSTR(tag, 0, 1, sorted[i]->str, count_str(sorted[i]->ref_count, total, unit) );
+    }
+    free(sorted);
+}
+
+rpiz_fields *cpu_fleet_fields(cpu_fleet *s) {
+    char tag[64];
+    int a, threads = 0, i;
+    if (s) {
+        if (!s->fields) {
+            /* first insert creates */
+            s->fields =
+            ADDFIELDV("fleet.hosts",   0, "Hosts", FIELD_INT64, cpu_fleet_hosts_value );
+            ADDFIELDV("fleet.unknown", 0, "Not Recognized", FIELD_INT64, cpu_fleet_unknown_value );
+            ADDFIELD("fleet.rate",    0, 1, "Throughput", cpu_fleet_rate_str );
+            for (a = 0; a < FLEET_ARCHS; a++) {
+                snprintf(tag, sizeof(tag), "fleet.arch.%s", arch_names[a]);
+                ADDFIELDSTR(tag, 0, 1, (char*)arch_names[a], count_str(s->arch_hosts[a], s->hosts, "hosts") );
+            }
+            for (i = 0; i < s->decoded->count; i++)
+                threads += s->decoded->strs[i].ref_count;
+            add_histogram(s, "fleet.model", s->model, s->hosts - s->unknown, "hosts");
+            add_histogram(s, "fleet.decoded_name", s->decoded, threads, "threads");
+            add_histogram(s, "fleet.freq", s->freq, threads, "threads");
+            for (a = 0; a < FLEET_ARCHS; a++) {
+                snprintf(tag, sizeof(tag), "fleet.%s.flag", arch_names[a]);
+                add_histogram(s, tag, s->flags[a], s->arch_hosts[a], "hosts");
+            }
+        }
+        return s->fields;
+    }
+    return NULL;
+}
@@ -0,0 +1,44 @@
+/*
+ * rpiz - https://github.com/bp0/rpiz
+ * Copyright (C) 2017  Burt P. <pburt0@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+#ifndef _CPU_FLEET_H_
+#define _CPU_FLEET_H_
+
+#include "fields.h"
+
+typedef struct cpu_fleet cpu_fleet;
+
+/* Aggregates the cpu part of many captured hosts, each a sysroot with
+ * its own /proc/cpuinfo and /sys, whatever architecture they are from.
+ * Hosts are parsed in their own cpuinfo_ctx on the par_for() pool and
+ * counted into histograms of models, decoded names, flags and max
+ * frequencies. */
+cpu_fleet *cpu_fleet_new(void);
+void cpu_fleet_free(cpu_fleet *);
+
+int cpu_fleet_scan(cpu_fleet *, const char **roots, int count); /* returns hosts recognized */
+int cpu_fleet_scan_dir(cpu_fleet *, const char *dir); /* each subdirectory is a host */
+
+int cpu_fleet_hosts(cpu_fleet *); /* scanned, recognized or not */
+int cpu_fleet_unknown(cpu_fleet *); /* no cpuinfo any parser knows */
+double cpu_fleet_hosts_per_sec(cpu_fleet *); /* over all scans */
+
+rpiz_fields *cpu_fleet_fields(cpu_fleet *); /* fleet.* */
+
+#endif
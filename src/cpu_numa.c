@@ -0,0 +1,289 @@
+/*
+ * rpiz - https://github.com/bp0/rpiz
+ * Copyright (C) 2017  Burt P. <pburt0@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "cpu_numa.h"
+
+struct numa_nodes {
+    int count;
+    numa_node *nodes;
+    int *distance; /* [i * count + j] */
+
+    int cpu_count; /* highest cpu + 1 */
+    int *cpu_node; /* [cpu] = node index, or -1 */
+
+    rpiz_fields *fields;
+};
+
+static int key_ends(const kv_slice *key, const char *str) {
+    int l = strlen(str);
+    return (key->len >= l && strncmp(key->str + key->len - l, str, l) == 0);
+}
+
+static long long kb_value(const kv_slice *value) {
+    return strtoll(value->str, NULL, 10) * 1024;
+}
+
+/* the same test numa_nodes_new() uses to fall back to single_node(),
+ * without a cpu_mask so the live field stays off the heap */
+static int no_numa(void) {
+    char buff[64];
+    return get_file_buff("/sys/devices/system/node/online", buff, sizeof(buff)) <= 0
+        || buff[0] < '0' || buff[0] > '9';
+}
+
+static void read_meminfo(numa_node *n) {
+    char fn[128];
+    kv_scan *kv;
+    kv_slice key, value;
+    snprintf(fn, sizeof(fn), "/sys/devices/system/node/node%d/meminfo", n->id);
+    kv = kv_new_file(fn);
+    if (!kv && n->id == 0 && no_numa())
+        kv = kv_new_file("/proc/meminfo"); /* the whole machine is node 0 */
+    if (kv) {
+        /* "Node 0 MemTotal:       65536000 kB" or "MemTotal:  65536000 kB" */
+        while( kv_next(kv, &key, &value) ) {
+            if (key_ends(&key, "MemTotal"))
+                n->mem_total = kb_value(&value);
+            else if (key_ends(&key, "MemFree"))
+                n->mem_free = kb_value(&value);
+        }
+        kv_free(kv);
+    }
+}
+
+/* The live field re-reads this, so it stays off the heap, and it only
+ * reads the node so a refresh thread can call it. -1 if unknown. */
+static long long read_mem_free(const numa_node *n) {
+    char fn[128], buff[4096];
+    char *p;
+    snprintf(fn, sizeof(fn), "/sys/devices/system/node/node%d/meminfo", n->id);
+    if (get_file_buff(fn, buff, sizeof(buff)) < 0) {
+        if (n->id != 0 || !no_numa() || get_file_buff("/proc/meminfo", buff, sizeof(buff)) < 0)
+            return -1;
+    }
+    p = strstr(buff, "MemFree:");
+    if (p)
+        return strtoll(p + 8, NULL, 10) * 1024;
+    return -1;
+}
+
+static void read_node(numa_node *n, int id) {
+    char fn[128];
+    int l;
+    memset(n, 0, sizeof(*n));
+    n->id = id;
+    snprintf(fn, sizeof(fn), "/sys/devices/system/node/node%d/cpulist", id);
+    n->cpulist = get_file_contents(fn);
+    if (n->cpulist) {
+        l = strlen(n->cpulist);
+        while (l > 0 && (n->cpulist[l-1] == '\n' || n->cpulist[l-1] == ' '))
+            n->cpulist[--l] = 0;
+    }
+    n->cpus = cpumask_from_list(n->cpulist);
+    if (!n->cpus)
+        n->cpus = cpumask_new(64);
+    read_meminfo(n);
+}
+
+static void read_distance(numa_nodes *s, int i) {
+    char fn[128];
+    char *fc, *p, *end;
+    int j;
+    long d;
+    snprintf(fn, sizeof(fn), "/sys/devices/system/node/node%d/distance", s->nodes[i].id);
+    fc = get_file_contents(fn);
+    if (!fc) return;
+    /* one column per online node, in node order */
+    p = fc;
+    for (j = 0; j < s->count; j++) {
+        d = strtol(p, &end, 10);
+        if (end == p) break;
+        s->distance[i * s->count + j] = d;
+        p = end;
+    }
+    free(fc);
+}
+
+static void single_node(numa_nodes *s) {
+    s->nodes = malloc(sizeof(numa_node));
+    s->distance = malloc(sizeof(int));
+    if (!s->nodes || !s->distance) return;
+    memset(s->nodes, 0, sizeof(numa_node));
+    s->nodes[0].cpus = get_cpu_online();
+    s->nodes[0].cpulist = cpumask_to_list(s->nodes[0].cpus);
+    s->distance[0] = 10;
+    s->count = 1;
+    read_meminfo(&s->nodes[0]);
+}
+
+numa_nodes *numa_nodes_new() {
+    numa_nodes *s;
+    cpu_mask *online;
+    int id, i, cpu;
+
+    s = malloc( sizeof(numa_nodes) );
+    if (s) {
+        memset(s, 0, sizeof(*s));
+        online = get_cpu_mask("/sys/devices/system/node/online");
+        if (online && cpumask_count(online)) {
+            s->nodes = malloc(sizeof(numa_node) * cpumask_count(online));
+            s->distance = calloc(cpumask_count(online) * cpumask_count(online), sizeof(int));
+            if (s->nodes && s->distance) {
+                CPUMASK_FOR_EACH(id, online)
+                    read_node(&s->nodes[s->count++], id);
+                for (i = 0; i < s->count; i++)
+                    read_distance(s, i);
+            }
+        } else
+            single_node(s);
+        cpumask_free(online);
+
+        for (i = 0; i < s->count; i++)
+            CPUMASK_FOR_EACH(cpu, s->nodes[i].cpus)
+                if (cpu >= s->cpu_count)
+                    s->cpu_count = cpu + 1;
+        s->cpu_node = malloc(sizeof(int) * (s->cpu_count + 1));
+        if (s->cpu_node) {
+            memset(s->cpu_node, 0xff, sizeof(int) * (s->cpu_count + 1));
+            for (i = 0; i < s->count; i++)
+                CPUMASK_FOR_EACH(cpu, s->nodes[i].cpus)
+                    s->cpu_node[cpu] = i;
+        }
+    }
+    return s;
+}
+
+void numa_nodes_free(numa_nodes *s) {
+    int i;
+    if (s) {
+        for (i = 0; i < s->count; i++) {
+            free(s->nodes[i].cpulist);
+            cpumask_free(s->nodes[i].cpus);
+        }
+        free(s->nodes);
+        free(s->distance);
+        free(s->cpu_node);
+        fields_free(s->fields);
+        free(s);
+    }
+}
+
+int numa_nodes_count(numa_nodes *s) {
+    if (s)
+        return s->count;
+    return 0;
+}
+
+const numa_node *numa_nodes_get(numa_nodes *s, int i) {
+    if (s)
+        if (i >= 0 && i < s->count)
+            return &s->nodes[i];
+    return NULL;
+}
+
+int numa_nodes_find(numa_nodes *s, int id) {
+    int i;
+    if (s)
+        for (i = 0; i < s->count; i++)
+            if (s->nodes[i].id == id)
+                return i;
+    return -1;
+}
+
+int numa_nodes_of_cpu(numa_nodes *s, int cpu) {
+    if (s && s->cpu_node && cpu >= 0 && cpu < s->cpu_count)
+        return s->cpu_node[cpu];
+    return -1;
+}
+
+int numa_nodes_distance(numa_nodes *s, int i, int j) {
+    if (s)
+        if (i >= 0 && i < s->count && j >= 0 && j < s->count)
+            return s->distance[i * s->count + j];
+    return 0;
+}
+
+int numa_nodes_refresh_mem(numa_nodes *s) {
+    int i;
+    if (!s) return 0;
+    for (i = 0; i < s->count; i++)
+        read_meminfo(&s->nodes[i]);
+    return 1;
+}
+
+static int numa_nodes_count_value(numa_nodes *s, rpiz_value *v) {
+    v->i = numa_nodes_count(s);
+    return 1;
+}
+
+static int numa_node_mem_total_value(numa_node *n, rpiz_value *v) {
+    v->i = n->mem_total / 1024;
+    return 1;
+}
+
+static int numa_node_mem_free_value(numa_node *n, rpiz_value *v) {
+    long long mem_free = read_mem_free(n);
+    v->i = ((mem_free < 0) ? n->mem_free : mem_free) / 1024;
+    return 1;
+}
+
+static char *numa_distance_str(numa_nodes *s, int i) {
+    char *buff;
+    int j, l = 0;
+    buff = malloc(s->count * 12 + 1);
+    if (buff) {
+        buff[0] = 0;
+        for (j = 0; j < s->count; j++)
+            l += sprintf(buff + l, "%s%d", j ? " " : "", numa_nodes_distance(s, i, j));
+    }
+    return buff;
+}
+
+#define ADDFIELDSTR(t, l, o, n, str) fields_update_bytag(s->fields, t, l, o, n, NULL, (void*)str)
+#define ADDFIELDV(t, l, n, y, f) fields_update_value_bytag(s->fields, t, l, n, y, (rpiz_fields_value_func)f, (void*)s)
+#define ADDFIELDNV(t, l, n, y, f) fields_update_value_bytag(s->fields, t, l, n, y, (rpiz_fields_value_func)f, (void*)node)
+rpiz_fields *numa_nodes_fields(numa_nodes *s) {
+    char tag[64];
+    numa_node *node;
+    int i;
+    if (s) {
+        if (!s->fields) {
+            /* first insert creates */
+            s->fields =
+            ADDFIELDV("numa.count", 0, "NUMA Nodes", FIELD_INT64, numa_nodes_count_value );
+            for (i = 0; i < s->count; i++) {
+                node = &s->nodes[i];
+                snprintf(tag, sizeof(tag), "numa.node[%d].cpus", node->id);
+                ADDFIELDSTR(tag, 0, 0, "CPUs", node->cpulist );
+                snprintf(tag, sizeof(tag), "numa.node[%d].distance", node->id);
+                ADDFIELDSTR(tag, 0, 1, "Distance", numa_distance_str(s, i) );
+                snprintf(tag, sizeof(tag), "numa.node[%d].mem_total", node->id);
+                ADDFIELDNV(tag, 0, "Memory Total", FIELD_KB, numa_node_mem_total_value );
+                snprintf(tag, sizeof(tag), "numa.node[%d].mem_free", node->id);
+                ADDFIELDNV(tag, 1, "Memory Free", FIELD_KB, numa_node_mem_free_value );
+            }
+        }
+        return s->fields;
+    }
+    return NULL;
+}
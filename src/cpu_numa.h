@@ -0,0 +1,51 @@
+/*
+ * rpiz - https://github.com/bp0/rpiz
+ * Copyright (C) 2017  Burt P. <pburt0@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+#ifndef _CPU_NUMA_H_
+#define _CPU_NUMA_H_
+
+#include "fields.h"
+#include "util.h"
+
+typedef struct {
+    int id;
+    char *cpulist;
+    cpu_mask *cpus;
+    long long mem_total; /* bytes */
+    long long mem_free;
+} numa_node;
+
+typedef struct numa_nodes numa_nodes;
+
+/* /sys/devices/system/node/node*, a machine without NUMA
+ * reports a single node 0 */
+numa_nodes *numa_nodes_new(void);
+void numa_nodes_free(numa_nodes *);
+
+int numa_nodes_count(numa_nodes *);
+const numa_node *numa_nodes_get(numa_nodes *, int i);
+int numa_nodes_find(numa_nodes *, int id); /* index of node id, -1 if not found */
+int numa_nodes_of_cpu(numa_nodes *, int cpu); /* index, -1 if cpu is in no node */
+int numa_nodes_distance(numa_nodes *, int i, int j); /* SLIT distance by index, 0 if unknown */
+int numa_nodes_refresh_mem(numa_nodes *); /* re-read meminfo for mem_free */
+
+rpiz_fields *numa_nodes_fields(numa_nodes *);
+
+#endif
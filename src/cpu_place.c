@@ -0,0 +1,279 @@
+/*
+ * rpiz - https://github.com/bp0/rpiz
+ * Copyright (C) 2017  Burt P. <pburt0@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sched.h>
+#include "cpu_place.h"
+
+enum {
+    PK_TIER = 0,
+    PK_0, PK_1, PK_2, PK_3, PK_4,
+    PK_N,
+};
+
+typedef struct {
+    int cpu;
+    int key[PK_N];
+} place_rec;
+
+static int rec_cmp(const void *a, const void *b) {
+    const place_rec *ra = a, *rb = b;
+    int i;
+    for (i = 0; i < PK_N; i++)
+        if (ra->key[i] != rb->key[i])
+            return (ra->key[i] < rb->key[i]) ? -1 : 1;
+    return (ra->cpu < rb->cpu) ? -1 : (ra->cpu > rb->cpu);
+}
+
+/* position of n among its parent's children */
+static int rank(cpu_topo *t, const topo_node *n) {
+    const topo_node *p = cpu_topo_parent(t, n);
+    if (!p) return 0;
+    return (int)(n - cpu_topo_node(t, p->first_child));
+}
+
+cpu_mask *place_affinity() {
+    cpu_set_t *set;
+    cpu_mask *m = NULL;
+    kv_scan *kv;
+    kv_slice key, value;
+    char list[4096];
+    int i, n = CPU_SETSIZE;
+    size_t size;
+
+    if (*util_root()) {
+        /* replaying another machine, our own mask means nothing */
+        kv = kv_new_file("/proc/self/status");
+        if (kv) {
+            while( kv_next(kv, &key, &value) )
+                if (KV_IS(&key, "Cpus_allowed_list")) {
+                    m = cpumask_from_list(kv_slice_copy(list, sizeof(list), &value));
+                    break;
+                }
+            kv_free(kv);
+        }
+        return m;
+    }
+
+    for (;;) {
+        set = CPU_ALLOC(n);
+        size = CPU_ALLOC_SIZE(n);
+        if (!set) return NULL;
+        CPU_ZERO_S(size, set);
+        if (sched_getaffinity(0, size, set) == 0)
+            break;
+        CPU_FREE(set);
+        if (n >= 65536) return NULL;
+        n *= 2; /* EINVAL when the kernel mask is larger */
+    }
+    m = cpumask_new(n);
+    if (m)
+        for (i = 0; i < n; i++)
+            if (CPU_ISSET_S(i, size, set))
+                cpumask_set(m, i);
+    CPU_FREE(set);
+    return m;
+}
+
+static cpu_mask *candidates(cpu_topo *t, int policy) {
+    const topo_node *machine = cpu_topo_get(t, TOPO_MACHINE, 0);
+    const topo_node *core;
+    cpu_mask *m, *aff, *core_cpus;
+    int i, cpu;
+
+    if (machine && cpumask_count(machine->cpus))
+        m = cpumask_copy(machine->cpus);
+    else
+        m = get_cpu_online();
+    if (!m) return NULL;
+
+    if (policy & PLACE_AFFINITY) {
+        aff = place_affinity();
+        if (aff) {
+            cpumask_and(m, aff);
+            cpumask_free(aff);
+        }
+    }
+
+    if (policy & PLACE_NO_SMT) {
+        for (i = 0; i < cpu_topo_count(t, TOPO_CORE); i++) {
+            core = cpu_topo_get(t, TOPO_CORE, i);
+            /* keep the first candidate in each core */
+            core_cpus = cpumask_copy(core->cpus);
+            cpumask_and(core_cpus, m);
+            cpu = cpumask_next(core_cpus, -1);
+            cpumask_andnot(m, core_cpus);
+            if (cpu >= 0)
+                cpumask_set(m, cpu);
+            cpumask_free(core_cpus);
+        }
+    }
+    return m;
+}
+
+static void make_key(cpu_topo *t, cpu_tiers *tiers, const cpu_mask *cand, place_rec *r, int policy) {
+    const topo_node *thread = cpu_topo_of_cpu(t, r->cpu, TOPO_THREAD);
+    const topo_node *core = cpu_topo_of_cpu(t, r->cpu, TOPO_CORE);
+    const topo_node *cluster = cpu_topo_of_cpu(t, r->cpu, TOPO_CLUSTER);
+    const topo_node *die = cpu_topo_of_cpu(t, r->cpu, TOPO_DIE);
+    const topo_node *package = cpu_topo_of_cpu(t, r->cpu, TOPO_PACKAGE);
+    int c, smt = 0;
+
+    memset(r->key, 0, sizeof(r->key));
+    if (policy & PLACE_PERFORMANCE)
+        r->key[PK_TIER] = cpu_tiers_of_cpu(tiers, r->cpu);
+    else if (policy & PLACE_EFFICIENCY)
+        r->key[PK_TIER] = -cpu_tiers_of_cpu(tiers, r->cpu);
+    if (!thread)
+        return; /* no topology, cpu order */
+
+    /* rank among the candidate threads of the core */
+    CPUMASK_FOR_EACH(c, core->cpus)
+        if (c < r->cpu && cpumask_test(cand, c))
+            smt++;
+
+    if (policy & PLACE_COMPACT) {
+        /* tree order, siblings next to each other */
+        r->key[PK_0] = package->index;
+        r->key[PK_1] = rank(t, die);
+        r->key[PK_2] = rank(t, cluster);
+        r->key[PK_3] = rank(t, core);
+        r->key[PK_4] = smt;
+    } else {
+        /* round-robin from the top of the tree, SMT siblings last */
+        r->key[PK_0] = smt;
+        r->key[PK_1] = rank(t, core);
+        r->key[PK_2] = rank(t, cluster);
+        r->key[PK_3] = rank(t, die);
+        r->key[PK_4] = package->index;
+    }
+}
+
+place_plan *place_plan_new(cpu_topo *t, cpu_tiers *tiers, int workers, int policy) {
+    place_plan *s;
+    place_rec *recs;
+    cpu_mask *cand;
+    int i, n, cpu;
+
+    if (workers < 1) return NULL;
+    cand = candidates(t, policy);
+    n = cpumask_count(cand);
+    if (!n) {
+        cpumask_free(cand);
+        return NULL;
+    }
+
+    recs = malloc(sizeof(place_rec) * n);
+    s = malloc( sizeof(place_plan) );
+    if (s) {
+        memset(s, 0, sizeof(*s));
+        s->cpus = malloc(sizeof(int) * workers);
+    }
+    if (!recs || !s || !s->cpus) {
+        free(recs);
+        place_plan_free(s);
+        cpumask_free(cand);
+        return NULL;
+    }
+
+    i = 0;
+    CPUMASK_FOR_EACH(cpu, cand) {
+        recs[i].cpu = cpu;
+        make_key(t, tiers, cand, &recs[i], policy);
+        i++;
+    }
+    qsort(recs, n, sizeof(place_rec), rec_cmp);
+
+    s->count = workers;
+    s->distinct = n;
+    for (i = 0; i < workers; i++)
+        s->cpus[i] = recs[i % n].cpu;
+
+    free(recs);
+    cpumask_free(cand);
+    return s;
+}
+
+void place_plan_free(place_plan *s) {
+    if (s) {
+        free(s->cpus);
+        free(s);
+    }
+}
+
+int place_plan_cpu(place_plan *s, int worker) {
+    if (s)
+        if (worker >= 0 && worker < s->count)
+            return s->cpus[worker];
+    return -1;
+}
+
+char *place_plan_str(place_plan *s) {
+    char *buff;
+    int i, l = 0;
+    if (!s) return NULL;
+    buff = malloc(s->count * 12 + 1);
+    if (buff) {
+        buff[0] = 0;
+        for (i = 0; i < s->count; i++)
+            l += sprintf(buff + l, "%s%d", i ? "," : "", s->cpus[i]);
+    }
+    return buff;
+}
+
+static cpu_set_t *one_cpu_set(int cpu, size_t *size) {
+    cpu_set_t *set = CPU_ALLOC(cpu + 1);
+    if (set) {
+        *size = CPU_ALLOC_SIZE(cpu + 1);
+        CPU_ZERO_S(*size, set);
+        CPU_SET_S(cpu, *size, set);
+    }
+    return set;
+}
+
+int place_apply_self(int cpu) {
+    cpu_set_t *set;
+    size_t size;
+    int ret;
+    if (cpu < 0) return 0;
+    set = one_cpu_set(cpu, &size);
+    if (!set) return 0;
+    ret = (sched_setaffinity(0, size, set) == 0);
+    CPU_FREE(set);
+    return ret;
+}
+
+int place_apply_thread(pthread_t thread, int cpu) {
+    cpu_set_t *set;
+    size_t size;
+    int ret;
+    if (cpu < 0) return 0;
+    set = one_cpu_set(cpu, &size);
+    if (!set) return 0;
+    ret = (pthread_setaffinity_np(thread, size, set) == 0);
+    CPU_FREE(set);
+    return ret;
+}
+
+int place_apply_worker(place_plan *s, int worker) {
+    return place_apply_self(place_plan_cpu(s, worker));
+}
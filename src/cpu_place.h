@@ -0,0 +1,59 @@
+/*
+ * rpiz - https://github.com/bp0/rpiz
+ * Copyright (C) 2017  Burt P. <pburt0@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+#ifndef _CPU_PLACE_H_
+#define _CPU_PLACE_H_
+
+#include <pthread.h>
+#include "cpu_topo.h"
+#include "cpu_tiers.h"
+
+/* policy flags, combine with | */
+#define PLACE_SPREAD      0x01 /* across packages, clusters, then cores (default) */
+#define PLACE_COMPACT     0x02 /* fill one cluster / cache domain first */
+#define PLACE_NO_SMT      0x04 /* at most one worker per core */
+#define PLACE_PERFORMANCE 0x08 /* fastest tier first */
+#define PLACE_AFFINITY    0x10 /* only cpus in the calling thread's affinity mask */
+#define PLACE_EFFICIENCY  0x20 /* slowest tier first, for background work */
+
+typedef struct {
+    int count;  /* workers */
+    int *cpus;  /* [worker] = cpu */
+    int distinct; /* cpus available to the plan, workers past this share cpus */
+} place_plan;
+
+/* a cpu for each of workers, NULL if no cpu is usable. Performance is
+ * ranked by the tiers, which may be NULL when neither PLACE_PERFORMANCE
+ * nor PLACE_EFFICIENCY is used. */
+place_plan *place_plan_new(cpu_topo *, cpu_tiers *, int workers, int policy);
+void place_plan_free(place_plan *);
+int place_plan_cpu(place_plan *, int worker); /* -1 if out of range */
+char *place_plan_str(place_plan *); /* "0,4,1,5", free() the result */
+
+/* pin to one cpu, 1 on success */
+int place_apply_self(int cpu);
+int place_apply_thread(pthread_t thread, int cpu);
+int place_apply_worker(place_plan *, int worker); /* calling thread */
+
+/* calling thread's mask, or Cpus_allowed_list below a sysroot,
+ * cpumask_free() it */
+cpu_mask *place_affinity(void);
+
+#endif
@@ -23,16 +23,16 @@
 #include <string.h>
 #include "util.h"
 #include "cpu_riscv.h"
-
-#define MAX_CORES 128
+#include "cpu_table.h"
 
 static int search_for_flag(char *flags, const char *flag) {
-    char *p = strstr(flags, flag);
+    char *p;
     int l = strlen(flag);
     int front = 0, back = 0;
     //DEBUG printf("search_for_flag( %x, \"%s\")\n", flags, flag);
-    if (strlen(flag) == 0 || strchr(flag, ' ') )
+    if (!flags || strlen(flag) == 0 || strchr(flag, ' ') )
         return 0;
+    p = strstr(flags, flag);
     while (p) {
         if (p == flags) front = 1;
         else if (*(p - 1) == ' ') front = 1;
@@ -46,9 +46,6 @@ static int search_for_flag(char *flags, const char *flag) {
 }
 
 typedef struct {
-    int id; /* hart */
-    int cpukhz_min, cpukhz_max, cpukhz_cur;
-
     /* point to a cpu_string.str */
     char *model_name;
     char *isa;
@@ -62,33 +59,68 @@ struct riscv_proc {
     cpu_string_list *flags;
     cpu_string_list *cpukhz_max_str;
 
-    cpu_string_list *each_flag;
+    char *all_flags; /* the known flags, then any others seen, after LAZY_FLAGS */
+    cpu_flagset *flagset; /* riscv_ext_id bits, then unknown flags */
 
     char cpu_name[256];
     char *cpu_desc;
     int max_khz;
+    /* per-core storage is sized to the cpuinfo: the riscv_core
+     * array holds the strings, while ids and frequencies are kept
+     * as contiguous columns */
     int core_count;
-    riscv_core cores[MAX_CORES];
+    int core_alloc;
+    riscv_core *cores;
+    int *core_id; /* hart */
+    int *khz_min, *khz_max, *khz_cur;
 
+    int lazy; /* LAZY_* parts done */
     rpiz_fields *fields;
+    cpu_table *table;
 };
 
-#define CHECK_FOR(k) (strncmp(k, key, (strlen(k) < strlen(key)) ? strlen(k) : strlen(key)) == 0)
-#define GET_STR(k, s) if (CHECK_FOR(k)) { p->cores[core].s = strlist_add(p->s, value); continue; }
+/* parts not needed to count cores, made on first use */
+#define LAZY_FREQ  0x01
+#define LAZY_DESC  0x02
+#define LAZY_FLAGS 0x04
+
+#define CHECK_FOR(k) KV_IS(&key, k)
+#define GET_STR(k, s) if (CHECK_FOR(k)) { p->cores[core].s = strlist_add_n(p->s, value.str, value.len); continue; }
 #define FIN_PROC() if (core >= 0) if (!p->cores[core].model_name) { p->cores[core].model_name = strlist_add(p->model_name, rep_pname); }
 
 #define REDUP(f) if(p->cores[di].f && !p->cores[i].f) { p->cores[i].f = strlist_add(p->f, p->cores[di].f); }
 
-#ifndef PROC_CPUINFO
-#define PROC_CPUINFO "/proc/cpuinfo"
-#endif
+#define RESIZE_COL(c, n) { void *tmp = realloc(p->c, sizeof(*p->c) * (n)); if (!tmp) return 0; p->c = tmp; }
+static int resize_cores(riscv_proc *p, int n) {
+    if (n < 1) n = 1;
+    RESIZE_COL(cores, n);
+    RESIZE_COL(core_id, n);
+    RESIZE_COL(khz_min, n);
+    RESIZE_COL(khz_max, n);
+    RESIZE_COL(khz_cur, n);
+    p->core_alloc = n;
+    return 1;
+}
+
+static int new_core(riscv_proc *p, int core, int id) {
+    int n = p->core_alloc ? p->core_alloc : 8;
+    if (core >= p->core_alloc) {
+        while (n <= core) n *= 2;
+        if (!resize_cores(p, n))
+            return 0;
+    }
+    memset(&p->cores[core], 0, sizeof(riscv_core));
+    p->core_id[core] = id;
+    p->khz_min[core] = p->khz_max[core] = p->khz_cur[core] = 0;
+    return 1;
+}
 
 static int scan_cpu(riscv_proc* p) {
-    kv_scan *kv; char *key, *value;
+    kv_scan *kv; kv_slice key, value;
     int core = -1;
     int i, di;
     char rep_pname[256] = "RISC-V Processor";
-    char tmp_maxfreq[128] = "";
+    char *tmp_flags = NULL;
 
     if (!p) return 0;
 
@@ -96,15 +128,15 @@ static int scan_cpu(riscv_proc* p) {
     if (kv) {
         while( kv_next(kv, &key, &value) ) {
             if (CHECK_FOR("Processor")) {
-                strcpy(rep_pname, value);
+                kv_slice_copy(rep_pname, sizeof(rep_pname), &value);
                 continue;
             }
 
             if (CHECK_FOR("hart")) {
                 FIN_PROC();
+                if (!new_core(p, core + 1, atoi(value.str)))
+                    break;
                 core++;
-                memset(&p->cores[core], 0, sizeof(riscv_core));
-                p->cores[core].id = atoi(value);
                 continue;
             }
 
@@ -114,9 +146,9 @@ static int scan_cpu(riscv_proc* p) {
                      || CHECK_FOR("isa") ) {
                     /* this cpuinfo doesn't provide hart : n
                      * there is prolly only one core */
+                    if (!new_core(p, core + 1, 0))
+                        break;
                     core++;
-                    memset(&p->cores[core], 0, sizeof(riscv_core));
-                    p->cores[core].id = 0;
                 }
             }
             if (core >= 0) {
@@ -130,6 +162,8 @@ static int scan_cpu(riscv_proc* p) {
         return 0;
 
     p->core_count = core + 1;
+    /* trim to size */
+    resize_cores(p, p->core_count);
 
     /* re-duplicate missing data for /proc/cpuinfo variant that de-duplicated it */
     di = p->core_count - 1;
@@ -144,19 +178,27 @@ static int scan_cpu(riscv_proc* p) {
     /* data not from /proc/cpuinfo */
     for (i = 0; i < p->core_count; i++) {
         /* flags */
-        p->cores[i].flags = riscv_isa_to_flags(p->cores[i].isa);
-
-        /* freq */
-        get_cpu_freq(p->cores[i].id, &p->cores[i].cpukhz_min, &p->cores[i].cpukhz_max, &p->cores[i].cpukhz_cur);
-        sprintf(tmp_maxfreq, "%d", p->cores[i].cpukhz_max);
-        p->cores[i].cpukhz_max_str = strlist_add(p->cpukhz_max_str, tmp_maxfreq);
-        if (p->cores[i].cpukhz_max > p->max_khz)
-            p->max_khz = p->cores[i].cpukhz_max;
+        tmp_flags = riscv_isa_to_flags(p->cores[i].isa);
+        if (tmp_flags)
+            p->cores[i].flags = strlist_add(p->flags, tmp_flags);
+        free(tmp_flags); tmp_flags = NULL;
     }
 
     return 1;
 }
 
+static void scan_freq(riscv_proc *p) {
+    char tmp_maxfreq[128];
+    int i;
+    get_cpu_freq_batch(p->core_id, p->core_count, p->khz_min, p->khz_max, p->khz_cur);
+    for (i = 0; i < p->core_count; i++) {
+        sprintf(tmp_maxfreq, "%d", p->khz_max[i]);
+        p->cores[i].cpukhz_max_str = strlist_add(p->cpukhz_max_str, tmp_maxfreq);
+        if (p->khz_max[i] > p->max_khz)
+            p->max_khz = p->khz_max[i];
+    }
+}
+
 static char *gen_cpu_desc(riscv_proc *p) {
     char *ret = NULL;
     char tmp[1024];
@@ -185,43 +227,98 @@ static char *gen_cpu_desc(riscv_proc *p) {
     return ret;
 }
 
-#define APPEND_FLAG(f) strcat(all_flags, f); strcat(all_flags, " ");
+/* list + flag + " " */
+static char *append_flag(char *list, const char *flag) {
+    int l = strlen(list), fl = strlen(flag);
+    char *tmp = realloc(list, l + fl + 2);
+    if (!tmp) return list;
+    memcpy(tmp + l, flag, fl);
+    tmp[l + fl] = ' ';
+    tmp[l + fl + 1] = 0;
+    return tmp;
+}
+
+#define APPEND_FLAG(f) s->all_flags = append_flag(s->all_flags, f);
 static void process_flags(riscv_proc *s) {
     char flag[16] = "";
-    char *all_flags; /* riscv_data.c: static char all_flags[1024] */
-    char *cur, *next;
-    int added_count = 0, i;
-    if (!s) return;
-
-    all_flags = (char*)riscv_ext_list();
-    for(i = 0; i < s->flags->count; i++) {
-        if (s->flags->strs[i].str) {
-            cur = s->flags->strs[i].str;
-            next = strchr(cur, ' '); if (!next) next = strchr(cur, '\0');
-            while(next) {
-                if (next-cur <= 15) {
-                    memset(flag, 0, 16);
-                    strncpy(flag, cur, next-cur);
-                    if (strlen(flag) > 0) {
-                        /* add it to the string list, copy the flag string's ref_count */
-                        strlist_add_w(s->each_flag, flag, s->flags->strs[i].ref_count);
-
-                        /* add it to the list of known all flags, if it isn't there */
-                        if (!search_for_flag(all_flags, flag)) {
-                            APPEND_FLAG(flag);
-                            added_count++;
+    char *cur, *next, *ver;
+    unsigned long long *sbits = NULL;
+    int added_count = 0, i, id, pass, n, flen, words = 0;
+    if (!s || !s->flagset) return;
+
+    s->all_flags = strdup(riscv_ext_list());
+    if (!s->all_flags) return;
+
+    /* pass 0 gives every flag a bit, pass 1 sets the bits
+     * for each distinct flags string */
+    for(pass = 0; pass < 2; pass++) {
+        if (pass == 1) {
+            if (!flagset_alloc(s->flagset, s->core_count))
+                return;
+            words = s->flagset->words;
+            sbits = calloc((size_t)s->flags->count * words + 1, sizeof(unsigned long long));
+            if (!sbits) return;
+        }
+        for(i = 0; i < s->flags->count; i++) {
+            if (s->flags->strs[i].str) {
+                cur = s->flags->strs[i].str;
+                next = strchr(cur, ' '); if (!next) next = strchr(cur, '\0');
+                while(next) {
+                    /* extension:version, the bit is for the extension */
+                    ver = memchr(cur, ':', next-cur);
+                    flen = (ver) ? ver-cur : next-cur;
+                    if (flen > 0 && flen <= 15) {
+                        memcpy(flag, cur, flen);
+                        flag[flen] = 0;
+                        if (pass == 0) {
+                            n = s->flagset->ids->count;
+                            id = flagset_id(s->flagset, flag, flen, 1);
+                            /* add it to the list of known all flags, if it isn't there */
+                            if (id == n && !search_for_flag(s->all_flags, flag)) {
+                                APPEND_FLAG(flag);
+                                added_count++;
+                            }
+                        } else {
+                            id = flagset_id(s->flagset, flag, flen, 0);
+                            if (id >= 0)
+                                FLAGSET_BIT_SET(sbits + (size_t)i * words, id);
                         }
                     }
+                    if (*next == '\0') break;
+                    cur = next + 1;
+                    next = strchr(cur, ' '); if (!next) next = strchr(cur, '\0');
                 }
-                if (*next == '\0') break;
-                cur = next + 1;
-                next = strchr(cur, ' '); if (!next) next = strchr(cur, '\0');
             }
         }
     }
+
+    for(i = 0; i < s->core_count; i++) {
+        n = strlist_find(s->flags, s->cores[i].flags);
+        if (n >= 0)
+            flagset_or(s->flagset, i, sbits + (size_t)n * words);
+    }
+    flagset_count_rows(s->flagset);
+    free(sbits);
     // DEBUG printf("add_unknown_flags(): added %d previously unknown flags\n", added_count);
 }
 
+static void make_desc(riscv_proc *p) {
+    p->cpu_desc = gen_cpu_desc(p);
+}
+
+static void need_freq(riscv_proc *p) {
+    lazy_once(&p->lazy, LAZY_FREQ, (lazy_func)scan_freq, p);
+}
+
+static void need_desc(riscv_proc *p) {
+    need_freq(p);
+    lazy_once(&p->lazy, LAZY_DESC, (lazy_func)make_desc, p);
+}
+
+static void need_flags(riscv_proc *p) {
+    lazy_once(&p->lazy, LAZY_FLAGS, (lazy_func)process_flags, p);
+}
+
 riscv_proc *riscv_proc_new(void) {
     riscv_proc *s = malloc( sizeof(riscv_proc) );
     if (s) {
@@ -230,13 +327,11 @@ riscv_proc *riscv_proc_new(void) {
         s->isa = strlist_new();
         s->flags = strlist_new();
         s->cpukhz_max_str = strlist_new();
-        s->each_flag = strlist_new();
+        s->flagset = flagset_new(riscv_ext_name, RISCV_EXT_N_KNOWN);
         if (!scan_cpu(s)) {
             riscv_proc_free(s);
             return NULL;
         }
-        s->cpu_desc = gen_cpu_desc(s);
-        process_flags(s);
     }
     return s;
 }
@@ -247,8 +342,15 @@ void riscv_proc_free(riscv_proc *s) {
         strlist_free(s->isa);
         strlist_free(s->flags);
         strlist_free(s->cpukhz_max_str);
-        strlist_free(s->each_flag);
+        flagset_free(s->flagset);
+        free(s->all_flags);
         fields_free(s->fields);
+        cpu_table_free(s->table);
+        free(s->cores);
+        free(s->core_id);
+        free(s->khz_min);
+        free(s->khz_max);
+        free(s->khz_cur);
         free(s->cpu_desc);
         free(s);
     }
@@ -262,20 +364,51 @@ const char *riscv_proc_name(riscv_proc *s) {
 }
 
 const char *riscv_proc_desc(riscv_proc *s) {
-    if (s)
+    if (s) {
+        need_desc(s);
         return s->cpu_desc;
+    }
     else
         return NULL;
 }
 
-int riscv_proc_has_flag(riscv_proc *s, const char *flag) {
-    int i;
+const char *riscv_proc_flag_list(riscv_proc *s) {
+    /* flags not in the table are appended as they are processed */
+    if (s) {
+        need_flags(s);
+        if (s->all_flags)
+            return s->all_flags;
+    }
+    return riscv_ext_list();
+}
+
+int riscv_proc_flag_id(riscv_proc *s, const char *flag) {
+    const char *ver;
     if (s && flag) {
-        for (i = 0; i < s->each_flag->count; i++) {
-            //DEBUG printf("(%s)...[%d/%d] %s %d\n", flag, i, s->each_flag->count, s->each_flag->strs[i].str, s->each_flag->strs[i].ref_count);
-            if (strcmp(s->each_flag->strs[i].str, flag) == 0)
-                return s->each_flag->strs[i].ref_count;
-        }
+        /* allow extension:version, ignore version */
+        ver = strchr(flag, ':');
+        need_flags(s);
+        return flagset_id(s->flagset, flag, (ver) ? ver - flag : (int)strlen(flag), 0);
+    }
+    return -1;
+}
+
+int riscv_proc_has_flag(riscv_proc *s, const char *flag) {
+    return riscv_proc_has_feature(s, riscv_proc_flag_id(s, flag));
+}
+
+int riscv_proc_has_feature(riscv_proc *s, int id) {
+    if (s) {
+        need_flags(s);
+        return flagset_count(s->flagset, id);
+    }
+    return 0;
+}
+
+int riscv_proc_core_has_feature(riscv_proc *s, int core, int id) {
+    if (s) {
+        need_flags(s);
+        return flagset_test(s->flagset, core, id);
     }
     return 0;
 }
@@ -291,7 +424,7 @@ int riscv_proc_core_from_id(riscv_proc *s, int id) {
     int i = 0;
     if (s)
         for (i = 0; i < s->core_count; i++ )
-            if (s->cores[i].id == id)
+            if (s->core_id[i] == id)
                 return i;
 
     return -1;
@@ -300,23 +433,35 @@ int riscv_proc_core_from_id(riscv_proc *s, int id) {
 int riscv_proc_core_id(riscv_proc *s, int core) {
     if (s)
         if (core >= 0 && core < s->core_count)
-            return s->cores[core].id;
+            return s->core_id[core];
 
     return 0;
 }
 
-int riscv_proc_core_khz_min(riscv_proc *s, int core) {
+const char *riscv_proc_core_model_name(riscv_proc *s, int core) {
     if (s)
         if (core >= 0 && core < s->core_count)
-            return s->cores[core].cpukhz_min;
+            return s->cores[core].model_name;
+
+    return NULL;
+}
+
+int riscv_proc_core_khz_min(riscv_proc *s, int core) {
+    if (s)
+        if (core >= 0 && core < s->core_count) {
+            need_freq(s);
+            return s->khz_min[core];
+        }
 
     return 0;
 }
 
 int riscv_proc_core_khz_max(riscv_proc *s, int core) {
     if (s)
-        if (core >= 0 && core < s->core_count)
-            return s->cores[core].cpukhz_max;
+        if (core >= 0 && core < s->core_count) {
+            need_freq(s);
+            return s->khz_max[core];
+        }
 
     return 0;
 }
@@ -324,27 +469,54 @@ int riscv_proc_core_khz_max(riscv_proc *s, int core) {
 int riscv_proc_core_khz_cur(riscv_proc *s, int core) {
     if (s)
         if (core >= 0 && core < s->core_count) {
-            get_cpu_freq(s->cores[core].id, NULL, NULL, &s->cores[core].cpukhz_cur);
-            return s->cores[core].cpukhz_cur;
+            need_freq(s);
+            get_cpu_freq(s->core_id[core], NULL, NULL, &s->khz_cur[core]);
+            return s->khz_cur[core];
         }
     return 0;
 }
 
-static char* riscv_proc_cores_str(riscv_proc *s) {
-    char *buff = NULL;
+static int riscv_proc_cores_value(riscv_proc *s, rpiz_value *v) {
+    v->i = riscv_proc_cores(s);
+    return 1;
+}
+
+static void refresh_khz_cur(riscv_proc *s) {
+    get_cpu_freq_cur_batch(s->core_id, s->core_count, s->khz_cur);
+}
+
+#define ADDCOL(n, l, t, f, fl, ff) cpu_table_add(s->table, n, l, t, &s->cores[0].f, sizeof(riscv_core), fl, ff)
+#define ADDCOLINT(n, c, fl) cpu_table_add(s->table, n, NULL, CELL_INT, s->c, sizeof(int), fl, NULL)
+/* the flat fields use it without the freq columns, so only
+ * riscv_proc_table() reads those */
+static cpu_table *make_table(riscv_proc *s) {
     if (s) {
-        buff = malloc(128);
-        if (buff)
-            snprintf(buff, 127, "%d", riscv_proc_cores(s) );
+        if (!s->table) {
+            s->table = cpu_table_new(s->core_count, s->core_id, s);
+            if (!s->table) return NULL;
+            ADDCOL("model_name", "linux name", CELL_STR, model_name, COL_FLAT, NULL);
+            ADDCOL("isa",        "isa",        CELL_STR, isa,        COL_FLAT, NULL);
+            ADDCOL("flags",      NULL,         CELL_STR, flags,      0,        NULL);
+            ADDCOLINT("khz_min", khz_min, 0);
+            ADDCOLINT("khz_max", khz_max, 0);
+            ADDCOLINT("khz_cur", khz_cur, COL_LIVE);
+            cpu_table_set_refresh(s->table, (cpu_table_refresh_func)refresh_khz_cur);
+        }
+        return s->table;
     }
-    return buff;
+    return NULL;
+}
+
+cpu_table *riscv_proc_table(riscv_proc *s) {
+    if (s)
+        need_freq(s);
+    return make_table(s);
 }
 
 #define ADDFIELD(t, l, o, n, f) fields_update_bytag(s->fields, t, l, o, n, (rpiz_fields_get_func)f, (void*)s)
 #define ADDFIELDSTR(t, l, o, n, str) fields_update_bytag(s->fields, t, l, o, n, NULL, (void*)str)
+#define ADDFIELDV(t, l, n, y, f) fields_update_value_bytag(s->fields, t, l, n, y, (rpiz_fields_value_func)f, (void*)s)
 rpiz_fields *riscv_proc_fields(riscv_proc *s) {
-    int i;
-    char bn[256] = "", bt[256] = "", bv[256] = "", *bvp;
     if (s) {
         if (!s->fields) {
             /* first insert creates */
@@ -352,20 +524,8 @@ rpiz_fields *riscv_proc_fields(riscv_proc *s) {
             ADDFIELD("summary.proc_desc", 0, 0, "Proccesor", riscv_proc_desc );
             ADDFIELD("cpu.name",          0, 0, "Proccesor Name", riscv_proc_name );
             ADDFIELD("cpu.desc",          0, 0, "Proccesor Description", riscv_proc_desc );
-            ADDFIELD("cpu.count",         0, 1, "Core Count", riscv_proc_cores_str );
-
-            for(i = 0; i < s->core_count; i++) {
-                sprintf(bt, "cpu.thread[%d].model_name", i);
-                sprintf(bn, "[%d] linux name", s->cores[i].id);
-                sprintf(bv, "%s", s->cores[i].model_name);
-                bvp = strdup(bv); ADDFIELDSTR(bt, 0, 1, bn, bvp);
-
-                sprintf(bt, "cpu.thread[%d].isa", i);
-                sprintf(bn, "[%d] isa", s->cores[i].id);
-                sprintf(bv, "%s", s->cores[i].isa);
-                bvp = strdup(bv); ADDFIELDSTR(bt, 0, 1, bn, bvp);
-            }
-
+            ADDFIELDV("cpu.count",        0, "Core Count", FIELD_INT64, riscv_proc_cores_value );
+            cpu_table_flat_fields(make_table(s), s->fields, "cpu.thread");
         }
         return s->fields;
     }
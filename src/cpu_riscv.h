@@ -22,6 +22,7 @@
 #define _RISCVCPU_H_
 
 #include "fields.h"
+#include "cpu_table.h"
 
 #include "riscv_data.h"
 const char *riscv_flag_list(void);
@@ -33,14 +34,20 @@ void riscv_proc_free(riscv_proc *);
 
 const char *riscv_proc_name(riscv_proc *);
 const char *riscv_proc_desc(riscv_proc *);
+const char *riscv_proc_flag_list(riscv_proc *); /* riscv_ext_list() with any unknown flags seen, owned by the riscv_proc */
 int riscv_proc_has_flag(riscv_proc *, const char *flag); /* returns core count with flag */
+int riscv_proc_flag_id(riscv_proc *, const char *flag); /* riscv_ext_id, or a dynamic id for unknown flags, -1 if not seen */
+int riscv_proc_has_feature(riscv_proc *, int id); /* returns core count with flag id */
+int riscv_proc_core_has_feature(riscv_proc *, int core, int id);
 int riscv_proc_cores(riscv_proc *);
 int riscv_proc_core_from_id(riscv_proc *, int id); /* -1 if not found */
 int riscv_proc_core_id(riscv_proc *, int core);
+const char *riscv_proc_core_model_name(riscv_proc *, int core);
 int riscv_proc_core_khz_min(riscv_proc *, int core);
 int riscv_proc_core_khz_max(riscv_proc *, int core);
 int riscv_proc_core_khz_cur(riscv_proc *, int core);
 
+cpu_table *riscv_proc_table(riscv_proc *); /* one row per core, owned by the riscv_proc */
 rpiz_fields *riscv_proc_fields(riscv_proc *);
 
 #endif
@@ -0,0 +1,267 @@
+/*
+ * rpiz - https://github.com/bp0/rpiz
+ * Copyright (C) 2017  Burt P. <pburt0@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "cpu_sampler.h"
+
+typedef struct {
+    int cpu;
+    int fd;
+    /* written by the sampling thread only */
+    long long count, sum;
+    int min, max;
+} sampler_cpu;
+
+struct freq_sampler {
+    int count;
+    sampler_cpu *cpus;
+    int cpu_count; /* highest cpu + 1 */
+    int *cpu_index; /* [cpu] = index into cpus, or -1 */
+
+    freq_sample *ring;
+    unsigned long ring_mask;
+    unsigned long head; /* next write, producer */
+    unsigned long tail; /* next read, consumer */
+    long long dropped;
+
+    long long passes, overhead_ns;
+
+    pthread_t thread;
+    int running, stop;
+    int hz;
+};
+
+#define LOAD(v) __atomic_load_n(&(v), __ATOMIC_ACQUIRE)
+#define STORE(v, x) __atomic_store_n(&(v), (x), __ATOMIC_RELEASE)
+#define LOAD_RELAXED(v) __atomic_load_n(&(v), __ATOMIC_RELAXED)
+#define ADD_RELAXED(v, x) __atomic_fetch_add(&(v), (x), __ATOMIC_RELAXED)
+
+static long long time_ns(void) {
+    struct timespec tv;
+    clock_gettime(CLOCK_MONOTONIC, &tv);
+    return (long long)tv.tv_sec*1000000000LL + tv.tv_nsec;
+}
+
+freq_sampler *freq_sampler_new(const cpu_mask *cpus, int ring_size) {
+    freq_sampler *s;
+    cpu_mask *online = NULL;
+    char fn[128], path[640];
+    unsigned long size = 1;
+    int cpu, fd;
+
+    if (!cpus)
+        cpus = online = get_cpu_online();
+
+    s = malloc( sizeof(freq_sampler) );
+    if (!s) {
+        cpumask_free(online);
+        return NULL;
+    }
+    memset(s, 0, sizeof(*s));
+
+    while ((int)size < ring_size) size <<= 1;
+    s->ring = malloc(sizeof(freq_sample) * size);
+    s->ring_mask = size - 1;
+    s->cpus = malloc(sizeof(sampler_cpu) * (cpumask_count(cpus) + 1));
+    CPUMASK_FOR_EACH(cpu, cpus)
+        s->cpu_count = cpu + 1;
+    s->cpu_index = malloc(sizeof(int) * (s->cpu_count + 1));
+    if (!s->ring || !s->cpus || !s->cpu_index) {
+        cpumask_free(online);
+        freq_sampler_free(s);
+        return NULL;
+    }
+    memset(s->cpu_index, 0xff, sizeof(int) * (s->cpu_count + 1));
+
+    CPUMASK_FOR_EACH(cpu, cpus) {
+        snprintf(fn, sizeof(fn), "/sys/devices/system/cpu/cpu%d/cpufreq/scaling_cur_freq", cpu);
+        fd = open(util_path(path, sizeof(path), fn), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) continue;
+        memset(&s->cpus[s->count], 0, sizeof(sampler_cpu));
+        s->cpus[s->count].cpu = cpu;
+        s->cpus[s->count].fd = fd;
+        s->cpu_index[cpu] = s->count;
+        s->count++;
+    }
+    cpumask_free(online);
+    return s;
+}
+
+void freq_sampler_free(freq_sampler *s) {
+    int i;
+    if (s) {
+        freq_sampler_stop(s);
+        if (s->cpus)
+            for (i = 0; i < s->count; i++)
+                close(s->cpus[i].fd);
+        free(s->cpus);
+        free(s->cpu_index);
+        free(s->ring);
+        free(s);
+    }
+}
+
+int freq_sampler_cpus(freq_sampler *s) {
+    if (s)
+        return s->count;
+    return 0;
+}
+
+static int read_khz(int fd, char *buff, int size) {
+    int r, v = 0;
+    char *p;
+    r = pread(fd, buff, size - 1, 0);
+    if (r <= 0)
+        return -1;
+    for (p = buff; p < buff + r && *p >= '0' && *p <= '9'; p++)
+        v = v * 10 + (*p - '0');
+    return v;
+}
+
+static void push(freq_sampler *s, const freq_sample *fs) {
+    unsigned long head = s->head; /* only we write head */
+    if (head - LOAD(s->tail) > s->ring_mask) {
+        ADD_RELAXED(s->dropped, 1);
+        return;
+    }
+    s->ring[head & s->ring_mask] = *fs;
+    STORE(s->head, head + 1);
+}
+
+/* only one thread may sample at a time, the ring has one producer */
+int freq_sampler_sample(freq_sampler *s) {
+    char buff[32];
+    freq_sample fs;
+    sampler_cpu *c;
+    long long start, now;
+    int i, n = 0;
+
+    if (!s) return 0;
+    start = time_ns();
+    for (i = 0; i < s->count; i++) {
+        c = &s->cpus[i];
+        fs.khz = read_khz(c->fd, buff, sizeof(buff));
+        if (fs.khz < 0) continue;
+        fs.cpu = c->cpu;
+        fs.t_ns = time_ns();
+        push(s, &fs);
+
+        if (!c->count || fs.khz < c->min) STORE(c->min, fs.khz);
+        if (!c->count || fs.khz > c->max) STORE(c->max, fs.khz);
+        STORE(c->sum, c->sum + fs.khz);
+        STORE(c->count, c->count + 1);
+        n++;
+    }
+    now = time_ns();
+    ADD_RELAXED(s->overhead_ns, now - start);
+    ADD_RELAXED(s->passes, 1);
+    return n;
+}
+
+static void *sampler_main(void *data) {
+    freq_sampler *s = data;
+    struct timespec next;
+    long long period = 1000000000LL / s->hz;
+
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (!LOAD(s->stop)) {
+        freq_sampler_sample(s);
+        /* absolute deadlines, so sampling time does not drift the rate */
+        next.tv_nsec += period;
+        while (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR);
+    }
+    return NULL;
+}
+
+int freq_sampler_start(freq_sampler *s, int hz) {
+    if (!s || s->running || hz <= 0 || hz > 1000000)
+        return 0;
+    s->hz = hz;
+    STORE(s->stop, 0);
+    if (pthread_create(&s->thread, NULL, sampler_main, s) != 0)
+        return 0;
+    s->running = 1;
+    return 1;
+}
+
+void freq_sampler_stop(freq_sampler *s) {
+    if (s && s->running) {
+        STORE(s->stop, 1);
+        pthread_join(s->thread, NULL);
+        s->running = 0;
+    }
+}
+
+int freq_sampler_read(freq_sampler *s, freq_sample *out, int max) {
+    unsigned long tail, head;
+    int n = 0;
+    if (!s || !out) return 0;
+    tail = s->tail; /* only we write tail */
+    head = LOAD(s->head);
+    while (tail != head && n < max)
+        out[n++] = s->ring[tail++ & s->ring_mask];
+    STORE(s->tail, tail);
+    return n;
+}
+
+long long freq_sampler_dropped(freq_sampler *s) {
+    if (s)
+        return LOAD_RELAXED(s->dropped);
+    return 0;
+}
+
+int freq_sampler_stats(freq_sampler *s, int cpu, freq_stats *stats) {
+    sampler_cpu *c;
+    long long count, sum;
+    if (!s || !stats || cpu < 0 || cpu >= s->cpu_count || s->cpu_index[cpu] < 0)
+        return 0;
+    c = &s->cpus[s->cpu_index[cpu]];
+    /* may be a sample apart while the thread runs, good enough for stats */
+    count = LOAD(c->count);
+    sum = LOAD(c->sum);
+    stats->count = count;
+    stats->min = LOAD(c->min);
+    stats->max = LOAD(c->max);
+    stats->mean = count ? (double)sum / count : 0;
+    return count > 0;
+}
+
+long long freq_sampler_passes(freq_sampler *s) {
+    if (s)
+        return LOAD_RELAXED(s->passes);
+    return 0;
+}
+
+long long freq_sampler_overhead_ns(freq_sampler *s) {
+    if (s)
+        return LOAD_RELAXED(s->overhead_ns);
+    return 0;
+}
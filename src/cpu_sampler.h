@@ -0,0 +1,67 @@
+/*
+ * rpiz - https://github.com/bp0/rpiz
+ * Copyright (C) 2017  Burt P. <pburt0@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+#ifndef _CPU_SAMPLER_H_
+#define _CPU_SAMPLER_H_
+
+#include "util.h"
+
+typedef struct {
+    long long t_ns; /* CLOCK_MONOTONIC */
+    int cpu;
+    int khz;
+} freq_sample;
+
+typedef struct {
+    int count;
+    int min, max; /* khz */
+    double mean;
+} freq_stats;
+
+typedef struct freq_sampler freq_sampler;
+
+/* Keeps cpufreq/scaling_cur_freq open for each cpu and reads it with
+ * pread() into a preallocated buffer, no allocation per sample.
+ * cpus NULL is every online cpu, ring_size is rounded up to a power
+ * of two samples. */
+freq_sampler *freq_sampler_new(const cpu_mask *cpus, int ring_size);
+void freq_sampler_free(freq_sampler *); /* stops the thread */
+
+int freq_sampler_cpus(freq_sampler *); /* cpus with an open fd */
+int freq_sampler_sample(freq_sampler *); /* one pass over all cpus, returns samples taken */
+
+/* sample on a background thread at hz passes per second */
+int freq_sampler_start(freq_sampler *, int hz);
+void freq_sampler_stop(freq_sampler *);
+
+/* The ring has one producer (the sampler) and one consumer: read
+ * takes up to max samples, oldest first. When the ring is full new
+ * samples are dropped and counted. */
+int freq_sampler_read(freq_sampler *, freq_sample *out, int max);
+long long freq_sampler_dropped(freq_sampler *);
+
+/* since the sampler was created, not just what is still in the ring */
+int freq_sampler_stats(freq_sampler *, int cpu, freq_stats *stats);
+
+/* time spent inside the sampling passes */
+long long freq_sampler_passes(freq_sampler *);
+long long freq_sampler_overhead_ns(freq_sampler *);
+
+#endif
@@ -0,0 +1,649 @@
+/*
+ * rpiz - https://github.com/bp0/rpiz
+ * Copyright (C) 2017  Burt P. <pburt0@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "util.h"
+#include "cpu_sampler.h"
+#include "cpu_shm.h"
+
+#define SHM_MAGIC 0x4d48535550435052ULL /* "RPCPUSHM" */
+#define SHM_TEXT_SIZE 64 /* a live value's text, longer is cut */
+
+/* What the writer publishes is copied a word at a time with atomics on
+ * both sides; a copy the writer overlapped is caught by the sequence
+ * count and redone. */
+typedef unsigned long long shm_word;
+
+enum {
+    SLOT_NONE,
+    SLOT_TEXT,
+    SLOT_TYPED,
+};
+
+typedef struct {
+    rpiz_value val;
+    shm_word state; /* a word, so a slot is whole words */
+    char text[SHM_TEXT_SIZE];
+} shm_slot;
+
+typedef struct {
+    unsigned int tag, name; /* offsets into the strings */
+    unsigned int value; /* a fixed value's text, 0 for none */
+    unsigned int hash; /* of the tag */
+    shm_word live; /* the value is in slot instead */
+    shm_slot slot;
+} shm_field;
+
+typedef struct {
+    int cpu, khz, util_pm, unused;
+} shm_core;
+
+#define WORDS(t) (sizeof(t) / sizeof(shm_word))
+typedef char shm_slot_is_words[(sizeof(shm_slot) % sizeof(shm_word)) ? -1 : 1];
+typedef char shm_core_is_words[(sizeof(shm_core) % sizeof(shm_word)) ? -1 : 1];
+
+/* at the start of the segment; all offsets are from there */
+typedef struct {
+    unsigned long long magic; /* stored last, once the rest is in place */
+    unsigned int version;
+    unsigned int closed; /* the writer is gone */
+    unsigned int field_count, hash_size; /* hash_size a power of two */
+    unsigned int core_count, unused;
+    unsigned long long fields_off, hash_off, cores_off, strings_off, size;
+    /* from here on under seq */
+    unsigned long long seq; /* odd while the writer publishes */
+    long long gen, t_ns;
+    long long temp_mc; /* thermal_zone0, -1 if unknown */
+} shm_header;
+
+struct cpu_shm {
+    char name[256];
+    shm_header *h;
+    size_t size;
+    shm_field *fields;
+    unsigned int *hash; /* field index + 1, 0 for empty */
+    shm_core *cores;
+    char *strings;
+    unsigned long long strings_size;
+
+    /* the writer's */
+    int writer;
+    rpiz_fields **src; /* [field] */
+    int *live; /* indexes of the live fields */
+    int live_count;
+    shm_slot *scratch; /* [live_count], sampled before the seq is taken */
+    shm_core *core_scratch;
+    int *core_index; /* [cpu] = index into cores, or -1 */
+    int cpu_count; /* highest cpu + 1 */
+    long long *prev_busy, *prev_total;
+    freq_sampler *fs;
+    freq_sample *samples;
+    char *stat;
+    int stat_size;
+};
+
+#define LOAD(v) __atomic_load_n(&(v), __ATOMIC_ACQUIRE)
+#define STORE(v, x) __atomic_store_n(&(v), (x), __ATOMIC_RELEASE)
+#define LOAD_RELAXED(v) __atomic_load_n(&(v), __ATOMIC_RELAXED)
+#define STORE_RELAXED(v, x) __atomic_store_n(&(v), (x), __ATOMIC_RELAXED)
+
+static long long time_ns(void) {
+    struct timespec tv;
+    clock_gettime(CLOCK_MONOTONIC, &tv);
+    return (long long)tv.tv_sec*1000000000LL + tv.tv_nsec;
+}
+
+static unsigned int shm_hash(const char *tag) {
+    unsigned int h = 2166136261u;
+    while (*tag) {
+        h ^= (unsigned char)*tag++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void words_store(void *dst, const void *src, int words) {
+    shm_word *d = dst;
+    const shm_word *w = src;
+    int i;
+    for (i = 0; i < words; i++)
+        STORE_RELAXED(d[i], w[i]);
+}
+
+static void words_load(void *dst, const void *src, int words) {
+    shm_word *d = dst;
+    const shm_word *w = src;
+    int i;
+    for (i = 0; i < words; i++)
+        d[i] = LOAD_RELAXED(w[i]);
+}
+
+/* A reader waits out a publish, which is only copies. A writer killed
+ * inside one leaves seq odd for good, so the wait is bounded. */
+#define READ_SPINS (1 << 20)
+static int read_begin(shm_header *h, unsigned long long *seq) {
+    int spins = 0;
+    while ((*seq = LOAD(h->seq)) & 1)
+        if (++spins > READ_SPINS)
+            return 0;
+    return 1;
+}
+
+static int read_retry(shm_header *h, unsigned long long seq) {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return LOAD_RELAXED(h->seq) != seq;
+}
+
+static int map_segment(cpu_shm *s, int fd, int prot) {
+    void *p = mmap(NULL, s->size, prot, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED)
+        return 0;
+    s->h = p;
+    return 1;
+}
+
+static void set_pointers(cpu_shm *s) {
+    char *base = (char *)s->h;
+    s->fields = (shm_field *)(base + s->h->fields_off);
+    s->hash = (unsigned int *)(base + s->h->hash_off);
+    s->cores = (shm_core *)(base + s->h->cores_off);
+    s->strings = base + s->h->strings_off;
+    s->strings_size = s->h->size - s->h->strings_off;
+}
+
+/* NULL for an offset outside the strings */
+static const char *shm_string(cpu_shm *s, unsigned int off) {
+    if (off < s->strings_size)
+        return s->strings + off;
+    return NULL;
+}
+
+static int region_ok(unsigned long long off, unsigned long long len, unsigned long long size) {
+    return off >= sizeof(shm_header) && off <= size && len <= size - off;
+}
+
+/* a reader maps whatever is in the name, so every offset and count is
+ * checked once here against the size and the accessors trust them */
+static int layout_ok(cpu_shm *s) {
+    shm_header *h = s->h;
+    unsigned int i;
+    if (h->size > s->size)
+        return 0;
+    if (!h->hash_size || (h->hash_size & (h->hash_size - 1)) || h->hash_size <= h->field_count)
+        return 0; /* find() needs an empty bucket to stop at */
+    if (h->fields_off % sizeof(shm_word) || h->cores_off % sizeof(shm_word)
+        || h->hash_off % sizeof(unsigned int))
+        return 0;
+    if (!region_ok(h->fields_off, (unsigned long long)sizeof(shm_field) * h->field_count, h->size)
+        || !region_ok(h->hash_off, (unsigned long long)sizeof(unsigned int) * h->hash_size, h->size)
+        || !region_ok(h->cores_off, (unsigned long long)sizeof(shm_core) * h->core_count, h->size)
+        || !region_ok(h->strings_off, 1, h->size))
+        return 0;
+    set_pointers(s);
+    /* so every string ends inside */
+    if (s->strings[s->strings_size - 1])
+        return 0;
+    for (i = 0; i < h->field_count; i++)
+        if (!shm_string(s, s->fields[i].tag) || !shm_string(s, s->fields[i].name)
+            || !shm_string(s, s->fields[i].value))
+            return 0;
+    for (i = 0; i < h->hash_size; i++)
+        if (s->hash[i] > h->field_count)
+            return 0;
+    return 1;
+}
+
+static unsigned int add_string(cpu_shm *s, unsigned int *used, const char *str) {
+    unsigned int off = *used;
+    int len = strlen(str) + 1;
+    memcpy(s->strings + off, str, len);
+    *used += len;
+    return off;
+}
+
+static unsigned long long align_up(unsigned long long v) {
+    return (v + 63) & ~63ULL;
+}
+
+static int writer_init(cpu_shm *s, int count) {
+    cpu_mask *online = get_cpu_online();
+    int cpu, n = 0;
+    if (!online) return 0;
+    CPUMASK_FOR_EACH(cpu, online)
+        s->cpu_count = cpu + 1;
+    s->core_index = malloc(sizeof(int) * (s->cpu_count + 1));
+    s->core_scratch = malloc(sizeof(shm_core) * (count + 1));
+    s->prev_busy = calloc(count + 1, sizeof(long long));
+    s->prev_total = calloc(count + 1, sizeof(long long));
+    s->samples = malloc(sizeof(freq_sample) * (count + 1));
+    /* the per-cpu lines come first, the rest of /proc/stat is not needed */
+    s->stat_size = 4096 + count * 256;
+    s->stat = malloc(s->stat_size);
+    if (!s->core_index || !s->core_scratch || !s->prev_busy || !s->prev_total || !s->samples || !s->stat) {
+        cpumask_free(online);
+        return 0;
+    }
+    memset(s->core_index, 0xff, sizeof(int) * (s->cpu_count + 1));
+    CPUMASK_FOR_EACH(cpu, online) {
+        if (n == count) break;
+        s->core_index[cpu] = n;
+        memset(&s->core_scratch[n], 0, sizeof(shm_core));
+        s->core_scratch[n].cpu = cpu;
+        s->core_scratch[n].util_pm = -1;
+        n++;
+    }
+    s->fs = freq_sampler_new(online, count * 2);
+    cpumask_free(online);
+    return 1;
+}
+
+cpu_shm *cpu_shm_create(const char *name, rpiz_fields **lists, int count) {
+    cpu_shm *s, *old;
+    shm_header hd;
+    cpu_mask *online;
+    rpiz_fields *f;
+    char *tag, *fname, *value, **values;
+    unsigned long long strings_size = 1;
+    unsigned int used = 1, mask, k;
+    int fd, i, l, n = 0, live, cores, stale;
+
+    if (!name) name = CPU_SHM_NAME;
+    s = malloc( sizeof(cpu_shm) );
+    if (!s) return NULL;
+    memset(s, 0, sizeof(*s));
+    snprintf(s->name, sizeof(s->name), "%s", name);
+    s->writer = 1;
+
+    for (l = 0; l < count; l++)
+        for (f = lists[l]; f; f = fields_next(f))
+            n++;
+    online = get_cpu_online();
+    cores = cpumask_count(online);
+    cpumask_free(online);
+    s->src = malloc(sizeof(rpiz_fields *) * (n + 1));
+    s->live = malloc(sizeof(int) * (n + 1));
+    s->scratch = malloc(sizeof(shm_slot) * (n + 1));
+    values = malloc(sizeof(char *) * (n + 1));
+    if (!s->src || !s->live || !s->scratch || !values || !writer_init(s, cores)) {
+        free(values);
+        cpu_shm_close(s);
+        return NULL;
+    }
+
+    /* sizes first: every field, its tag, name and any fixed value; the
+     * text stays the field's until it is read again, so only once */
+    i = 0;
+    for (l = 0; l < count; l++)
+        for (f = lists[l]; f; f = fields_next(f)) {
+            fields_get(f, &tag, &fname, &values[i]);
+            fields_info(f, NULL, NULL, &live);
+            strings_size += strlen(tag) + strlen(fname) + 2;
+            if (!live && values[i])
+                strings_size += strlen(values[i]) + 1;
+            s->src[i++] = f;
+        }
+
+    memset(&hd, 0, sizeof(hd));
+    hd.version = CPU_SHM_VERSION;
+    hd.field_count = n;
+    hd.hash_size = 64;
+    while (hd.hash_size < (unsigned int)n * 2)
+        hd.hash_size <<= 1;
+    hd.core_count = cores;
+    hd.fields_off = align_up(sizeof(shm_header));
+    hd.hash_off = align_up(hd.fields_off + sizeof(shm_field) * n);
+    hd.cores_off = align_up(hd.hash_off + sizeof(unsigned int) * hd.hash_size);
+    hd.strings_off = align_up(hd.cores_off + sizeof(shm_core) * cores);
+    hd.size = hd.strings_off + strings_size;
+    hd.temp_mc = -1;
+    s->size = hd.size;
+
+    /* a running writer keeps its name. A closed or broken segment is
+     * replaced, readers still on it keep it until they close */
+    fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0 && errno == EEXIST) {
+        old = cpu_shm_open(name);
+        stale = !cpu_shm_alive(old);
+        cpu_shm_close(old);
+        if (stale) {
+            shm_unlink(name);
+            fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        }
+    }
+    if (fd < 0 || ftruncate(fd, s->size) != 0 || !map_segment(s, fd, PROT_READ | PROT_WRITE)) {
+        if (fd >= 0) {
+            close(fd);
+            shm_unlink(name);
+        }
+        free(values);
+        cpu_shm_close(s);
+        return NULL;
+    }
+    close(fd);
+    memcpy(s->h, &hd, sizeof(hd));
+    set_pointers(s);
+
+    mask = s->h->hash_size - 1;
+    for (i = 0; i < n; i++) {
+        f = s->src[i];
+        value = values[i];
+        fields_info(f, &tag, &fname, &live);
+        s->fields[i].tag = add_string(s, &used, tag);
+        s->fields[i].name = add_string(s, &used, fname);
+        s->fields[i].hash = shm_hash(tag);
+        s->fields[i].live = live;
+        if (live)
+            s->live[s->live_count++] = i;
+        else if (value)
+            s->fields[i].value = add_string(s, &used, value);
+        /* the first of a tag wins, as in the lists */
+        for (k = s->fields[i].hash & mask; s->hash[k]; k = (k + 1) & mask)
+            if (s->fields[s->hash[k] - 1].hash == s->fields[i].hash
+                && strcmp(s->strings + s->fields[s->hash[k] - 1].tag, tag) == 0)
+                break;
+        if (!s->hash[k])
+            s->hash[k] = i + 1;
+    }
+    free(values);
+    memcpy(s->cores, s->core_scratch, sizeof(shm_core) * cores);
+    STORE(s->h->magic, SHM_MAGIC);
+    return s;
+}
+
+static int read_temp_mc(void) {
+    char buff[32];
+    if (get_file_buff("/sys/class/thermal/thermal_zone0/temp", buff, sizeof(buff)) > 0)
+        return atoi(buff);
+    return -1;
+}
+
+/* busy per mille for each cpu since the last call, from /proc/stat */
+static void sample_util(cpu_shm *s) {
+    char *p, *end;
+    long long v[8], busy, total;
+    int cpu, c, j;
+    if (get_file_buff("/proc/stat", s->stat, s->stat_size) <= 0)
+        return;
+    for (p = s->stat; p && *p; p = strchr(p, '\n'), p = p ? p + 1 : NULL) {
+        if (strncmp(p, "cpu", 3) != 0)
+            break;
+        if (p[3] < '0' || p[3] > '9')
+            continue; /* the "cpu" total line */
+        cpu = strtol(p + 3, &end, 10);
+        if (cpu >= s->cpu_count || (c = s->core_index[cpu]) < 0)
+            continue;
+        total = 0;
+        for (j = 0; j < 8; j++) {
+            v[j] = strtoll(end, &end, 10);
+            total += v[j];
+        }
+        busy = total - v[3] - v[4]; /* idle, iowait */
+        if (s->prev_total[c] && total > s->prev_total[c])
+            s->core_scratch[c].util_pm = (busy - s->prev_busy[c]) * 1000 / (total - s->prev_total[c]);
+        s->prev_busy[c] = busy;
+        s->prev_total[c] = total;
+    }
+}
+
+static void sample_freq(cpu_shm *s) {
+    int i, n, c;
+    if (!freq_sampler_cpus(s->fs))
+        return;
+    freq_sampler_sample(s->fs);
+    while ((n = freq_sampler_read(s->fs, s->samples, s->h->core_count)) > 0)
+        for (i = 0; i < n; i++) {
+            c = s->samples[i].cpu;
+            if (c < s->cpu_count && s->core_index[c] >= 0)
+                s->core_scratch[s->core_index[c]].khz = s->samples[i].khz;
+        }
+}
+
+long long cpu_shm_publish(cpu_shm *s) {
+    shm_header *h;
+    shm_slot *sl;
+    unsigned long long seq;
+    long long temp;
+    int i;
+
+    if (!s || !s->writer) return 0;
+    h = s->h;
+    /* all the reading first, the seq is held only for the copies */
+    for (i = 0; i < s->live_count; i++) {
+        sl = &s->scratch[i];
+        memset(sl, 0, sizeof(*sl));
+        if (fields_sample(s->src[s->live[i]], &sl->val, sl->text, sizeof(sl->text)) >= 0)
+            sl->state = (fields_info(s->src[s->live[i]], NULL, NULL, NULL) == 1) ? SLOT_TYPED : SLOT_TEXT;
+    }
+    sample_freq(s);
+    sample_util(s);
+    temp = read_temp_mc();
+
+    seq = h->seq; /* only we write it */
+    STORE_RELAXED(h->seq, seq + 1);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    for (i = 0; i < s->live_count; i++)
+        words_store(&s->fields[s->live[i]].slot, &s->scratch[i], WORDS(shm_slot));
+    words_store(s->cores, s->core_scratch, WORDS(shm_core) * h->core_count);
+    STORE_RELAXED(h->temp_mc, temp);
+    STORE_RELAXED(h->t_ns, time_ns());
+    STORE_RELAXED(h->gen, h->gen + 1);
+    STORE(h->seq, seq + 2);
+    return h->gen;
+}
+
+cpu_shm *cpu_shm_open(const char *name) {
+    cpu_shm *s;
+    struct stat st;
+    int fd;
+
+    if (!name) name = CPU_SHM_NAME;
+    fd = shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0)
+        return NULL;
+    s = malloc( sizeof(cpu_shm) );
+    if (!s) {
+        close(fd);
+        return NULL;
+    }
+    memset(s, 0, sizeof(*s));
+    snprintf(s->name, sizeof(s->name), "%s", name);
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(shm_header)) {
+        close(fd);
+        free(s);
+        return NULL;
+    }
+    s->size = st.st_size;
+    if (!map_segment(s, fd, PROT_READ)) {
+        close(fd);
+        free(s);
+        return NULL;
+    }
+    close(fd);
+    if (LOAD(s->h->magic) != SHM_MAGIC || s->h->version != CPU_SHM_VERSION || !layout_ok(s)) {
+        cpu_shm_close(s);
+        return NULL;
+    }
+    return s;
+}
+
+void cpu_shm_close(cpu_shm *s) {
+    if (s) {
+        if (s->h) {
+            if (s->writer) {
+                STORE(s->h->closed, 1);
+                shm_unlink(s->name);
+            }
+            munmap(s->h, s->size);
+        }
+        freq_sampler_free(s->fs);
+        free(s->src);
+        free(s->live);
+        free(s->scratch);
+        free(s->core_scratch);
+        free(s->core_index);
+        free(s->prev_busy);
+        free(s->prev_total);
+        free(s->samples);
+        free(s->stat);
+        free(s);
+    }
+}
+
+int cpu_shm_alive(cpu_shm *s) {
+    if (s)
+        return !LOAD(s->h->closed);
+    return 0;
+}
+
+long long cpu_shm_gen(cpu_shm *s) {
+    if (s)
+        return LOAD(s->h->gen);
+    return 0;
+}
+
+long long cpu_shm_time_ns(cpu_shm *s) {
+    if (s)
+        return LOAD(s->h->t_ns);
+    return 0;
+}
+
+int cpu_shm_count(cpu_shm *s) {
+    if (s)
+        return s->h->field_count;
+    return 0;
+}
+
+int cpu_shm_find(cpu_shm *s, const char *tag) {
+    unsigned int hash, mask, k, i, probes;
+    const char *t;
+    if (!s || !tag)
+        return -1;
+    hash = shm_hash(tag);
+    mask = s->h->hash_size - 1;
+    for (k = hash & mask, probes = 0; s->hash[k] && probes <= mask; k = (k + 1) & mask, probes++) {
+        i = s->hash[k] - 1;
+        if (s->fields[i].hash == hash && (t = shm_string(s, s->fields[i].tag)) && strcmp(t, tag) == 0)
+            return i;
+    }
+    return -1;
+}
+
+const char *cpu_shm_tag(cpu_shm *s, int i) {
+    if (s && i >= 0 && i < (int)s->h->field_count)
+        return shm_string(s, s->fields[i].tag);
+    return NULL;
+}
+
+const char *cpu_shm_name(cpu_shm *s, int i) {
+    if (s && i >= 0 && i < (int)s->h->field_count)
+        return shm_string(s, s->fields[i].name);
+    return NULL;
+}
+
+static int read_slot(cpu_shm *s, int i, shm_slot *out) {
+    unsigned long long seq;
+    do {
+        if (!read_begin(s->h, &seq))
+            return 0;
+        words_load(out, &s->fields[i].slot, WORDS(shm_slot));
+    } while (read_retry(s->h, seq));
+    out->text[SHM_TEXT_SIZE - 1] = 0;
+    return 1;
+}
+
+int cpu_shm_get(cpu_shm *s, int i, char *buff, int size) {
+    shm_slot sl;
+    const char *v;
+    if (!s || i < 0 || i >= (int)s->h->field_count || !buff || size < 1)
+        return -1;
+    if (!s->fields[i].live) {
+        if (!s->fields[i].value || !(v = shm_string(s, s->fields[i].value)))
+            return -1;
+        return snprintf(buff, size, "%s", v);
+    }
+    if (!read_slot(s, i, &sl) || sl.state == SLOT_NONE)
+        return -1;
+    return snprintf(buff, size, "%s", sl.text);
+}
+
+int cpu_shm_get_bytag(cpu_shm *s, const char *tag, char *buff, int size) {
+    return cpu_shm_get(s, cpu_shm_find(s, tag), buff, size);
+}
+
+int cpu_shm_value(cpu_shm *s, int i, rpiz_value *value) {
+    shm_slot sl;
+    if (!s || i < 0 || i >= (int)s->h->field_count || !s->fields[i].live)
+        return 0;
+    if (!read_slot(s, i, &sl) || sl.state != SLOT_TYPED)
+        return 0;
+    if (value) *value = sl.val;
+    return 1;
+}
+
+int cpu_shm_cpus(cpu_shm *s) {
+    if (s)
+        return s->h->core_count;
+    return 0;
+}
+
+int cpu_shm_cores(cpu_shm *s, cpu_shm_core *out, int max) {
+    unsigned long long seq;
+    union { shm_core c; shm_word w[WORDS(shm_core)]; } u; /* word aligned */
+    int i, n;
+    if (!s || !out || max <= 0)
+        return 0;
+    n = s->h->core_count;
+    if (n > max) n = max;
+    do {
+        if (!read_begin(s->h, &seq))
+            return 0;
+        /* one core at a time through u, out need not be word aligned */
+        for (i = 0; i < n; i++) {
+            words_load(u.w, &s->cores[i], WORDS(shm_core));
+            out[i].cpu = u.c.cpu;
+            out[i].khz = u.c.khz;
+            out[i].util_pm = u.c.util_pm;
+        }
+    } while (read_retry(s->h, seq));
+    return n;
+}
+
+int cpu_shm_temp(cpu_shm *s, double *celsius) {
+    unsigned long long seq;
+    long long t;
+    if (!s) return 0;
+    do {
+        if (!read_begin(s->h, &seq))
+            return 0;
+        t = LOAD_RELAXED(s->h->temp_mc);
+    } while (read_retry(s->h, seq));
+    if (t < 0)
+        return 0;
+    if (celsius) *celsius = t / 1000.0;
+    return 1;
+}
@@ -0,0 +1,76 @@
+/*
+ * rpiz - https://github.com/bp0/rpiz
+ * Copyright (C) 2017  Burt P. <pburt0@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+#ifndef _CPU_SHM_H_
+#define _CPU_SHM_H_
+
+#include "fields.h"
+
+/* A telemetry segment in /dev/shm: every field of the lists it was made
+ * from, plus per-cpu frequency and utilization and the thermal zone
+ * temperature. One writer (cpuinfo --daemon) publishes it on a timer,
+ * behind a sequence count, and any number of processes map it read-only
+ * and copy what they need with no file I/O, locks or syscalls. Tags
+ * are found through a hash table in the segment. */
+typedef struct cpu_shm cpu_shm;
+
+#define CPU_SHM_NAME "/cpuinfo" /* /dev/shm/cpuinfo */
+#define CPU_SHM_VERSION 1 /* of the layout, readers refuse any other */
+
+typedef struct {
+    int cpu;
+    int khz; /* 0 if unknown */
+    int util_pm; /* busy per mille since the last publish, -1 if unknown */
+} cpu_shm_core;
+
+/* -- writer -- */
+
+/* NULL for CPU_SHM_NAME, fails while another writer has that name
+ * open. A segment its writer closed, or one that is not valid, is
+ * replaced; a writer killed before cpu_shm_close() leaves a segment
+ * that looks open, remove it with shm_unlink() or from /dev/shm. The
+ * fields of the lists must outlive it. */
+cpu_shm *cpu_shm_create(const char *name, rpiz_fields **lists, int count);
+long long cpu_shm_publish(cpu_shm *); /* samples every live value and cpu, returns the generation */
+
+/* -- reader -- */
+
+cpu_shm *cpu_shm_open(const char *name); /* NULL if missing, not ready or another version */
+int cpu_shm_alive(cpu_shm *); /* 0 once the writer has closed it */
+long long cpu_shm_gen(cpu_shm *); /* publishes so far */
+long long cpu_shm_time_ns(cpu_shm *); /* CLOCK_MONOTONIC of the last publish */
+
+int cpu_shm_count(cpu_shm *); /* fields */
+int cpu_shm_find(cpu_shm *, const char *tag); /* index or -1 */
+const char *cpu_shm_tag(cpu_shm *, int i);
+const char *cpu_shm_name(cpu_shm *, int i);
+int cpu_shm_get(cpu_shm *, int i, char *buff, int size); /* as snprintf(), -1 if no value */
+int cpu_shm_get_bytag(cpu_shm *, const char *tag, char *buff, int size);
+int cpu_shm_value(cpu_shm *, int i, rpiz_value *); /* 0 if not typed or no value */
+
+int cpu_shm_cpus(cpu_shm *);
+int cpu_shm_cores(cpu_shm *, cpu_shm_core *out, int max); /* one consistent copy, returns how many */
+int cpu_shm_temp(cpu_shm *, double *celsius); /* 0 if unknown */
+
+/* -- both -- */
+
+void cpu_shm_close(cpu_shm *); /* the writer's also removes the name */
+
+#endif
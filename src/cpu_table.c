@@ -0,0 +1,203 @@
+/*
+ * rpiz - https://github.com/bp0/rpiz
+ * Copyright (C) 2017  Burt P. <pburt0@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "cpu_table.h"
+
+typedef struct {
+    const char *name;
+    const char *label;
+    cpu_cell_type type;
+    const char *base;
+    int stride;
+    int flags;
+    cpu_cell_flat_func flat;
+} cpu_column;
+
+struct cpu_table {
+    int rows;
+    const int *row_id;
+    int cols, alloc;
+    cpu_column *col;
+    void *data;
+    cpu_table_refresh_func refresh;
+};
+
+cpu_table *cpu_table_new(int rows, const int *row_id, void *data) {
+    cpu_table *s = malloc(sizeof(cpu_table));
+    if (s) {
+        memset(s, 0, sizeof(*s));
+        s->rows = rows;
+        s->row_id = row_id;
+        s->data = data;
+    }
+    return s;
+}
+
+void cpu_table_free(cpu_table *s) {
+    if (s) {
+        free(s->col);
+        free(s);
+    }
+}
+
+void *cpu_table_data(const cpu_table *s) {
+    if (s)
+        return s->data;
+    return NULL;
+}
+
+int cpu_table_add(cpu_table *s, const char *name, const char *label, cpu_cell_type type,
+    const void *base, int stride, int flags, cpu_cell_flat_func flat) {
+    cpu_column *tmp;
+    if (!s || !name)
+        return 0;
+    if (s->cols == s->alloc) {
+        tmp = realloc(s->col, sizeof(cpu_column) * (s->alloc ? s->alloc * 2 : 8));
+        if (!tmp)
+            return 0;
+        s->col = tmp;
+        s->alloc = s->alloc ? s->alloc * 2 : 8;
+    }
+    s->col[s->cols].name = name;
+    s->col[s->cols].label = label ? label : name;
+    s->col[s->cols].type = type;
+    s->col[s->cols].base = base;
+    s->col[s->cols].stride = stride;
+    s->col[s->cols].flags = flags;
+    s->col[s->cols].flat = flat;
+    s->cols++;
+    return 1;
+}
+
+void cpu_table_set_refresh(cpu_table *s, cpu_table_refresh_func func) {
+    if (s)
+        s->refresh = func;
+}
+
+void cpu_table_refresh(cpu_table *s) {
+    if (s && s->refresh)
+        s->refresh(s->data);
+}
+
+int cpu_table_rows(const cpu_table *s) {
+    if (s)
+        return s->rows;
+    return 0;
+}
+
+int cpu_table_row_id(const cpu_table *s, int row) {
+    if (s && row >= 0 && row < s->rows)
+        return s->row_id ? s->row_id[row] : row;
+    return -1;
+}
+
+int cpu_table_cols(const cpu_table *s) {
+    if (s)
+        return s->cols;
+    return 0;
+}
+
+int cpu_table_col(const cpu_table *s, const char *name) {
+    int c;
+    if (s && name)
+        for (c = 0; c < s->cols; c++)
+            if (strcmp(s->col[c].name, name) == 0)
+                return c;
+    return -1;
+}
+
+const char *cpu_table_col_name(const cpu_table *s, int col) {
+    if (s && col >= 0 && col < s->cols)
+        return s->col[col].name;
+    return NULL;
+}
+
+cpu_cell_type cpu_table_col_type(const cpu_table *s, int col) {
+    if (s && col >= 0 && col < s->cols)
+        return s->col[col].type;
+    return CELL_STR;
+}
+
+int cpu_table_col_live(const cpu_table *s, int col) {
+    if (s && col >= 0 && col < s->cols)
+        return !!(s->col[col].flags & COL_LIVE);
+    return 0;
+}
+
+#define CELL(s, col, row) ((s)->col[col].base + (size_t)(row) * (s)->col[col].stride)
+#define CELL_OK(s, col, row, t) (s && col >= 0 && col < s->cols && row >= 0 && row < s->rows && s->col[col].type == t)
+
+const char *cpu_table_str(const cpu_table *s, int col, int row) {
+    if (CELL_OK(s, col, row, CELL_STR))
+        return *(char * const *)CELL(s, col, row);
+    return NULL;
+}
+
+int cpu_table_int(const cpu_table *s, int col, int row) {
+    if (CELL_OK(s, col, row, CELL_INT))
+        return *(const int *)CELL(s, col, row);
+    return 0;
+}
+
+unsigned long long cpu_table_reg64(const cpu_table *s, int col, int row) {
+    if (CELL_OK(s, col, row, CELL_REG64))
+        return *(const unsigned long long *)CELL(s, col, row);
+    return 0;
+}
+
+static char *cell_text(const cpu_table *s, int col, int row) {
+    char buff[64];
+    const char *str;
+    if (s->col[col].flat)
+        return s->col[col].flat(s, col, row);
+    switch (s->col[col].type) {
+        case CELL_STR:
+            str = cpu_table_str(s, col, row);
+            return strdup(str ? str : "(null)");
+        case CELL_INT:
+            snprintf(buff, sizeof(buff), "%d", cpu_table_int(s, col, row));
+            return strdup(buff);
+        case CELL_REG64:
+            snprintf(buff, sizeof(buff), "0x%016llx", cpu_table_reg64(s, col, row));
+            return strdup(buff);
+    }
+    return NULL;
+}
+
+rpiz_fields *cpu_table_flat_fields(const cpu_table *s, rpiz_fields *f, const char *prefix) {
+    char tag[256], name[256];
+    rpiz_fields *nf;
+    int row, col;
+    if (s) {
+        for (row = 0; row < s->rows; row++)
+            for (col = 0; col < s->cols; col++) {
+                if (!(s->col[col].flags & COL_FLAT))
+                    continue;
+                snprintf(tag, sizeof(tag), "%s[%d].%s", prefix, row, s->col[col].name);
+                snprintf(name, sizeof(name), "[%d] %s", cpu_table_row_id(s, row), s->col[col].label);
+                nf = fields_update_bytag(f, tag, 0, 1, name, NULL, cell_text(s, col, row));
+                if (!f)
+                    f = nf;
+            }
+    }
+    return f;
+}
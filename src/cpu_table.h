@@ -0,0 +1,73 @@
+/*
+ * rpiz - https://github.com/bp0/rpiz
+ * Copyright (C) 2017  Burt P. <pburt0@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+#ifndef _CPU_TABLE_H_
+#define _CPU_TABLE_H_
+
+#include "fields.h"
+
+/* Per-cpu data as columns, one row per cpu. Cells are read in place
+ * from the proc that made the table, nothing is copied or formatted,
+ * so a reader polling a column pays only for the column. The table
+ * belongs to that proc and is valid until it is freed. */
+typedef enum {
+    CELL_STR,   /* const char *, may be NULL */
+    CELL_INT,   /* int */
+    CELL_REG64, /* unsigned long long, a register shown in hex */
+} cpu_cell_type;
+
+typedef struct cpu_table cpu_table;
+
+int cpu_table_rows(const cpu_table *);
+int cpu_table_row_id(const cpu_table *, int row); /* the cpu (or hart) id */
+int cpu_table_cols(const cpu_table *);
+int cpu_table_col(const cpu_table *, const char *name); /* -1 if no such column */
+const char *cpu_table_col_name(const cpu_table *, int col);
+cpu_cell_type cpu_table_col_type(const cpu_table *, int col);
+int cpu_table_col_live(const cpu_table *, int col); /* changed by cpu_table_refresh() */
+
+/* a cell of another type reads as NULL or 0 */
+const char *cpu_table_str(const cpu_table *, int col, int row);
+int cpu_table_int(const cpu_table *, int col, int row);
+unsigned long long cpu_table_reg64(const cpu_table *, int col, int row);
+
+void cpu_table_refresh(cpu_table *); /* read the live columns again */
+
+/* each row's flat columns as prefix[row].name tags, named
+ * "[id] label", appended to f; returns f, or the new list if f is NULL */
+rpiz_fields *cpu_table_flat_fields(const cpu_table *, rpiz_fields *f, const char *prefix);
+
+/* -- for the procs that make tables -- */
+
+/* text for a flat tag, free() the result; NULL shows the cell as is */
+typedef char *(*cpu_cell_flat_func)(const cpu_table *, int col, int row);
+typedef void (*cpu_table_refresh_func)(void *data);
+
+#define COL_FLAT 0x01 /* has a flat tag */
+#define COL_LIVE 0x02 /* read again by the refresh func */
+
+cpu_table *cpu_table_new(int rows, const int *row_id, void *data);
+void cpu_table_free(cpu_table *);
+void *cpu_table_data(const cpu_table *); /* as given to cpu_table_new() */
+/* cells are at base, base + stride, ... for each row */
+int cpu_table_add(cpu_table *, const char *name, const char *label, cpu_cell_type type,
+    const void *base, int stride, int flags, cpu_cell_flat_func flat);
+void cpu_table_set_refresh(cpu_table *, cpu_table_refresh_func func);
+
+#endif
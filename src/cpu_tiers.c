@@ -0,0 +1,277 @@
+/*
+ * rpiz - https://github.com/bp0/rpiz
+ * Copyright (C) 2017  Burt P. <pburt0@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "cpu_tiers.h"
+
+#define CAPACITY_SCALE 1024
+
+enum {
+    SRC_NONE = 0,
+    SRC_CAPACITY,
+    SRC_PMU,
+};
+
+struct cpu_tiers {
+    int count;
+    cpu_tier *tiers;
+
+    int cpu_count; /* highest cpu + 1 */
+    int *capacity; /* [cpu] */
+    int *tier;     /* [cpu] = tier index, or -1 */
+    int source;
+
+    rpiz_fields *fields;
+};
+
+typedef struct {
+    int cpu;
+    int key; /* higher is faster, cpus with equal keys share a tier */
+} tier_rec;
+
+static int rec_cmp(const void *a, const void *b) {
+    const tier_rec *ra = a, *rb = b;
+    if (ra->key != rb->key)
+        return (ra->key > rb->key) ? -1 : 1;
+    return (ra->cpu < rb->cpu) ? -1 : (ra->cpu > rb->cpu);
+}
+
+static const char *tier_name(int i, int count) {
+    if (count == 1) return "uniform";
+    if (i == 0) return "performance";
+    if (i == count - 1) return "efficiency";
+    return "mid";
+}
+
+/* cpu_capacity only counts when every online cpu has one, a cpu left at
+ * 0 would become a tier of its own */
+static int read_capacity(cpu_tiers *s, const cpu_mask *online) {
+    static const char *items[] = {
+        "cpu_capacity",
+        "cpufreq/cpuinfo_max_freq",
+    };
+    read_req *reqs;
+    int *ids, cpu, i, n = 0, found = 0, max = 0;
+
+    ids = malloc(sizeof(int) * (cpumask_count(online) + 1));
+    if (!ids) return SRC_NONE;
+    CPUMASK_FOR_EACH(cpu, online)
+        ids[n++] = cpu;
+    reqs = read_cpu_batch(ids, n, items, 2);
+    if (!reqs) {
+        free(ids);
+        return SRC_NONE;
+    }
+
+    for (i = 0; i < n; i++)
+        if (reqs[i * 2].len > 0) {
+            s->capacity[ids[i]] = read_req_int(&reqs[i * 2]);
+            found++;
+        }
+    if (found != n) {
+        /* relative max frequency */
+        for (i = 0; i < n; i++) {
+            s->capacity[ids[i]] = read_req_int(&reqs[i * 2 + 1]);
+            if (s->capacity[ids[i]] > max) max = s->capacity[ids[i]];
+        }
+        for (i = 0; i < n; i++)
+            s->capacity[ids[i]] = max ? (int)((long long)s->capacity[ids[i]] * CAPACITY_SCALE / max) : CAPACITY_SCALE;
+    }
+    free(reqs);
+    free(ids);
+    return (n && found == n) ? SRC_CAPACITY : SRC_NONE;
+}
+
+cpu_tiers *cpu_tiers_new() {
+    cpu_tiers *s;
+    cpu_mask *online, *pcore = NULL, *ecore = NULL;
+    tier_rec *recs;
+    cpu_tier *t;
+    int cpu, i, n = 0, last = 0;
+
+    s = malloc( sizeof(cpu_tiers) );
+    if (!s) return NULL;
+    memset(s, 0, sizeof(*s));
+
+    online = get_cpu_online();
+    CPUMASK_FOR_EACH(cpu, online)
+        s->cpu_count = cpu + 1;
+    s->capacity = calloc(s->cpu_count + 1, sizeof(int));
+    s->tier = malloc(sizeof(int) * (s->cpu_count + 1));
+    recs = malloc(sizeof(tier_rec) * (cpumask_count(online) + 1));
+    s->tiers = malloc(sizeof(cpu_tier) * (cpumask_count(online) + 1));
+    if (!s->capacity || !s->tier || !recs || !s->tiers) {
+        free(recs);
+        cpumask_free(online);
+        cpu_tiers_free(s);
+        return NULL;
+    }
+    memset(s->tier, 0xff, sizeof(int) * (s->cpu_count + 1));
+
+    s->source = read_capacity(s, online);
+    if (s->source == SRC_NONE) {
+        pcore = get_cpu_mask("/sys/devices/cpu_core/cpus");
+        ecore = get_cpu_mask("/sys/devices/cpu_atom/cpus");
+        if (cpumask_count(pcore) && cpumask_count(ecore))
+            s->source = SRC_PMU;
+    }
+
+    CPUMASK_FOR_EACH(cpu, online) {
+        recs[n].cpu = cpu;
+        switch (s->source) {
+            case SRC_CAPACITY:
+                recs[n].key = s->capacity[cpu];
+                break;
+            case SRC_PMU:
+                recs[n].key = cpumask_test(pcore, cpu) ? 2 : cpumask_test(ecore, cpu) ? 1 : 0;
+                break;
+            default:
+                /* favored cores have slightly higher turbo, it is still one tier */
+                recs[n].key = 0;
+        }
+        n++;
+    }
+    qsort(recs, n, sizeof(tier_rec), rec_cmp);
+
+    for (i = 0; i < n; i++) {
+        if (i == 0 || recs[i].key != last) {
+            t = &s->tiers[s->count++];
+            t->cpus = cpumask_new(s->cpu_count);
+            t->capacity = 0;
+            last = recs[i].key;
+        }
+        cpumask_set(t->cpus, recs[i].cpu);
+        if (s->capacity[recs[i].cpu] > t->capacity)
+            t->capacity = s->capacity[recs[i].cpu];
+        s->tier[recs[i].cpu] = s->count - 1;
+    }
+    for (i = 0; i < s->count; i++)
+        s->tiers[i].name = tier_name(i, s->count);
+
+    free(recs);
+    cpumask_free(pcore);
+    cpumask_free(ecore);
+    cpumask_free(online);
+    return s;
+}
+
+void cpu_tiers_free(cpu_tiers *s) {
+    int i;
+    if (s) {
+        for (i = 0; i < s->count; i++)
+            cpumask_free(s->tiers[i].cpus);
+        free(s->tiers);
+        free(s->capacity);
+        free(s->tier);
+        fields_free(s->fields);
+        free(s);
+    }
+}
+
+int cpu_tiers_count(cpu_tiers *s) {
+    if (s)
+        return s->count;
+    return 0;
+}
+
+const cpu_tier *cpu_tiers_get(cpu_tiers *s, int i) {
+    if (s)
+        if (i >= 0 && i < s->count)
+            return &s->tiers[i];
+    return NULL;
+}
+
+int cpu_tiers_of_cpu(cpu_tiers *s, int cpu) {
+    if (s && cpu >= 0 && cpu < s->cpu_count)
+        return s->tier[cpu];
+    return -1;
+}
+
+int cpu_tiers_capacity(cpu_tiers *s, int cpu) {
+    if (s && cpu >= 0 && cpu < s->cpu_count)
+        return s->capacity[cpu];
+    return 0;
+}
+
+const cpu_mask *cpu_tiers_fastest(cpu_tiers *s) {
+    const cpu_tier *t = cpu_tiers_get(s, 0);
+    return t ? t->cpus : NULL;
+}
+
+const cpu_mask *cpu_tiers_slowest(cpu_tiers *s) {
+    const cpu_tier *t = cpu_tiers_get(s, cpu_tiers_count(s) - 1);
+    return t ? t->cpus : NULL;
+}
+
+static int cpu_tiers_count_value(cpu_tiers *s, rpiz_value *v) {
+    v->i = cpu_tiers_count(s);
+    return 1;
+}
+
+static const char *cpu_tiers_source_str(cpu_tiers *s) {
+    switch (s->source) {
+        case SRC_CAPACITY:
+            return "cpu_capacity";
+        case SRC_PMU:
+            return "cpu_core/cpu_atom";
+        default:
+            return "cpuinfo_max_freq";
+    }
+}
+
+static int cpu_tier_capacity_value(cpu_tier *t, rpiz_value *v) {
+    v->i = t->capacity;
+    return 1;
+}
+
+static char *cpu_tier_cpus_str(cpu_tier *t) {
+    return cpumask_to_list(t->cpus);
+}
+
+#define ADDFIELDT(t, l, o, n, f) fields_update_bytag(s->fields, t, l, o, n, (rpiz_fields_get_func)f, (void*)tier)
+#define ADDFIELDSTR(t, l, o, n, str) fields_update_bytag(s->fields, t, l, o, n, NULL, (void*)str)
+#define ADDFIELDV(t, l, n, y, f) fields_update_value_bytag(s->fields, t, l, n, y, (rpiz_fields_value_func)f, (void*)s)
+#define ADDFIELDTV(t, l, n, y, f) fields_update_value_bytag(s->fields, t, l, n, y, (rpiz_fields_value_func)f, (void*)tier)
+rpiz_fields *cpu_tiers_fields(cpu_tiers *s) {
+    char tag[64];
+    cpu_tier *tier;
+    int i;
+    if (s) {
+        if (!s->fields) {
+            /* first insert creates */
+            s->fields =
+            ADDFIELDV("tiers.count",    0, "Performance Tiers", FIELD_INT64, cpu_tiers_count_value );
+            ADDFIELDSTR("tiers.source", 0, 0, "Classified By", cpu_tiers_source_str(s) );
+            for (i = 0; i < s->count; i++) {
+                tier = &s->tiers[i];
+                snprintf(tag, sizeof(tag), "tiers.tier[%d].name", i);
+                ADDFIELDSTR(tag, 0, 0, "Tier", tier->name );
+                snprintf(tag, sizeof(tag), "tiers.tier[%d].capacity", i);
+                ADDFIELDTV(tag, 0, "Capacity", FIELD_INT64, cpu_tier_capacity_value );
+                snprintf(tag, sizeof(tag), "tiers.tier[%d].cpus", i);
+                ADDFIELDT(tag, 0, 1, "CPUs", cpu_tier_cpus_str );
+            }
+        }
+        return s->fields;
+    }
+    return NULL;
+}
@@ -0,0 +1,51 @@
+/*
+ * rpiz - https://github.com/bp0/rpiz
+ * Copyright (C) 2017  Burt P. <pburt0@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+#ifndef _CPU_TIERS_H_
+#define _CPU_TIERS_H_
+
+#include "fields.h"
+#include "util.h"
+
+typedef struct {
+    const char *name; /* "performance", "mid", "efficiency" or "uniform" */
+    int capacity;     /* highest in the tier, fastest cpu is 1024 */
+    cpu_mask *cpus;
+} cpu_tier;
+
+typedef struct cpu_tiers cpu_tiers;
+
+/* Classifies the online cpus into performance tiers, fastest first.
+ * Uses cpu_capacity (arm) if available, then the cpu_core/cpu_atom
+ * PMU masks (Intel hybrid), otherwise everything is one tier.
+ * Capacity falls back to cpuinfo_max_freq relative to the fastest cpu. */
+cpu_tiers *cpu_tiers_new(void);
+void cpu_tiers_free(cpu_tiers *);
+
+int cpu_tiers_count(cpu_tiers *);
+const cpu_tier *cpu_tiers_get(cpu_tiers *, int i);
+int cpu_tiers_of_cpu(cpu_tiers *, int cpu); /* tier index, -1 if not online */
+int cpu_tiers_capacity(cpu_tiers *, int cpu); /* 0 if not online */
+const cpu_mask *cpu_tiers_fastest(cpu_tiers *); /* for latency-critical threads */
+const cpu_mask *cpu_tiers_slowest(cpu_tiers *); /* for background work */
+
+rpiz_fields *cpu_tiers_fields(cpu_tiers *);
+
+#endif
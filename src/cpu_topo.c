@@ -0,0 +1,318 @@
+/*
+ * rpiz - https://github.com/bp0/rpiz
+ * Copyright (C) 2017  Burt P. <pburt0@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "cpu_topo.h"
+
+struct cpu_topo {
+    int node_count;
+    topo_node *nodes;
+    int level_start[TOPO_N_LEVELS];
+    int level_count[TOPO_N_LEVELS];
+
+    int cpu_count; /* highest cpu + 1 */
+    int *cpu_nodes; /* [cpu * TOPO_N_LEVELS + level] = node, or -1 */
+
+    char *desc;
+    rpiz_fields *fields;
+};
+
+typedef struct {
+    int key[TOPO_N_LEVELS]; /* sort keys, [TOPO_THREAD] is the cpu */
+    int id[TOPO_N_LEVELS];
+} topo_rec;
+
+static const char *level_str[] = {
+    [TOPO_MACHINE] = "machine",
+    [TOPO_PACKAGE] = "package",
+    [TOPO_DIE] = "die",
+    [TOPO_CLUSTER] = "cluster",
+    [TOPO_CORE] = "core",
+    [TOPO_THREAD] = "thread",
+};
+
+const char *cpu_topo_level_str(topo_level level) {
+    if (level >= TOPO_MACHINE && level < TOPO_N_LEVELS)
+        return level_str[level];
+    return NULL;
+}
+
+static int first_cpu_of(const char *item, int cpu) {
+    cpu_mask *m;
+    char *list;
+    int ret = -1;
+    list = get_cpu_str(item, cpu);
+    if (list) {
+        m = cpumask_from_list(list);
+        ret = cpumask_next(m, -1);
+        cpumask_free(m);
+        free(list);
+    }
+    return ret;
+}
+
+static void read_rec(topo_rec *r, int cpu) {
+    int core;
+    memset(r, 0, sizeof(*r));
+    r->id[TOPO_PACKAGE] = get_cpu_int("topology/physical_package_id", cpu);
+    r->id[TOPO_DIE] = get_cpu_int("topology/die_id", cpu);
+    r->id[TOPO_CLUSTER] = get_cpu_int("topology/cluster_id", cpu);
+    r->id[TOPO_CORE] = get_cpu_int("topology/core_id", cpu);
+    r->id[TOPO_THREAD] = cpu;
+
+    /* core ids repeat per package (and per cluster on some arm),
+     * the first sibling names the core uniquely */
+    core = first_cpu_of("topology/core_cpus_list", cpu);
+    if (core < 0)
+        core = first_cpu_of("topology/thread_siblings_list", cpu);
+    if (core < 0)
+        core = cpu;
+
+    memcpy(r->key, r->id, sizeof(r->key));
+    r->key[TOPO_CORE] = core;
+}
+
+static void read_rec_item(void *data, int i) {
+    topo_rec *r = &((topo_rec*)data)[i];
+    read_rec(r, r->key[TOPO_THREAD]);
+}
+
+static int rec_cmp(const void *a, const void *b) {
+    const topo_rec *ra = a, *rb = b;
+    int l;
+    for (l = TOPO_PACKAGE; l < TOPO_N_LEVELS; l++)
+        if (ra->key[l] != rb->key[l])
+            return (ra->key[l] < rb->key[l]) ? -1 : 1;
+    return 0;
+}
+
+static int same_prefix(const topo_rec *a, const topo_rec *b, int level) {
+    int l;
+    for (l = TOPO_PACKAGE; l <= level; l++)
+        if (a->key[l] != b->key[l])
+            return 0;
+    return 1;
+}
+
+static int build(cpu_topo *s, topo_rec *recs, int count) {
+    int *grp; /* [level * count + rec] = node */
+    int l, r, n;
+    topo_node *node, *parent;
+
+    grp = malloc(sizeof(int) * TOPO_N_LEVELS * count);
+    /* at most one node per record per level, plus the machine */
+    s->nodes = malloc(sizeof(topo_node) * ((TOPO_N_LEVELS - 1) * count + 1));
+    s->cpu_count = recs[count - 1].key[TOPO_THREAD] + 1;
+    for (r = 0; r < count; r++)
+        if (recs[r].key[TOPO_THREAD] >= s->cpu_count)
+            s->cpu_count = recs[r].key[TOPO_THREAD] + 1;
+    s->cpu_nodes = malloc(sizeof(int) * TOPO_N_LEVELS * s->cpu_count);
+    if (!grp || !s->nodes || !s->cpu_nodes) {
+        free(grp);
+        return 0;
+    }
+    memset(s->cpu_nodes, 0xff, sizeof(int) * TOPO_N_LEVELS * s->cpu_count);
+
+    node = &s->nodes[0];
+    memset(node, 0, sizeof(*node));
+    node->level = TOPO_MACHINE;
+    node->parent = -1;
+    node->cpus = cpumask_new(s->cpu_count);
+    s->level_count[TOPO_MACHINE] = 1;
+    for (r = 0; r < count; r++) {
+        grp[r] = 0;
+        cpumask_set(node->cpus, recs[r].key[TOPO_THREAD]);
+    }
+    n = 1;
+
+    /* records are sorted, so the nodes of each level come out grouped
+     * by parent, and each parent's children are contiguous */
+    for (l = TOPO_PACKAGE; l < TOPO_N_LEVELS; l++) {
+        s->level_start[l] = n;
+        for (r = 0; r < count; r++) {
+            if (r == 0 || !same_prefix(&recs[r], &recs[r-1], l)) {
+                node = &s->nodes[n];
+                memset(node, 0, sizeof(*node));
+                node->level = l;
+                node->id = recs[r].id[l];
+                node->index = n - s->level_start[l];
+                node->parent = grp[(l - 1) * count + r];
+                node->first_child = -1;
+                node->cpus = cpumask_new(s->cpu_count);
+                parent = &s->nodes[node->parent];
+                if (!parent->child_count)
+                    parent->first_child = n;
+                parent->child_count++;
+                n++;
+            }
+            grp[l * count + r] = n - 1;
+            cpumask_set(s->nodes[n - 1].cpus, recs[r].key[TOPO_THREAD]);
+        }
+        s->level_count[l] = n - s->level_start[l];
+    }
+    s->node_count = n;
+
+    for (r = 0; r < count; r++)
+        for (l = TOPO_MACHINE; l < TOPO_N_LEVELS; l++)
+            s->cpu_nodes[recs[r].key[TOPO_THREAD] * TOPO_N_LEVELS + l] = grp[l * count + r];
+
+    free(grp);
+    return 1;
+}
+
+cpu_topo *cpu_topo_new() {
+    cpu_topo *s;
+    cpu_mask *online;
+    topo_rec *recs;
+    int cpu, count = 0;
+
+    s = malloc( sizeof(cpu_topo) );
+    if (s) {
+        memset(s, 0, sizeof(*s));
+        online = get_cpu_online();
+        recs = malloc(sizeof(topo_rec) * (cpumask_count(online) + 1));
+        if (recs) {
+            CPUMASK_FOR_EACH(cpu, online)
+                recs[count++].key[TOPO_THREAD] = cpu;
+            par_for(count, read_rec_item, recs);
+            if (count) {
+                qsort(recs, count, sizeof(topo_rec), rec_cmp);
+                build(s, recs, count);
+            }
+            free(recs);
+        }
+        cpumask_free(online);
+    }
+    return s;
+}
+
+void cpu_topo_free(cpu_topo *s) {
+    int i;
+    if (s) {
+        for (i = 0; i < s->node_count; i++)
+            cpumask_free(s->nodes[i].cpus);
+        free(s->nodes);
+        free(s->cpu_nodes);
+        free(s->desc);
+        fields_free(s->fields);
+        free(s);
+    }
+}
+
+int cpu_topo_count(cpu_topo *s, topo_level level) {
+    if (s && level >= TOPO_MACHINE && level < TOPO_N_LEVELS)
+        return s->level_count[level];
+    return 0;
+}
+
+const topo_node *cpu_topo_get(cpu_topo *s, topo_level level, int index) {
+    if (s && index >= 0 && index < cpu_topo_count(s, level))
+        return &s->nodes[s->level_start[level] + index];
+    return NULL;
+}
+
+const topo_node *cpu_topo_node(cpu_topo *s, int node) {
+    if (s && node >= 0 && node < s->node_count)
+        return &s->nodes[node];
+    return NULL;
+}
+
+const topo_node *cpu_topo_parent(cpu_topo *s, const topo_node *n) {
+    if (n)
+        return cpu_topo_node(s, n->parent);
+    return NULL;
+}
+
+const topo_node *cpu_topo_child(cpu_topo *s, const topo_node *n, int i) {
+    if (n && i >= 0 && i < n->child_count)
+        return cpu_topo_node(s, n->first_child + i);
+    return NULL;
+}
+
+const topo_node *cpu_topo_of_cpu(cpu_topo *s, int cpu, topo_level level) {
+    if (s && cpu >= 0 && cpu < s->cpu_count && level >= TOPO_MACHINE && level < TOPO_N_LEVELS)
+        return cpu_topo_node(s, s->cpu_nodes[cpu * TOPO_N_LEVELS + level]);
+    return NULL;
+}
+
+int cpu_topo_shared(cpu_topo *s, int cpu_a, int cpu_b, topo_level level) {
+    const topo_node *a = cpu_topo_of_cpu(s, cpu_a, level);
+    return (a && a == cpu_topo_of_cpu(s, cpu_b, level));
+}
+
+cpu_mask *cpu_topo_one_per(cpu_topo *s, topo_level level) {
+    cpu_mask *m;
+    int i;
+    if (!s) return NULL;
+    m = cpumask_new(s->cpu_count);
+    if (m)
+        for (i = 0; i < cpu_topo_count(s, level); i++)
+            cpumask_set(m, cpumask_next(cpu_topo_get(s, level, i)->cpus, -1));
+    return m;
+}
+
+/* "2 packages, 2 dies, 8 clusters, 8 cores, 16 threads" */
+const char *cpu_topo_desc(cpu_topo *s) {
+    char buff[256] = "";
+    int l, n, len = 0;
+    if (!s) return NULL;
+    if (!s->desc) {
+        for (l = TOPO_PACKAGE; l < TOPO_N_LEVELS; l++) {
+            n = cpu_topo_count(s, l);
+            len += snprintf(buff + len, sizeof(buff) - len, "%s%d %s%s",
+                len ? ", " : "", n, level_str[l],
+                (n == 1) ? "" : "s");
+        }
+        s->desc = strdup(buff);
+    }
+    return s->desc;
+}
+
+#define TOPO_COUNT_VALUE(l, name) \
+static int cpu_topo_##name##_value(cpu_topo *s, rpiz_value *v) { \
+    v->i = cpu_topo_count(s, l); \
+    return 1; \
+}
+TOPO_COUNT_VALUE(TOPO_PACKAGE, packages)
+TOPO_COUNT_VALUE(TOPO_DIE, dies)
+TOPO_COUNT_VALUE(TOPO_CLUSTER, clusters)
+TOPO_COUNT_VALUE(TOPO_CORE, cores)
+TOPO_COUNT_VALUE(TOPO_THREAD, threads)
+
+#define ADDFIELDSTR(t, l, o, n, str) fields_update_bytag(s->fields, t, l, o, n, NULL, (void*)str)
+#define ADDFIELDV(t, l, n, y, f) fields_update_value_bytag(s->fields, t, l, n, y, (rpiz_fields_value_func)f, (void*)s)
+rpiz_fields *cpu_topo_fields(cpu_topo *s) {
+    if (s) {
+        if (!s->fields) {
+            /* first insert creates */
+            s->fields =
+            ADDFIELDSTR("topo.desc",  0, 0, "Topology", cpu_topo_desc(s) );
+            ADDFIELDV("topo.packages", 0, "Packages", FIELD_INT64, cpu_topo_packages_value );
+            ADDFIELDV("topo.dies",     0, "Dies", FIELD_INT64, cpu_topo_dies_value );
+            ADDFIELDV("topo.clusters", 0, "Clusters", FIELD_INT64, cpu_topo_clusters_value );
+            ADDFIELDV("topo.cores",    0, "Cores", FIELD_INT64, cpu_topo_cores_value );
+            ADDFIELDV("topo.threads",  0, "Threads", FIELD_INT64, cpu_topo_threads_value );
+        }
+        return s->fields;
+    }
+    return NULL;
+}
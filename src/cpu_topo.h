@@ -0,0 +1,70 @@
+/*
+ * rpiz - https://github.com/bp0/rpiz
+ * Copyright (C) 2017  Burt P. <pburt0@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+#ifndef _CPU_TOPO_H_
+#define _CPU_TOPO_H_
+
+#include "fields.h"
+#include "util.h"
+
+typedef enum {
+    TOPO_MACHINE = 0,
+    TOPO_PACKAGE,
+    TOPO_DIE,
+    TOPO_CLUSTER,
+    TOPO_CORE,
+    TOPO_THREAD,
+    TOPO_N_LEVELS,
+} topo_level;
+
+typedef struct {
+    topo_level level;
+    int id;    /* physical_package_id, die_id, cluster_id, core_id or cpu number */
+    int index; /* position among the nodes of its level */
+    int parent; /* node number, -1 for the machine */
+    int first_child, child_count; /* children are contiguous node numbers */
+    cpu_mask *cpus;
+} topo_node;
+
+typedef struct cpu_topo cpu_topo;
+
+/* the package / die / cluster / core / thread tree for the online cpus,
+ * from /sys/devices/system/cpu/cpuN/topology. Nodes are stored
+ * level by level, so every lookup below is O(1). */
+cpu_topo *cpu_topo_new(void);
+void cpu_topo_free(cpu_topo *);
+
+int cpu_topo_count(cpu_topo *, topo_level);
+const topo_node *cpu_topo_get(cpu_topo *, topo_level, int index);
+const topo_node *cpu_topo_node(cpu_topo *, int node);
+const topo_node *cpu_topo_parent(cpu_topo *, const topo_node *);
+const topo_node *cpu_topo_child(cpu_topo *, const topo_node *, int i);
+const topo_node *cpu_topo_of_cpu(cpu_topo *, int cpu, topo_level); /* NULL if cpu is not online */
+int cpu_topo_shared(cpu_topo *, int cpu_a, int cpu_b, topo_level); /* same node at level */
+
+/* the first cpu of each node at level, e.g. one per physical core,
+ * free with cpumask_free() */
+cpu_mask *cpu_topo_one_per(cpu_topo *, topo_level);
+
+const char *cpu_topo_level_str(topo_level);
+const char *cpu_topo_desc(cpu_topo *);
+rpiz_fields *cpu_topo_fields(cpu_topo *);
+
+#endif
@@ -0,0 +1,296 @@
+/*
+ * rpiz - https://github.com/bp0/rpiz
+ * Copyright (C) 2017  Burt P. <pburt0@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "cpu_usable.h"
+#include "cpu_place.h"
+
+#define CGROUP_ROOT "/sys/fs/cgroup"
+
+/* path of this process in the hierarchy with controller,
+ * "0::/path" for v2, "N:cpu,cpuacct:/path" for v1 */
+static char *cgroup_of(const char *controller) {
+    char *fc, *line, *next, *c, *p, *ret = NULL;
+    int cl = controller ? strlen(controller) : 0;
+    fc = get_file_contents("/proc/self/cgroup");
+    if (!fc) return NULL;
+    for (line = fc; line && *line && !ret; line = next) {
+        next = strchr(line, '\n');
+        if (next) *next++ = 0;
+        c = strchr(line, ':');
+        if (!c) continue;
+        c++;
+        p = strchr(c, ':');
+        if (!p) continue;
+        *p++ = 0;
+        if (!controller) {
+            if (*c == 0)
+                ret = strdup(p);
+            continue;
+        }
+        /* controller list, like "cpu,cpuacct" */
+        while (c && *c) {
+            if (strncmp(c, controller, cl) == 0 && (c[cl] == ',' || c[cl] == 0)) {
+                ret = strdup(p);
+                break;
+            }
+            c = strchr(c, ',');
+            if (c) c++;
+        }
+    }
+    free(fc);
+    return ret;
+}
+
+static char *cgroup_file(const char *mount, const char *path, const char *file) {
+    char fn[1024];
+    snprintf(fn, sizeof(fn), "%s%s/%s", mount, (strcmp(path, "/") == 0) ? "" : path, file);
+    return get_file_contents(fn);
+}
+
+/* strip the last component, 0 when already at the root */
+static int cgroup_parent(char *path) {
+    char *p = strrchr(path, '/');
+    if (!p || (p == path && !p[1]))
+        return 0;
+    if (p == path)
+        p[1] = 0;
+    else
+        *p = 0;
+    return 1;
+}
+
+/* the tightest quota of the cgroup and its ancestors */
+static void read_quota(cpu_usable *s, const char *mount, const char *cg) {
+    char *path = strdup(cg), *fc, *fp;
+    long long q, p;
+    if (!path) return;
+    do {
+        q = -1; p = 0;
+        if (s->cgroup_version == 2) {
+            /* "max 100000" or "400000 100000" */
+            fc = cgroup_file(mount, path, "cpu.max");
+            if (fc) {
+                if (strncmp(fc, "max", 3) != 0)
+                    q = strtoll(fc, &fp, 10), p = strtoll(fp, NULL, 10);
+                free(fc);
+            }
+        } else {
+            fc = cgroup_file(mount, path, "cpu.cfs_quota_us");
+            fp = cgroup_file(mount, path, "cpu.cfs_period_us");
+            if (fc && fp) {
+                q = strtoll(fc, NULL, 10);
+                p = strtoll(fp, NULL, 10);
+            }
+            free(fc);
+            free(fp);
+        }
+        if (q > 0 && p > 0)
+            if (s->quota_us < 0 || (double)q / p < (double)s->quota_us / s->period_us) {
+                s->quota_us = q;
+                s->period_us = p;
+            }
+    } while (cgroup_parent(path));
+    free(path);
+}
+
+static void read_cpuset(cpu_usable *s, const char *mount, const char *cg, const char *file) {
+    char *path = strdup(cg), *fc;
+    if (!path) return;
+    /* the first level that has the file, cpusets only narrow going down */
+    do {
+        fc = cgroup_file(mount, path, file);
+        if (fc) {
+            s->cpuset = cpumask_from_list(fc);
+            free(fc);
+            /* an empty cpuset file means "inherit" on v1 */
+            if (cpumask_count(s->cpuset))
+                break;
+            cpumask_free(s->cpuset);
+            s->cpuset = NULL;
+        }
+    } while (cgroup_parent(path));
+    free(path);
+}
+
+static void read_cgroup(cpu_usable *s) {
+    char *fc, *cg;
+
+    s->quota_us = -1;
+    fc = get_file_contents(CGROUP_ROOT "/cgroup.controllers");
+    if (fc) {
+        free(fc);
+        cg = cgroup_of(NULL);
+        if (!cg) return;
+        s->cgroup_version = 2;
+        s->cgroup_path = cg;
+        read_quota(s, CGROUP_ROOT, cg);
+        read_cpuset(s, CGROUP_ROOT, cg, "cpuset.cpus.effective");
+        return;
+    }
+
+    cg = cgroup_of("cpu");
+    if (cg) {
+        s->cgroup_version = 1;
+        s->cgroup_path = cg;
+        if (dir_exists(CGROUP_ROOT "/cpu,cpuacct"))
+            read_quota(s, CGROUP_ROOT "/cpu,cpuacct", cg);
+        else
+            read_quota(s, CGROUP_ROOT "/cpu", cg);
+    }
+    cg = cgroup_of("cpuset");
+    if (cg) {
+        s->cgroup_version = 1;
+        read_cpuset(s, CGROUP_ROOT "/cpuset", cg, "cpuset.effective_cpus");
+        if (!s->cpuset)
+            read_cpuset(s, CGROUP_ROOT "/cpuset", cg, "cpuset.cpus");
+        if (!s->cgroup_path)
+            s->cgroup_path = cg;
+        else
+            free(cg);
+    }
+}
+
+cpu_usable *cpu_usable_new() {
+    cpu_usable *s;
+    cpu_mask *m;
+    int n;
+
+    s = malloc( sizeof(cpu_usable) );
+    if (s) {
+        memset(s, 0, sizeof(*s));
+        s->online = get_cpu_online();
+        s->affinity = place_affinity();
+        s->isolated = get_cpu_mask("/sys/devices/system/cpu/isolated");
+        s->nohz_full = get_cpu_mask("/sys/devices/system/cpu/nohz_full");
+        read_cgroup(s);
+
+        s->usable = cpumask_copy(s->online);
+        cpumask_and(s->usable, s->affinity);
+        cpumask_and(s->usable, s->cpuset);
+        /* isolated cpus only count when they are all we were given */
+        m = cpumask_copy(s->usable);
+        cpumask_andnot(m, s->isolated);
+        if (cpumask_count(m)) {
+            cpumask_free(s->usable);
+            s->usable = m;
+        } else
+            cpumask_free(m);
+
+        n = cpumask_count(s->usable);
+        if (s->quota_us > 0 && s->period_us > 0) {
+            /* round up, a 2.5 cpu quota still runs 3 threads well */
+            int q = (int)((s->quota_us + s->period_us - 1) / s->period_us);
+            if (q < n) n = q;
+        }
+        s->parallelism = (n > 0) ? n : 1;
+    }
+    return s;
+}
+
+void cpu_usable_free(cpu_usable *s) {
+    if (s) {
+        cpumask_free(s->online);
+        cpumask_free(s->affinity);
+        cpumask_free(s->isolated);
+        cpumask_free(s->nohz_full);
+        cpumask_free(s->cpuset);
+        cpumask_free(s->usable);
+        free(s->cgroup_path);
+        fields_free(s->fields);
+        free(s);
+    }
+}
+
+double cpu_usable_quota(cpu_usable *s) {
+    if (s && s->quota_us > 0 && s->period_us > 0)
+        return (double)s->quota_us / s->period_us;
+    return 0;
+}
+
+static char *mask_str(cpu_mask *m) {
+    if (!cpumask_count(m))
+        return strdup("(none)");
+    return cpumask_to_list(m);
+}
+
+static char *cpu_usable_online_str(cpu_usable *s) { return mask_str(s->online); }
+static char *cpu_usable_affinity_str(cpu_usable *s) { return mask_str(s->affinity); }
+static char *cpu_usable_isolated_str(cpu_usable *s) { return mask_str(s->isolated); }
+static char *cpu_usable_nohz_full_str(cpu_usable *s) { return mask_str(s->nohz_full); }
+static char *cpu_usable_cpuset_str(cpu_usable *s) { return mask_str(s->cpuset); }
+static char *cpu_usable_cpus_str(cpu_usable *s) { return mask_str(s->usable); }
+
+static int cpu_usable_count_value(cpu_usable *s, rpiz_value *v) {
+    v->i = cpumask_count(s->usable);
+    return 1;
+}
+
+static char *cpu_usable_quota_str(cpu_usable *s) {
+    char *buff = malloc(64);
+    if (buff) {
+        if (cpu_usable_quota(s) > 0)
+            snprintf(buff, 63, "%0.2f cpus (%lld/%lld us)", cpu_usable_quota(s), s->quota_us, s->period_us);
+        else
+            snprintf(buff, 63, "(none)");
+    }
+    return buff;
+}
+
+static char *cpu_usable_cgroup_str(cpu_usable *s) {
+    char *buff = malloc(1100);
+    if (buff) {
+        if (s->cgroup_version)
+            snprintf(buff, 1099, "v%d %s", s->cgroup_version, s->cgroup_path ? s->cgroup_path : "");
+        else
+            snprintf(buff, 1099, "(none)");
+    }
+    return buff;
+}
+
+static int cpu_usable_parallelism_value(cpu_usable *s, rpiz_value *v) {
+    v->i = s->parallelism;
+    return 1;
+}
+
+#define ADDFIELD(t, l, o, n, f) fields_update_bytag(s->fields, t, l, o, n, (rpiz_fields_get_func)f, (void*)s)
+#define ADDFIELDV(t, l, n, y, f) fields_update_value_bytag(s->fields, t, l, n, y, (rpiz_fields_value_func)f, (void*)s)
+rpiz_fields *cpu_usable_fields(cpu_usable *s) {
+    if (s) {
+        if (!s->fields) {
+            /* first insert creates */
+            s->fields =
+            ADDFIELDV("usable.parallelism", 0, "Effective Parallelism", FIELD_INT64, cpu_usable_parallelism_value );
+            ADDFIELDV("usable.count",     0, "Usable CPUs", FIELD_INT64, cpu_usable_count_value );
+            ADDFIELD("usable.cpus",      0, 1, "Usable CPU List", cpu_usable_cpus_str );
+            ADDFIELD("usable.online",    0, 1, "Online", cpu_usable_online_str );
+            ADDFIELD("usable.affinity",  0, 1, "Affinity", cpu_usable_affinity_str );
+            ADDFIELD("usable.isolated",  0, 1, "Isolated", cpu_usable_isolated_str );
+            ADDFIELD("usable.nohz_full", 0, 1, "NOHZ Full", cpu_usable_nohz_full_str );
+            ADDFIELD("usable.cpuset",    0, 1, "cgroup cpuset", cpu_usable_cpuset_str );
+            ADDFIELD("usable.quota",     0, 1, "cgroup CPU Quota", cpu_usable_quota_str );
+            ADDFIELD("usable.cgroup",    0, 1, "cgroup", cpu_usable_cgroup_str );
+        }
+        return s->fields;
+    }
+    return NULL;
+}
@@ -0,0 +1,53 @@
+/*
+ * rpiz - https://github.com/bp0/rpiz
+ * Copyright (C) 2017  Burt P. <pburt0@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+#ifndef _CPU_USABLE_H_
+#define _CPU_USABLE_H_
+
+#include "fields.h"
+#include "util.h"
+
+typedef struct {
+    cpu_mask *online;
+    cpu_mask *affinity;  /* sched_getaffinity(), or Cpus_allowed_list below a sysroot */
+    cpu_mask *isolated;  /* isolcpus= */
+    cpu_mask *nohz_full;
+    cpu_mask *cpuset;    /* cgroup cpuset effective cpus, NULL if not limited */
+    cpu_mask *usable;    /* online & affinity & cpuset, without isolated */
+
+    int cgroup_version;  /* 0 if no cgroup was found */
+    char *cgroup_path;
+    long long quota_us, period_us; /* cgroup cpu bandwidth, quota_us < 0 if unlimited */
+
+    int parallelism; /* usable cpus, capped by the cpu quota */
+
+    rpiz_fields *fields;
+} cpu_usable;
+
+/* what this process can actually run on, which in a container is often
+ * far less than the threads in /proc/cpuinfo */
+cpu_usable *cpu_usable_new(void);
+void cpu_usable_free(cpu_usable *);
+
+double cpu_usable_quota(cpu_usable *); /* cpus worth of quota, 0 if unlimited */
+
+rpiz_fields *cpu_usable_fields(cpu_usable *);
+
+#endif
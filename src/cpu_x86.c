@@ -23,18 +23,18 @@
 #include <string.h>
 #include "util.h"
 #include "cpu_x86.h"
-
-#define MAX_THREADS 128
+#include "cpu_table.h"
 
 static const char unk[] = "";
 
 static int search_for_flag(char *flags, const char *flag) {
-    char *p = strstr(flags, flag);
+    char *p;
     int l = strlen(flag);
     int front = 0, back = 0;
     //DEBUG printf("search_for_flag( %x, \"%s\")\n", flags, flag);
-    if (strlen(flag) == 0 || strchr(flag, ' ') )
+    if (!flags || strlen(flag) == 0 || strchr(flag, ' ') )
         return 0;
+    p = strstr(flags, flag);
     while (p) {
         if (p == flags) front = 1;
         else if (*(p - 1) == ' ') front = 1;
@@ -48,8 +48,7 @@ static int search_for_flag(char *flags, const char *flag) {
 }
 
 typedef struct {
-    int id, core, proc;
-    int cpukhz_min, cpukhz_max, cpukhz_cur;
+    int core, proc;
 
     /* point to a cpu_string.str */
     char *model_name;
@@ -76,37 +75,73 @@ struct x86_proc {
     cpu_string_list *physical_id;
     cpu_string_list *core_id;
 
-    cpu_string_list *each_flag;
+    char *all_flags; /* the known flags, then any others seen, after LAZY_FLAGS */
+    cpu_flagset *flagset; /* x86_flag_id bits, then unknown flags */
 
     char *cpu_name; /* do not free */
     char *cpu_desc;
     int max_khz;
 
+    /* per-thread storage is sized to the cpuinfo: the x86_thread
+     * array holds the strings, while ids and frequencies are kept
+     * as contiguous columns */
     int thread_count;
-    x86_thread threads[MAX_THREADS];
+    int thread_alloc;
+    x86_thread *threads;
+    int *thread_id;
+    int *khz_min, *khz_max, *khz_cur;
     int core_count;
     int proc_count;
 
+    int lazy; /* LAZY_* parts done */
     rpiz_fields *fields;
+    cpu_table *table;
 };
 
-#define CHECK_FOR(k) (strncmp(k, key, (strlen(k) < strlen(key)) ? strlen(k) : strlen(key)) == 0)
-#define GET_STR(k, s) if (CHECK_FOR(k)) { p->threads[thread].s = strlist_add(p->s, value); continue; }
+/* parts not needed to count threads, made on first use */
+#define LAZY_FREQ  0x01
+#define LAZY_DESC  0x02
+#define LAZY_FLAGS 0x04
+
+#define CHECK_FOR(k) KV_IS(&key, k)
+#define GET_STR(k, s) if (CHECK_FOR(k)) { p->threads[thread].s = strlist_add_n(p->s, value.str, value.len); continue; }
 #define FIN_PROC() if (thread >= 0) if (!p->threads[thread].model_name) { p->threads[thread].model_name = strlist_add(p->model_name, rep_pname); }
 
 #define REDUP(f) if(p->threads[di].f && !p->threads[i].f) { p->threads[i].f = strlist_add(p->f, p->threads[di].f); }
 
-#ifndef PROC_CPUINFO
-#define PROC_CPUINFO "/proc/cpuinfo"
-#endif
+#define RESIZE_COL(c, n) { void *tmp = realloc(p->c, sizeof(*p->c) * (n)); if (!tmp) return 0; p->c = tmp; }
+static int resize_threads(x86_proc *p, int n) {
+    if (n < 1) n = 1;
+    RESIZE_COL(threads, n);
+    RESIZE_COL(thread_id, n);
+    RESIZE_COL(khz_min, n);
+    RESIZE_COL(khz_max, n);
+    RESIZE_COL(khz_cur, n);
+    p->thread_alloc = n;
+    return 1;
+}
+
+static int new_thread(x86_proc *p, int thread, int id) {
+    int n = p->thread_alloc ? p->thread_alloc : 8;
+    if (thread >= p->thread_alloc) {
+        while (n <= thread) n *= 2;
+        if (!resize_threads(p, n))
+            return 0;
+    }
+    memset(&p->threads[thread], 0, sizeof(x86_thread));
+    p->thread_id[thread] = id;
+    p->khz_min[thread] = p->khz_max[thread] = p->khz_cur[thread] = 0;
+    return 1;
+}
 
 static int scan_cpu(x86_proc* p) {
-    kv_scan *kv; char *key, *value;
+    kv_scan *kv; kv_slice key, value;
     int thread = -1;
     int i, di;
     char rep_pname[256] = "";
-    char tmp_maxfreq[128];
     char *tmp_str = NULL;
+    cpu_string_list *core_keys;
+    char core_key[64];
 
     if (!p) return 0;
 
@@ -114,15 +149,15 @@ static int scan_cpu(x86_proc* p) {
     if (kv) {
         while( kv_next(kv, &key, &value) ) {
             if (CHECK_FOR("Processor")) {
-                strcpy(rep_pname, value);
+                kv_slice_copy(rep_pname, sizeof(rep_pname), &value);
                 continue;
             }
 
             if (CHECK_FOR("processor")) {
                 FIN_PROC();
+                if (!new_thread(p, thread + 1, atoi(value.str)))
+                    break;
                 thread++;
-                memset(&p->threads[thread], 0, sizeof(x86_thread));
-                p->threads[thread].id = atoi(value);
                 continue;
             }
 
@@ -131,9 +166,9 @@ static int scan_cpu(x86_proc* p) {
                      || CHECK_FOR("flags") ) {
                     /* this cpuinfo doesn't provide processor : n
                      * there is prolly only one thread */
+                    if (!new_thread(p, thread + 1, 0))
+                        break;
                     thread++;
-                    memset(&p->threads[thread], 0, sizeof(x86_thread));
-                    p->threads[thread].id = 0;
                 }
             }
             if (thread >= 0) {
@@ -147,19 +182,19 @@ static int scan_cpu(x86_proc* p) {
                 GET_STR("power management", pm_flags);
 
                 if (CHECK_FOR("fdiv_bug") ) {
-                    if (strncmp(value, "yes", 3) == 0)
+                    if (strncmp(value.str, "yes", 3) == 0)
                         p->threads[thread].bug_fdiv = 1;
                 }
                 if (CHECK_FOR("hlt_bug")) {
-                    if (strncmp(value, "yes", 3) == 0)
+                    if (strncmp(value.str, "yes", 3) == 0)
                         p->threads[thread].bug_hlt = 1;
                 }
                 if (CHECK_FOR("f00f_bug")) {
-                    if (strncmp(value, "yes", 3) == 0)
+                    if (strncmp(value.str, "yes", 3) == 0)
                         p->threads[thread].bug_f00f = 1;
                 }
                 if (CHECK_FOR("coma_bug")) {
-                    if (strncmp(value, "yes", 3) == 0)
+                    if (strncmp(value.str, "yes", 3) == 0)
                         p->threads[thread].bug_coma = 1;
                 }
 
@@ -171,6 +206,8 @@ static int scan_cpu(x86_proc* p) {
         return 0;
 
     p->thread_count = thread + 1;
+    /* trim to size */
+    resize_threads(p, p->thread_count);
 
     /* re-duplicate missing data for /proc/cpuinfo variant that de-duplicated it */
     di = p->thread_count - 1;
@@ -189,17 +226,24 @@ static int scan_cpu(x86_proc* p) {
         if (p->threads[i].core_id)
             p->threads[i].core = strtol(p->threads[i].core_id, NULL, 0);
         else
-            p->threads[i].core = p->threads[i].id;
+            p->threads[i].core = p->thread_id[i];
 
         if (p->threads[i].physical_id)
             p->threads[i].proc = strtol(p->threads[i].physical_id, NULL, 0);
     }
-    p->core_count = p->core_id->count;
+    /* core ids repeat in each package, count distinct pairs */
+    core_keys = strlist_new();
+    for (i = 0; core_keys && i < p->thread_count; i++) {
+        if (!p->threads[i].core_id) continue;
+        snprintf(core_key, sizeof(core_key), "%d:%d", p->threads[i].proc, p->threads[i].core);
+        strlist_add(core_keys, core_key);
+    }
+    p->core_count = core_keys ? core_keys->count : 0;
+    strlist_free(core_keys);
     p->proc_count = p->physical_id->count;
     if (!p->core_count) p->core_count = p->thread_count;
     if (!p->proc_count) p->proc_count = p->thread_count;
 
-    /* data not from /proc/cpuinfo */
     for (i = 0; i < p->thread_count; i++) {
         if (p->threads[i].bug_flags == NULL) {
             /* make bugs list on old kernels that don't offer one */
@@ -228,18 +272,24 @@ static int scan_cpu(x86_proc* p) {
         tmp_str = strdup("(Unknown)");
         p->threads[i].decoded_name = strlist_add(p->decoded_name, tmp_str);
         free(tmp_str); tmp_str = NULL;
-
-        /* freq */
-        get_cpu_freq(p->threads[i].id, &p->threads[i].cpukhz_min, &p->threads[i].cpukhz_max, &p->threads[i].cpukhz_cur);
-        sprintf(tmp_maxfreq, "%d", p->threads[i].cpukhz_max);
-        p->threads[i].cpukhz_max_str = strlist_add(p->cpukhz_max_str, tmp_maxfreq);
-        if (p->threads[i].cpukhz_max > p->max_khz)
-            p->max_khz = p->threads[i].cpukhz_max;
     }
 
     return 1;
 }
 
+/* data not from /proc/cpuinfo */
+static void scan_freq(x86_proc *p) {
+    char tmp_maxfreq[128];
+    int i;
+    get_cpu_freq_batch(p->thread_id, p->thread_count, p->khz_min, p->khz_max, p->khz_cur);
+    for (i = 0; i < p->thread_count; i++) {
+        sprintf(tmp_maxfreq, "%d", p->khz_max[i]);
+        p->threads[i].cpukhz_max_str = strlist_add(p->cpukhz_max_str, tmp_maxfreq);
+        if (p->khz_max[i] > p->max_khz)
+            p->max_khz = p->khz_max[i];
+    }
+}
+
 static char *gen_cpu_desc(x86_proc *p) {
     char *ret = NULL;
     char tmp[1024];
@@ -272,50 +322,112 @@ static char *gen_cpu_desc(x86_proc *p) {
     return ret;
 }
 
-#define APPEND_FLAG(f) strcat(all_flags, f); strcat(all_flags, " ");
+/* list + flag + " " */
+static char *append_flag(char *list, const char *flag) {
+    int l = strlen(list), fl = strlen(flag);
+    char *tmp = realloc(list, l + fl + 2);
+    if (!tmp) return list;
+    memcpy(tmp + l, flag, fl);
+    tmp[l + fl] = ' ';
+    tmp[l + fl + 1] = 0;
+    return tmp;
+}
+
+#define APPEND_FLAG(f) s->all_flags = append_flag(s->all_flags, f);
 static void process_flags(x86_proc *s) {
     char flag[32] = "";
-    char *all_flags; /* x86_data.c: static char all_flags[4096] */
-    char *cur, *next;
-    int added_count = 0, i, si;
-    if (!s) return;
+    char *cur, *next, *tstr[3];
+    unsigned long long *sbits[3] = { NULL, NULL, NULL };
+    int added_count = 0, i, si, id, pass, words = 0;
+    if (!s || !s->flagset) return;
 
     cpu_string_list *sets[3] = { s->flags, s->bug_flags, s->pm_flags };
     char *prefix[3] = { "", "bug:", "pm:" };
-    int plen = 0, flen = 0;
-
-    all_flags = (char*)x86_flag_list();
-
-    for(si = 0; si < 3; si++) {
-        plen = strlen(prefix[si]);
-        for(i = 0; i < sets[si]->count; i++) {
-            if (sets[si]->strs[i].str) {
-                cur = sets[si]->strs[i].str;
-                next = strchr(cur, ' '); if (!next) next = strchr(cur, '\0');
-                while(next) {
-                    flen = next-cur;
-                    if (flen <= (31 - plen) ) {
-                        memset(flag, 0, 32);
-                        snprintf(flag, plen + flen + 1, "%s%s", prefix[si], cur);
-                        if (strlen(flag) > (unsigned int)plen) {
-                            /* add it to the string list, copy the flag string's ref_count */
-                            strlist_add_w(s->each_flag, flag, sets[si]->strs[i].ref_count);
-
-                            /* add it to the list of known all flags, if it isn't there */
-                            if (!search_for_flag(all_flags, flag)) {
-                                APPEND_FLAG(flag);
-                                added_count++;
+    int plen = 0, flen = 0, n = 0;
+
+    s->all_flags = strdup(x86_flag_list());
+    if (!s->all_flags) return;
+
+    /* pass 0 gives every flag a bit, pass 1 sets the bits
+     * for each distinct flags string */
+    for(pass = 0; pass < 2; pass++) {
+        if (pass == 1) {
+            if (!flagset_alloc(s->flagset, s->thread_count))
+                return;
+            words = s->flagset->words;
+            for(si = 0; si < 3; si++) {
+                sbits[si] = calloc((size_t)sets[si]->count * words + 1, sizeof(unsigned long long));
+                if (!sbits[si]) goto done;
+            }
+        }
+        for(si = 0; si < 3; si++) {
+            plen = strlen(prefix[si]);
+            for(i = 0; i < sets[si]->count; i++) {
+                if (sets[si]->strs[i].str) {
+                    cur = sets[si]->strs[i].str;
+                    next = strchr(cur, ' '); if (!next) next = strchr(cur, '\0');
+                    while(next) {
+                        flen = next-cur;
+                        if (flen > 0 && flen <= (31 - plen) ) {
+                            memcpy(flag, prefix[si], plen);
+                            memcpy(flag + plen, cur, flen);
+                            flag[plen + flen] = 0;
+                            if (pass == 0) {
+                                n = s->flagset->ids->count;
+                                id = flagset_id(s->flagset, flag, plen + flen, 1);
+                                /* add it to the list of known all flags, if it isn't there */
+                                if (id == n && !search_for_flag(s->all_flags, flag)) {
+                                    APPEND_FLAG(flag);
+                                    added_count++;
+                                }
+                            } else {
+                                id = flagset_id(s->flagset, flag, plen + flen, 0);
+                                if (id >= 0)
+                                    FLAGSET_BIT_SET(sbits[si] + (size_t)i * words, id);
                             }
                         }
+                        if (*next == '\0') break;
+                        cur = next + 1;
+                        next = strchr(cur, ' '); if (!next) next = strchr(cur, '\0');
                     }
-                    if (*next == '\0') break;
-                    cur = next + 1;
-                    next = strchr(cur, ' '); if (!next) next = strchr(cur, '\0');
                 }
             }
         }
     }
-    //DEBUG printf("process_flags(): added %d previously unknown flags\n(%d): %s\n", added_count, (int)strlen(all_flags), all_flags );
+
+    /* a thread's row is the union of its flags, bugs and pm strings */
+    for(i = 0; i < s->thread_count; i++) {
+        tstr[0] = s->threads[i].flags;
+        tstr[1] = s->threads[i].bug_flags;
+        tstr[2] = s->threads[i].pm_flags;
+        for(si = 0; si < 3; si++) {
+            n = strlist_find(sets[si], tstr[si]);
+            if (n >= 0)
+                flagset_or(s->flagset, i, sbits[si] + (size_t)n * words);
+        }
+    }
+    flagset_count_rows(s->flagset);
+done:
+    for(si = 0; si < 3; si++)
+        free(sbits[si]);
+    //DEBUG printf("process_flags(): added %d previously unknown flags\n(%d): %s\n", added_count, (int)strlen(s->all_flags), s->all_flags );
+}
+
+static void make_desc(x86_proc *p) {
+    p->cpu_desc = gen_cpu_desc(p);
+}
+
+static void need_freq(x86_proc *p) {
+    lazy_once(&p->lazy, LAZY_FREQ, (lazy_func)scan_freq, p);
+}
+
+static void need_desc(x86_proc *p) {
+    need_freq(p);
+    lazy_once(&p->lazy, LAZY_DESC, (lazy_func)make_desc, p);
+}
+
+static void need_flags(x86_proc *p) {
+    lazy_once(&p->lazy, LAZY_FLAGS, (lazy_func)process_flags, p);
 }
 
 x86_proc *x86_proc_new(void) {
@@ -330,17 +442,15 @@ x86_proc *x86_proc_new(void) {
         s->cpukhz_max_str = strlist_new();
         s->core_id = strlist_new();
         s->physical_id = strlist_new();
-        s->each_flag = strlist_new();
+        s->flagset = flagset_new(x86_flag_name, X86_FLAG_N_KNOWN);
         if (!scan_cpu(s)) {
             x86_proc_free(s);
             return NULL;
         }
-        s->cpu_desc = gen_cpu_desc(s);
         if (s->model_name->count == 1)
             s->cpu_name = s->model_name->strs[0].str;
         else
             s->cpu_name = (char *)unk;
-        process_flags(s);
     }
     return s;
 }
@@ -355,8 +465,15 @@ void x86_proc_free(x86_proc *s) {
         strlist_free(s->cpukhz_max_str);
         strlist_free(s->core_id);
         strlist_free(s->physical_id);
-        strlist_free(s->each_flag);
+        flagset_free(s->flagset);
+        free(s->all_flags);
         fields_free(s->fields);
+        cpu_table_free(s->table);
+        free(s->threads);
+        free(s->thread_id);
+        free(s->khz_min);
+        free(s->khz_max);
+        free(s->khz_cur);
         free(s->cpu_desc);
         free(s);
     }
@@ -370,20 +487,48 @@ const char *x86_proc_name(x86_proc *s) {
 }
 
 const char *x86_proc_desc(x86_proc *s) {
-    if (s)
+    if (s) {
+        need_desc(s);
         return s->cpu_desc;
+    }
     else
         return NULL;
 }
 
-int x86_proc_has_flag(x86_proc *s, const char *flag) {
-    int i;
+const char *x86_proc_flag_list(x86_proc *s) {
+    /* flags not in the table are appended as they are processed */
+    if (s) {
+        need_flags(s);
+        if (s->all_flags)
+            return s->all_flags;
+    }
+    return x86_flag_list();
+}
+
+int x86_proc_flag_id(x86_proc *s, const char *flag) {
     if (s && flag) {
-        for (i = 0; i < s->each_flag->count; i++) {
-            //DEBUG printf("(%s)...[%d/%d] %s %d\n", flag, i, s->each_flag->count, s->each_flag->strs[i].str, s->each_flag->strs[i].ref_count);
-            if (strcmp(s->each_flag->strs[i].str, flag) == 0)
-                return s->each_flag->strs[i].ref_count;
-        }
+        need_flags(s);
+        return flagset_id(s->flagset, flag, strlen(flag), 0);
+    }
+    return -1;
+}
+
+int x86_proc_has_flag(x86_proc *s, const char *flag) {
+    return x86_proc_has_feature(s, x86_proc_flag_id(s, flag));
+}
+
+int x86_proc_has_feature(x86_proc *s, int id) {
+    if (s) {
+        need_flags(s);
+        return flagset_count(s->flagset, id);
+    }
+    return 0;
+}
+
+int x86_proc_thread_has_feature(x86_proc *s, int thread, int id) {
+    if (s) {
+        need_flags(s);
+        return flagset_test(s->flagset, thread, id);
     }
     return 0;
 }
@@ -413,7 +558,7 @@ int x86_proc_thread_from_id(x86_proc *s, int id) {
     int i = 0;
     if (s)
         for (i = 0; i < s->thread_count; i++ )
-            if (s->threads[i].id == id)
+            if (s->thread_id[i] == id)
                 return i;
 
     return -1;
@@ -422,23 +567,35 @@ int x86_proc_thread_from_id(x86_proc *s, int id) {
 int x86_proc_thread_id(x86_proc *s, int thread) {
     if (s)
         if (thread >= 0 && thread < s->thread_count)
-            return s->threads[thread].id;
+            return s->thread_id[thread];
 
     return 0;
 }
 
-int x86_proc_thread_khz_min(x86_proc *s, int thread) {
+const char *x86_proc_thread_model_name(x86_proc *s, int thread) {
     if (s)
         if (thread >= 0 && thread < s->thread_count)
-            return s->threads[thread].cpukhz_min;
+            return s->threads[thread].model_name;
+
+    return NULL;
+}
+
+int x86_proc_thread_khz_min(x86_proc *s, int thread) {
+    if (s)
+        if (thread >= 0 && thread < s->thread_count) {
+            need_freq(s);
+            return s->khz_min[thread];
+        }
 
     return 0;
 }
 
 int x86_proc_thread_khz_max(x86_proc *s, int thread) {
     if (s)
-        if (thread >= 0 && thread < s->thread_count)
-            return s->threads[thread].cpukhz_max;
+        if (thread >= 0 && thread < s->thread_count) {
+            need_freq(s);
+            return s->khz_max[thread];
+        }
 
     return 0;
 }
@@ -446,44 +603,68 @@ int x86_proc_thread_khz_max(x86_proc *s, int thread) {
 int x86_proc_thread_khz_cur(x86_proc *s, int thread) {
     if (s)
         if (thread >= 0 && thread < s->thread_count) {
-            get_cpu_freq(s->threads[thread].id, NULL, NULL, &s->threads[thread].cpukhz_cur);
-            return s->threads[thread].cpukhz_cur;
+            need_freq(s);
+            get_cpu_freq(s->thread_id[thread], NULL, NULL, &s->khz_cur[thread]);
+            return s->khz_cur[thread];
         }
     return 0;
 }
 
-static char* x86_proc_threads_str(x86_proc *s) {
-    char *buff = NULL;
-    if (s) {
-        buff = malloc(128);
-        if (buff)
-            snprintf(buff, 127, "%d", x86_proc_threads(s) );
-    }
-    return buff;
+static int x86_proc_threads_value(x86_proc *s, rpiz_value *v) {
+    v->i = x86_proc_threads(s);
+    return 1;
 }
 
-static char* x86_proc_cores_str(x86_proc *s) {
-    char *buff = NULL;
-    if (s) {
-        buff = malloc(128);
-        if (buff)
-            snprintf(buff, 127, "%d", x86_proc_cores(s) );
-    }
-    return buff;
+static int x86_proc_cores_value(x86_proc *s, rpiz_value *v) {
+    v->i = x86_proc_cores(s);
+    return 1;
 }
 
-static char* x86_proc_count_str(x86_proc *s) {
-    char *buff = NULL;
+static int x86_proc_count_value(x86_proc *s, rpiz_value *v) {
+    v->i = x86_proc_count(s);
+    return 1;
+}
+
+static void refresh_khz_cur(x86_proc *s) {
+    get_cpu_freq_cur_batch(s->thread_id, s->thread_count, s->khz_cur);
+}
+
+#define ADDCOL(n, l, t, f, fl, ff) cpu_table_add(s->table, n, l, t, &s->threads[0].f, sizeof(x86_thread), fl, ff)
+#define ADDCOLINT(n, c, fl) cpu_table_add(s->table, n, NULL, CELL_INT, s->c, sizeof(int), fl, NULL)
+/* the flat fields use it without the freq columns, so only
+ * x86_proc_table() reads those */
+static cpu_table *make_table(x86_proc *s) {
     if (s) {
-        buff = malloc(128);
-        if (buff)
-            snprintf(buff, 127, "%d", x86_proc_count(s) );
+        if (!s->table) {
+            s->table = cpu_table_new(s->thread_count, s->thread_id, s);
+            if (!s->table) return NULL;
+            ADDCOL("model_name",  NULL, CELL_STR, model_name,  0, NULL);
+            ADDCOL("flags",       NULL, CELL_STR, flags,       0, NULL);
+            ADDCOL("bug_flags",   NULL, CELL_STR, bug_flags,   0, NULL);
+            ADDCOL("pm_flags",    NULL, CELL_STR, pm_flags,    0, NULL);
+            ADDCOL("physical_id", NULL, CELL_STR, physical_id, 0, NULL);
+            ADDCOL("core_id",     NULL, CELL_STR, core_id,     0, NULL);
+            ADDCOL("core",        NULL, CELL_INT, core,        0, NULL);
+            ADDCOL("proc",        NULL, CELL_INT, proc,        0, NULL);
+            ADDCOLINT("khz_min", khz_min, 0);
+            ADDCOLINT("khz_max", khz_max, 0);
+            ADDCOLINT("khz_cur", khz_cur, COL_LIVE);
+            cpu_table_set_refresh(s->table, (cpu_table_refresh_func)refresh_khz_cur);
+        }
+        return s->table;
     }
-    return buff;
+    return NULL;
+}
+
+cpu_table *x86_proc_table(x86_proc *s) {
+    if (s)
+        need_freq(s);
+    return make_table(s);
 }
 
 #define ADDFIELD(t, l, o, n, f) fields_update_bytag(s->fields, t, l, o, n, (rpiz_fields_get_func)f, (void*)s)
 #define ADDFIELDSTR(t, l, o, n, str) fields_update_bytag(s->fields, t, l, o, n, NULL, (void*)str)
+#define ADDFIELDV(t, l, n, y, f) fields_update_value_bytag(s->fields, t, l, n, y, (rpiz_fields_value_func)f, (void*)s)
 rpiz_fields *x86_proc_fields(x86_proc *s) {
     if (s) {
         if (!s->fields) {
@@ -492,9 +673,9 @@ rpiz_fields *x86_proc_fields(x86_proc *s) {
             ADDFIELD("summary.proc_desc",  0, 0, "Proccesor", x86_proc_desc );
             ADDFIELD("cpu.name",           0, 0, "Proccesor Name", x86_proc_name );
             ADDFIELD("cpu.desc",           0, 0, "Proccesor Description", x86_proc_desc );
-            ADDFIELD("cpu.physical_count", 0, 1, "Count", x86_proc_count_str );
-            ADDFIELD("cpu.core_count",     0, 1, "Cores", x86_proc_cores_str );
-            ADDFIELD("cpu.count",          0, 1, "Threads", x86_proc_threads_str );
+            ADDFIELDV("cpu.physical_count", 0, "Count", FIELD_INT64, x86_proc_count_value );
+            ADDFIELDV("cpu.core_count",     0, "Cores", FIELD_INT64, x86_proc_cores_value );
+            ADDFIELDV("cpu.count",          0, "Threads", FIELD_INT64, x86_proc_threads_value );
         }
         return s->fields;
     }
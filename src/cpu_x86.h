@@ -22,6 +22,7 @@
 #define _X86CPU_H_
 
 #include "fields.h"
+#include "cpu_table.h"
 
 #include "x86_data.h"
 const char *x86_flag_list(void);
@@ -33,18 +34,24 @@ void x86_proc_free(x86_proc *);
 
 const char *x86_proc_name(x86_proc *);
 const char *x86_proc_desc(x86_proc *);
+const char *x86_proc_flag_list(x86_proc *); /* x86_flag_list() with any unknown flags seen, owned by the x86_proc */
 int x86_proc_has_flag(x86_proc *, const char *flag); /* returns core count with flag */
+int x86_proc_flag_id(x86_proc *, const char *flag); /* x86_flag_id, or a dynamic id for unknown flags, -1 if not seen */
+int x86_proc_has_feature(x86_proc *, int id); /* returns core count with flag id */
+int x86_proc_thread_has_feature(x86_proc *, int thread, int id);
 int x86_proc_count(x86_proc *);
 int x86_proc_cores(x86_proc *);
 int x86_proc_threads(x86_proc *);
 
 int x86_proc_thread_from_id(x86_proc *, int id); /* -1 if not found */
 int x86_proc_thread_id(x86_proc *, int thread);
+const char *x86_proc_thread_model_name(x86_proc *, int thread);
 
 int x86_proc_thread_khz_min(x86_proc *, int thread);
 int x86_proc_thread_khz_max(x86_proc *, int thread);
 int x86_proc_thread_khz_cur(x86_proc *, int thread);
 
+cpu_table *x86_proc_table(x86_proc *); /* one row per thread, owned by the x86_proc */
 rpiz_fields *x86_proc_fields(x86_proc *);
 
 #endif
@@ -0,0 +1,77 @@
+/*
+ * rpiz - https://github.com/bp0/rpiz
+ * Copyright (C) 2017  Burt P. <pburt0@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "cpuinfo_ctx.h"
+
+struct cpuinfo_ctx {
+    util_env *env;
+    cpu_state *cpu;
+    board_state *board;
+};
+
+static __thread cpuinfo_ctx *cur_ctx = NULL;
+
+static void ctx_switch(cpuinfo_ctx *s) {
+    cur_ctx = s;
+    util_env_use(s ? s->env : NULL);
+    cpu_state_use(s ? s->cpu : NULL);
+    board_state_use(s ? s->board : NULL);
+}
+
+cpuinfo_ctx *cpuinfo_ctx_new(const char *root) {
+    cpuinfo_ctx *prev, *s = malloc(sizeof(cpuinfo_ctx));
+    if (s) {
+        memset(s, 0, sizeof(*s));
+        s->env = util_env_new();
+        s->cpu = cpu_state_new();
+        s->board = board_state_new();
+        if (!s->env || !s->cpu || !s->board) {
+            cpuinfo_ctx_free(s);
+            return NULL;
+        }
+        prev = cpuinfo_ctx_use(s);
+        util_set_root(root);
+        cpu_init();
+        cpuinfo_ctx_use(prev);
+    }
+    return s;
+}
+
+void cpuinfo_ctx_free(cpuinfo_ctx *s) {
+    cpuinfo_ctx *prev;
+    if (s) {
+        /* the cpu and board parts are freed inside the context, they
+         * may still read through its env */
+        prev = cpuinfo_ctx_use(s);
+        if (s->cpu) cpu_state_free(s->cpu);
+        if (s->board) board_state_free(s->board);
+        cpuinfo_ctx_use(prev == s ? NULL : prev);
+        util_env_free(s->env);
+        free(s);
+    }
+}
+
+cpuinfo_ctx *cpuinfo_ctx_use(cpuinfo_ctx *s) {
+    cpuinfo_ctx *prev = cur_ctx;
+    ctx_switch(s);
+    return prev;
+}
@@ -0,0 +1,40 @@
+/*
+ * rpiz - https://github.com/bp0/rpiz
+ * Copyright (C) 2017  Burt P. <pburt0@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+#ifndef _CPUINFO_CTX_H_
+#define _CPUINFO_CTX_H_
+
+#include "util.h"
+#include "cpu.h"
+#include "board.h"
+
+/* A detection context: its own sysroot, probe session, cpu and board
+ * state. While a context is in use on a thread, every cpu_*, board_*
+ * and util call on that thread works inside it, so several contexts
+ * (one per captured host, say) can be detected at once on different
+ * threads. */
+typedef struct cpuinfo_ctx cpuinfo_ctx;
+
+cpuinfo_ctx *cpuinfo_ctx_new(const char *root); /* NULL root for "/", nothing is read yet */
+void cpuinfo_ctx_free(cpuinfo_ctx *);
+/* for this thread, NULL for the default context, returns the previous */
+cpuinfo_ctx *cpuinfo_ctx_use(cpuinfo_ctx *);
+
+#endif
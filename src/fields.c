@@ -23,17 +23,129 @@
 #include <string.h>
 #include "fields.h"
 
+typedef struct fields_index fields_index;
+
 struct rpiz_fields {
     int live;
     int own_value;
     char *tag;
+    unsigned int hash; /* of tag */
     char *name;
     char *value;
     void *data;
     rpiz_fields_get_func get_func;
+    /* a typed field keeps its value in val, formatted into text only
+     * when fields_get() asks for it */
+    rpiz_fields_value_func value_func;
+    rpiz_value val;
+    int have_val;
+    char text[FIELDS_TEXT_SIZE];
     rpiz_fields *next;
+    fields_index *index; /* on an item used to look up by tag, covers it and those after */
+};
+
+/* open addressing over the tags, first item wins for a repeated tag;
+ * tail is the last item indexed, anything linked after it is taken in
+ * before the next lookup, so items appended through another item of
+ * the list are still found */
+struct fields_index {
+    int count;
+    int size; /* a power of two */
+    rpiz_fields **slot;
+    rpiz_fields *tail;
 };
 
+static unsigned int fields_hash(const char *tag) {
+    unsigned int h = 2166136261u;
+    while (*tag) {
+        h ^= (unsigned char)*tag++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/* the slot for tag, empty if not indexed */
+static int index_lookup(fields_index *ix, const char *tag, unsigned int hash) {
+    unsigned int mask = ix->size - 1, i = hash & mask;
+    while (ix->slot[i]) {
+        if (ix->slot[i]->hash == hash && strcmp(ix->slot[i]->tag, tag) == 0)
+            break;
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+static int index_grow(fields_index *ix) {
+    rpiz_fields **old = ix->slot;
+    int i, old_size = ix->size;
+    ix->size = old_size ? old_size * 2 : 64;
+    ix->slot = calloc(ix->size, sizeof(rpiz_fields *));
+    if (!ix->slot) {
+        ix->slot = old;
+        ix->size = old_size;
+        return 0;
+    }
+    for (i = 0; i < old_size; i++)
+        if (old[i])
+            ix->slot[index_lookup(ix, old[i]->tag, old[i]->hash)] = old[i];
+    free(old);
+    return 1;
+}
+
+static void index_add(fields_index *ix, rpiz_fields *f) {
+    int i;
+    if ((ix->count + 1) * 2 > ix->size)
+        if (!index_grow(ix))
+            return;
+    i = index_lookup(ix, f->tag, f->hash);
+    if (!ix->slot[i]) {
+        ix->slot[i] = f;
+        ix->count++;
+    }
+}
+
+/* s's index, made on first use and brought up to the end of the list */
+static fields_index *fields_index_of(rpiz_fields *s) {
+    fields_index *ix = s->index;
+    if (!ix) {
+        ix = malloc(sizeof(fields_index));
+        if (!ix)
+            return NULL;
+        memset(ix, 0, sizeof(*ix));
+        if (!index_grow(ix)) {
+            free(ix);
+            return NULL;
+        }
+        ix->tail = s;
+        if (s->tag)
+            index_add(ix, s);
+        s->index = ix;
+    }
+    while (ix->tail->next) {
+        ix->tail = ix->tail->next;
+        if (ix->tail->tag)
+            index_add(ix, ix->tail);
+    }
+    return ix;
+}
+
+/* the first item from s on with tag, NULL if none */
+static rpiz_fields *fields_find(rpiz_fields *s, const char *tag) {
+    fields_index *ix;
+    unsigned int hash;
+    if (!s || !tag)
+        return NULL;
+    hash = fields_hash(tag);
+    ix = fields_index_of(s);
+    if (ix)
+        return ix->slot[index_lookup(ix, tag, hash)];
+    /* no memory for the index */
+    for (; s; s = s->next)
+        if (s->tag && s->hash == hash && strcmp(s->tag, tag) == 0)
+            return s;
+    return NULL;
+}
+
 rpiz_fields *fields_new() {
     rpiz_fields *s = malloc(sizeof(rpiz_fields));
     if (s) {
@@ -43,14 +155,18 @@ rpiz_fields *fields_new() {
 }
 
 void fields_free(rpiz_fields *s) {
-    if (s) {
-        if (s->next != NULL)
-            fields_free(s->next);
+    rpiz_fields *next;
+    while (s) {
+        next = s->next;
         free(s->tag);
         free(s->name);
         if (s->own_value)
             free(s->value);
+        if (s->index)
+            free(s->index->slot);
+        free(s->index);
         free(s);
+        s = next;
     }
 }
 
@@ -71,11 +187,18 @@ rpiz_fields *fields_copy(rpiz_fields *src, rpiz_fields *append_src) {
         cpd->own_value = src->own_value;
         cpd->live = src->live;
         cpd->get_func = src->get_func;
+        cpd->value_func = src->value_func;
+        cpd->val = src->val;
+        cpd->have_val = src->have_val;
+        memcpy(cpd->text, src->text, sizeof(cpd->text));
         cpd->data = src->data;
         cpd->tag = strdup(src->tag);
+        cpd->hash = src->hash;
         cpd->name = strdup(src->name);
         if (cpd->own_value)
-            cpd->value = strdup(src->value);
+            cpd->value = src->value ? strdup(src->value) : NULL;
+        else if (src->value == src->text)
+            cpd->value = cpd->text;
         else
             cpd->value = src->value;
 
@@ -128,77 +251,108 @@ static void fields_update(rpiz_fields *s, int live_update, int own_value, char *
             free(s->name);
             s->name = strdup(name);
         }
+        if (s->value && s->own_value && s->value != data)
+            free(s->value);
+        s->value = NULL;
+        s->value_func = NULL;
+        s->have_val = 0;
         s->live = live_update;
         s->own_value = own_value;
         s->get_func = get_func;
         s->data = data;
-        if (s->get_func != NULL)
-            fields_get(s, NULL, NULL, NULL);
-        else
+        /* with a get_func, the value is made by the first fields_get() */
+        if (s->get_func == NULL)
             s->value = (char*)data;
     }
 }
 
 
-/* returns NULL or new item */
-rpiz_fields *fields_update_bytag(rpiz_fields *s, char *tag, int live_update, int own_value, char *name, rpiz_fields_get_func get_func, void *data) {
-    int m = 0;
-    rpiz_fields *nf = NULL;
-    if (tag == NULL) return NULL;
+/* the item for tag, linked in at the end if new; *is_new set if it was */
+static rpiz_fields *fields_item(rpiz_fields *s, char *tag, int *is_new) {
+    fields_index *ix;
+    rpiz_fields *nf;
+    *is_new = 0;
     if (s) {
-        if (tag && s->tag)
-            m = !!(strcmp(tag, s->tag) == 0);
-        if (m) {
-            /* update existing */
-            fields_update(s, live_update, own_value, name, get_func, data);
-            return NULL;
+        nf = fields_find(s, tag);
+        if (nf)
+            return nf;
+    }
+    nf = fields_new();
+    if (nf) {
+        *is_new = 1;
+        nf->tag = strdup(tag);
+        nf->hash = fields_hash(tag);
+        if (!s)
+            return nf;
+        /* after the last item, which the index already knows */
+        ix = s->index;
+        if (ix) {
+            ix->tail->next = nf;
+            ix->tail = nf;
+            index_add(ix, nf);
         } else {
-            nf = fields_update_bytag(s->next, tag, live_update, own_value, name, get_func, data);
-            if (nf) s->next = nf;
-            else return NULL;
-        }
-    } else {
-        /* new */
-        s = fields_new();
-        if (s) {
-            s->tag = strdup(tag);
-            fields_update(s, live_update, own_value, name, get_func, data);
-            return s;
+            while (s->next)
+                s = s->next;
+            s->next = nf;
         }
     }
-    return NULL;
+    return nf;
 }
 
-int fields_islive(rpiz_fields *s, char *tag) {
-    int m = 0;
-    if (s) {
-        if (tag && s->tag)
-            m = !!(strcmp(tag, s->tag) == 0);
-        if (m)
-            return s->live;
-        if (s->next)
-            return fields_islive(s->next, tag);
+/* returns NULL or new item */
+rpiz_fields *fields_update_bytag(rpiz_fields *s, char *tag, int live_update, int own_value, char *name, rpiz_fields_get_func get_func, void *data) {
+    rpiz_fields *nf;
+    int is_new;
+    if (tag == NULL) return NULL;
+    nf = fields_item(s, tag, &is_new);
+    if (nf)
+        fields_update(nf, live_update, own_value, name, get_func, data);
+    return (nf && !s) ? nf : NULL;
+}
+
+rpiz_fields *fields_update_value_bytag(rpiz_fields *s, char *tag, int live_update, char *name, rpiz_value_type type, rpiz_fields_value_func value_func, void *data) {
+    rpiz_fields *nf;
+    int is_new;
+    if (tag == NULL) return NULL;
+    nf = fields_item(s, tag, &is_new);
+    if (nf) {
+        fields_update(nf, live_update, 0, name, NULL, data);
+        nf->value = NULL;
+        nf->value_func = value_func;
+        nf->val.type = type;
     }
+    return (nf && !s) ? nf : NULL;
+}
+
+int fields_islive(rpiz_fields *s, char *tag) {
+    s = fields_find(s, tag);
+    if (s)
+        return s->live;
     return 0;
 }
 
+/* a live value is read on every use, others the first time */
+static int fields_read_value(rpiz_fields *s) {
+    if (s->live || !s->have_val)
+        s->have_val = s->value_func(s->data, &s->val);
+    return s->have_val;
+}
+
 int fields_get(rpiz_fields *s, char **tag, char **name, char **value) {
     char *tmp;
     if (s) {
         if (tag) *tag = s->tag;
         if (name) *name = s->name;
-        if (s->get_func) {
+        if (s->value_func) {
+            s->value = NULL;
+            if (fields_read_value(s) && value_format(&s->val, s->text, sizeof(s->text)) >= 0)
+                s->value = s->text;
+        } else if (s->get_func) {
             tmp = s->get_func(s->data);
             if (s->value && s->own_value)
                 free(s->value);
-            if (tmp) {
-                if (s->own_value)
-                    s->value = tmp;
-                else {
-                    s->value = strdup(tmp);
-                }
-            } else
-                s->value = NULL;
+            /* without own_value the text stays the get_func's */
+            s->value = tmp;
         }
         if (value) *value = s->value;
         return 1;
@@ -206,19 +360,109 @@ int fields_get(rpiz_fields *s, char **tag, char **name, char **value) {
     return 0;
 }
 
-int fields_get_bytag(rpiz_fields *s, char *tag, char **name, char **value) {
-    int m = 0;
+int fields_value(rpiz_fields *s, rpiz_value *value) {
+    if (s && s->value_func && fields_read_value(s)) {
+        if (value) *value = s->val;
+        return 1;
+    }
+    return 0;
+}
+
+int fields_format(rpiz_fields *s, char *buff, int size) {
+    char *value = NULL;
+    if (!s || !buff || size < 1)
+        return -1;
+    if (s->value_func) {
+        /* live or not, the value held since the last refresh */
+        if (!s->have_val)
+            s->have_val = s->value_func(s->data, &s->val);
+        if (!s->have_val)
+            return -1;
+        return value_format(&s->val, buff, size);
+    }
+    fields_get(s, NULL, NULL, &value);
+    if (!value)
+        return -1;
+    return snprintf(buff, size, "%s", value);
+}
+
+void fields_refresh(rpiz_fields *s) {
+    for (; s; s = s->next)
+        if (s->value_func && s->live)
+            s->have_val = s->value_func(s->data, &s->val);
+}
+
+int fields_info(rpiz_fields *s, char **tag, char **name, int *live) {
     if (s) {
-        if (tag && s->tag)
-            m = !!(strcmp(tag, s->tag) == 0);
-        if (m)
-            return fields_get(s, NULL, name, value);
-        if (s->next)
-            return fields_get_bytag(s->next, tag, name, value);
+        if (tag) *tag = s->tag;
+        if (name) *name = s->name;
+        if (live) *live = s->live;
+        return (s->value_func) ? 1 : 0;
     }
+    return -1;
+}
+
+int fields_sample(rpiz_fields *s, rpiz_value *value, char *buff, int size) {
+    rpiz_value v;
+    char *tmp;
+    int len = -1;
+    if (!s || !buff || size < 1)
+        return -1;
+    if (s->value_func) {
+        v.type = s->val.type;
+        if (s->value_func(s->data, &v)) {
+            if (value) *value = v;
+            len = value_format(&v, buff, size);
+        }
+    } else if (s->get_func) {
+        tmp = s->get_func(s->data);
+        if (tmp)
+            len = snprintf(buff, size, "%s", tmp);
+        if (s->own_value)
+            free(tmp);
+    } else if (s->value)
+        len = snprintf(buff, size, "%s", s->value);
+    return len;
+}
+
+int value_format(const rpiz_value *v, char *buff, int size) {
+    if (!v || !buff || size < 1)
+        return -1;
+    switch (v->type) {
+        case FIELD_INT64:
+            return snprintf(buff, size, "%lld", v->i);
+        case FIELD_DOUBLE:
+            return snprintf(buff, size, "%0.2f", v->d);
+        case FIELD_KHZ:
+            return snprintf(buff, size, "%0.2f MHz", v->i / 1000.0);
+        case FIELD_CELSIUS:
+            return snprintf(buff, size, "%0.2f'C", v->d);
+        case FIELD_KB:
+            return snprintf(buff, size, "%lld kB", v->i);
+        case FIELD_BITMASK:
+            return snprintf(buff, size, "0x%llx", v->mask);
+    }
+    return -1;
+}
+
+int fields_get_bytag(rpiz_fields *s, char *tag, char **name, char **value) {
+    s = fields_find(s, tag);
+    if (s)
+        return fields_get(s, NULL, name, value);
     return 0;
 }
 
+int fields_value_bytag(rpiz_fields *s, char *tag, rpiz_value *value) {
+    return fields_value(fields_find(s, tag), value);
+}
+
+int fields_format_bytag(rpiz_fields *s, char *tag, char *buff, int size) {
+    s = fields_find(s, tag);
+    if (s)
+        return fields_format(s, buff, size);
+    return -1;
+}
+
 void fields_dump(rpiz_fields *s) {
     char *t, *n, *v;
     rpiz_fields *f = s;
@@ -25,6 +25,34 @@ typedef struct rpiz_fields rpiz_fields;
 
 typedef char* (*rpiz_fields_get_func)(void *data);
 
+/* Typed values are kept in the field and only made text when asked,
+ * fields_get() formats into the field's own buffer, fields_format()
+ * into the caller's. A live value is read again by fields_get() and
+ * fields_value(); fields_format() shows what fields_refresh() last read. */
+typedef enum {
+    FIELD_INT64,   /* i */
+    FIELD_DOUBLE,  /* d */
+    FIELD_KHZ,     /* i, shown in MHz */
+    FIELD_CELSIUS, /* d */
+    FIELD_KB,      /* i, in kB */
+    FIELD_BITMASK, /* mask, in hex */
+} rpiz_value_type;
+
+typedef struct {
+    rpiz_value_type type;
+    union {
+        long long i;
+        double d;
+        unsigned long long mask;
+    };
+} rpiz_value;
+
+/* sets the member for value->type, returns 0 if there is no value */
+typedef int (*rpiz_fields_value_func)(void *data, rpiz_value *value);
+
+#define FIELDS_TEXT_SIZE 32 /* enough for any formatted value */
+int value_format(const rpiz_value *, char *buff, int size); /* as snprintf(), -1 if nothing */
+
 rpiz_fields *fields_new(void);
 rpiz_fields *fields_copy(rpiz_fields *src, rpiz_fields *append_src);
 rpiz_fields *fields_next(rpiz_fields *);
@@ -33,9 +61,23 @@ int fields_tag_has_prefix(rpiz_fields *, const char *prefix);
 rpiz_fields *fields_next_with_tag_prefix(rpiz_fields *, const char *prefix);
 
 rpiz_fields *fields_update_bytag(rpiz_fields *, char *tag, int live_update, int own_value, char *name, rpiz_fields_get_func get_func, void *data);
+rpiz_fields *fields_update_value_bytag(rpiz_fields *, char *tag, int live_update, char *name, rpiz_value_type type, rpiz_fields_value_func value_func, void *data);
 int fields_islive(rpiz_fields *, char *tag);
 int fields_get(rpiz_fields *, char **tag, char **name, char **value);
 int fields_get_bytag(rpiz_fields *, char *tag, char **name, char **value);
+int fields_value(rpiz_fields *, rpiz_value *); /* 0 if not a typed field or no value */
+int fields_value_bytag(rpiz_fields *, char *tag, rpiz_value *);
+int fields_format(rpiz_fields *, char *buff, int size); /* any field, as snprintf(), -1 if no value */
+int fields_format_bytag(rpiz_fields *, char *tag, char *buff, int size);
+/* reads every live typed value again, allocating nothing */
+void fields_refresh(rpiz_fields *);
+/* tag, name and live_update without reading anything; 1 for a typed
+ * field, 0 for text, -1 for none */
+int fields_info(rpiz_fields *, char **tag, char **name, int *live);
+/* Reads the field again into the caller's value (typed fields only) and
+ * buff, as snprintf(), -1 if no value. The field itself is left as it
+ * was, so this can run on a thread other than the field's readers. */
+int fields_sample(rpiz_fields *, rpiz_value *value, char *buff, int size);
 void fields_free(rpiz_fields *);
 
 void fields_dump(rpiz_fields *);
@@ -0,0 +1,350 @@
+/*
+ * rpiz - https://github.com/bp0/rpiz
+ * Copyright (C) 2017  Burt P. <pburt0@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include "util.h"
+#include "fields_live.h"
+
+enum {
+    SLOT_NONE,
+    SLOT_TEXT,
+    SLOT_TYPED,
+};
+
+/* A slot is copied a word at a time with atomics, while a tick may be
+ * writing it; a torn copy is caught by the sequence count and redone. */
+typedef unsigned long long live_word;
+
+typedef struct {
+    rpiz_value val;
+    live_word state; /* a word, so a slot is whole words */
+    char text[FIELDS_LIVE_TEXT_SIZE];
+} live_slot;
+
+#define SLOT_WORDS (sizeof(live_slot) / sizeof(live_word))
+typedef char slot_is_words[(sizeof(live_slot) % sizeof(live_word)) ? -1 : 1];
+
+typedef struct {
+    unsigned long seq; /* odd while a tick writes this buffer */
+    long long gen, t_ns;
+    live_slot *slots;
+} live_buf;
+
+struct fields_live {
+    int count;
+    rpiz_fields **fields;
+    char **tags, **names; /* the fields' own */
+    int *typed;
+
+    live_slot scratch; /* the tick's */
+    live_buf buf[2];
+    int published; /* the buffer readers copy */
+    long long ticks, retries;
+
+    util_env *env; /* of the thread that started it */
+    pthread_t thread;
+    int running, stop;
+    int interval_ms;
+};
+
+struct fields_snap {
+    fields_live *live;
+    int count;
+    long long gen, t_ns;
+    live_slot *slots;
+};
+
+#define LOAD(v) __atomic_load_n(&(v), __ATOMIC_ACQUIRE)
+#define STORE(v, x) __atomic_store_n(&(v), (x), __ATOMIC_RELEASE)
+#define LOAD_RELAXED(v) __atomic_load_n(&(v), __ATOMIC_RELAXED)
+#define STORE_RELAXED(v, x) __atomic_store_n(&(v), (x), __ATOMIC_RELAXED)
+#define ADD_RELAXED(v, x) __atomic_fetch_add(&(v), (x), __ATOMIC_RELAXED)
+
+static long long time_ns(void) {
+    struct timespec tv;
+    clock_gettime(CLOCK_MONOTONIC, &tv);
+    return (long long)tv.tv_sec*1000000000LL + tv.tv_nsec;
+}
+
+static void slot_store(live_slot *dst, const live_slot *src) {
+    live_word *d = (live_word *)dst;
+    const live_word *w = (const live_word *)src;
+    unsigned int i;
+    for (i = 0; i < SLOT_WORDS; i++)
+        STORE_RELAXED(d[i], w[i]);
+}
+
+static void slot_load(live_slot *dst, live_slot *src) {
+    live_word *d = (live_word *)dst;
+    live_word *w = (live_word *)src;
+    unsigned int i;
+    for (i = 0; i < SLOT_WORDS; i++)
+        d[i] = LOAD_RELAXED(w[i]);
+}
+
+fields_live *fields_live_new(void) {
+    fields_live *s = malloc( sizeof(fields_live) );
+    if (s)
+        memset(s, 0, sizeof(*s));
+    return s;
+}
+
+void fields_live_free(fields_live *s) {
+    if (s) {
+        fields_live_stop(s);
+        free(s->fields);
+        free(s->tags);
+        free(s->names);
+        free(s->typed);
+        free(s->buf[0].slots);
+        free(s->buf[1].slots);
+        free(s);
+    }
+}
+
+static int grow(fields_live *s, int count) {
+    void *p;
+    int b;
+#define GROW(ptr, type) \
+    p = realloc(ptr, sizeof(type) * count); \
+    if (!p) return 0; \
+    ptr = p;
+    GROW(s->fields, rpiz_fields *)
+    GROW(s->tags, char *)
+    GROW(s->names, char *)
+    GROW(s->typed, int)
+    for (b = 0; b < 2; b++) {
+        GROW(s->buf[b].slots, live_slot)
+        memset(&s->buf[b].slots[s->count], 0, sizeof(live_slot) * (count - s->count));
+    }
+#undef GROW
+    return 1;
+}
+
+int fields_live_add(fields_live *s, rpiz_fields *f) {
+    int live, n = 0;
+    if (!s || s->running || LOAD_RELAXED(s->ticks))
+        return 0;
+    for (; f; f = fields_next(f)) {
+        if (fields_info(f, NULL, NULL, &live) < 0 || !live)
+            continue;
+        if (!grow(s, s->count + 1))
+            break;
+        s->fields[s->count] = f;
+        s->typed[s->count] = fields_info(f, &s->tags[s->count], &s->names[s->count], NULL);
+        s->count++;
+        n++;
+    }
+    return n;
+}
+
+int fields_live_count(fields_live *s) {
+    if (s)
+        return s->count;
+    return 0;
+}
+
+/* the only writer of published, seq and the buffers */
+int fields_live_tick(fields_live *s) {
+    live_slot *sl;
+    live_buf *b;
+    unsigned long seq;
+    int i, n = 0;
+
+    if (!s) return 0;
+    sl = &s->scratch;
+    b = &s->buf[!LOAD_RELAXED(s->published)];
+    seq = LOAD_RELAXED(b->seq);
+    STORE_RELAXED(b->seq, seq + 1);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    for (i = 0; i < s->count; i++) {
+        memset(sl, 0, sizeof(*sl));
+        if (fields_sample(s->fields[i], &sl->val, sl->text, sizeof(sl->text)) >= 0) {
+            sl->state = s->typed[i] ? SLOT_TYPED : SLOT_TEXT;
+            n++;
+        }
+        slot_store(&b->slots[i], sl);
+    }
+    STORE_RELAXED(b->gen, LOAD_RELAXED(s->ticks) + 1);
+    STORE_RELAXED(b->t_ns, time_ns());
+    STORE(b->seq, seq + 2);
+    STORE(s->published, (int)(b - s->buf));
+    ADD_RELAXED(s->ticks, 1);
+    return n;
+}
+
+static void *live_main(void *data) {
+    fields_live *s = data;
+    struct timespec next;
+    long long period = s->interval_ms * 1000000LL;
+
+    util_env_use(s->env);
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (!LOAD(s->stop)) {
+        fields_live_tick(s);
+        /* absolute deadlines, as freq_sampler */
+        next.tv_sec += period / 1000000000LL;
+        next.tv_nsec += period % 1000000000LL;
+        while (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR);
+    }
+    return NULL;
+}
+
+int fields_live_start(fields_live *s, int interval_ms) {
+    if (!s || s->running || interval_ms <= 0)
+        return 0;
+    s->interval_ms = interval_ms;
+    s->env = util_env_current();
+    STORE(s->stop, 0);
+    if (pthread_create(&s->thread, NULL, live_main, s) != 0)
+        return 0;
+    s->running = 1;
+    return 1;
+}
+
+void fields_live_stop(fields_live *s) {
+    if (s && s->running) {
+        STORE(s->stop, 1);
+        pthread_join(s->thread, NULL);
+        s->running = 0;
+    }
+}
+
+long long fields_live_ticks(fields_live *s) {
+    if (s)
+        return LOAD_RELAXED(s->ticks);
+    return 0;
+}
+
+long long fields_live_retries(fields_live *s) {
+    if (s)
+        return LOAD_RELAXED(s->retries);
+    return 0;
+}
+
+fields_snap *fields_snap_new(fields_live *l) {
+    fields_snap *s;
+    if (!l) return NULL;
+    s = malloc( sizeof(fields_snap) );
+    if (!s) return NULL;
+    memset(s, 0, sizeof(*s));
+    s->live = l;
+    s->count = l->count;
+    s->slots = malloc(sizeof(live_slot) * (s->count + 1));
+    if (!s->slots) {
+        free(s);
+        return NULL;
+    }
+    memset(s->slots, 0, sizeof(live_slot) * (s->count + 1));
+    return s;
+}
+
+void fields_snap_free(fields_snap *s) {
+    if (s) {
+        free(s->slots);
+        free(s);
+    }
+}
+
+long long fields_live_snapshot(fields_live *s, fields_snap *snap) {
+    live_buf *b;
+    unsigned long seq;
+    int i;
+
+    if (!s || !snap || snap->live != s)
+        return 0;
+    for (;;) {
+        b = &s->buf[LOAD(s->published)];
+        seq = LOAD(b->seq);
+        if (!(seq & 1)) {
+            for (i = 0; i < snap->count; i++)
+                slot_load(&snap->slots[i], &b->slots[i]);
+            snap->gen = LOAD_RELAXED(b->gen);
+            snap->t_ns = LOAD_RELAXED(b->t_ns);
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (LOAD_RELAXED(b->seq) == seq)
+                return snap->gen;
+        }
+        /* two ticks went by while copying, only if this reader was that slow */
+        ADD_RELAXED(s->retries, 1);
+    }
+}
+
+int fields_snap_count(fields_snap *s) {
+    if (s)
+        return s->count;
+    return 0;
+}
+
+long long fields_snap_gen(fields_snap *s) {
+    if (s)
+        return s->gen;
+    return 0;
+}
+
+long long fields_snap_time_ns(fields_snap *s) {
+    if (s)
+        return s->t_ns;
+    return 0;
+}
+
+int fields_snap_find(fields_snap *s, const char *tag) {
+    int i;
+    if (s && tag)
+        for (i = 0; i < s->count; i++)
+            if (strcmp(s->live->tags[i], tag) == 0)
+                return i;
+    return -1;
+}
+
+const char *fields_snap_tag(fields_snap *s, int i) {
+    if (s && i >= 0 && i < s->count)
+        return s->live->tags[i];
+    return NULL;
+}
+
+const char *fields_snap_name(fields_snap *s, int i) {
+    if (s && i >= 0 && i < s->count)
+        return s->live->names[i];
+    return NULL;
+}
+
+const char *fields_snap_text(fields_snap *s, int i) {
+    if (s && i >= 0 && i < s->count && s->slots[i].state != SLOT_NONE)
+        return s->slots[i].text;
+    return NULL;
+}
+
+int fields_snap_value(fields_snap *s, int i, rpiz_value *value) {
+    if (s && i >= 0 && i < s->count && s->slots[i].state == SLOT_TYPED) {
+        if (value) *value = s->slots[i].val;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,71 @@
+/*
+ * rpiz - https://github.com/bp0/rpiz
+ * Copyright (C) 2017  Burt P. <pburt0@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+#ifndef _FIELDS_LIVE_H_
+#define _FIELDS_LIVE_H_
+
+#include "fields.h"
+
+/* Refreshes the live fields of one or more lists on a background
+ * thread and publishes them as snapshots. Each tick samples every
+ * field into the buffer readers are not using and then publishes it,
+ * two buffers each behind a sequence count, so any number of readers
+ * copy a consistent snapshot without locks, syscalls or allocation.
+ * While it runs, read those live fields through snapshots rather than
+ * fields_get(), which would sample them again on the reader's thread. */
+typedef struct fields_live fields_live;
+typedef struct fields_snap fields_snap;
+
+#define FIELDS_LIVE_TEXT_SIZE 64 /* longer text is cut */
+
+fields_live *fields_live_new(void);
+void fields_live_free(fields_live *); /* stops the thread */
+
+/* takes the live fields of a list, which must outlive the engine;
+ * only before the first tick, returns how many were added */
+int fields_live_add(fields_live *, rpiz_fields *);
+int fields_live_count(fields_live *);
+
+int fields_live_tick(fields_live *); /* one refresh of every field, one thread at a time */
+
+/* tick on a background thread every interval_ms, the first at once */
+int fields_live_start(fields_live *, int interval_ms);
+void fields_live_stop(fields_live *);
+
+long long fields_live_ticks(fields_live *);
+long long fields_live_retries(fields_live *); /* snapshot copies a tick overlapped */
+
+/* A snapshot belongs to the reader, made once for an engine and filled
+ * again by each fields_live_snapshot(), which returns its generation,
+ * 0 before the first tick. */
+fields_snap *fields_snap_new(fields_live *);
+void fields_snap_free(fields_snap *);
+long long fields_live_snapshot(fields_live *, fields_snap *);
+
+int fields_snap_count(fields_snap *);
+long long fields_snap_gen(fields_snap *);
+long long fields_snap_time_ns(fields_snap *); /* CLOCK_MONOTONIC of the tick */
+int fields_snap_find(fields_snap *, const char *tag); /* index or -1 */
+const char *fields_snap_tag(fields_snap *, int i);
+const char *fields_snap_name(fields_snap *, int i);
+const char *fields_snap_text(fields_snap *, int i); /* NULL if no value */
+int fields_snap_value(fields_snap *, int i, rpiz_value *); /* 0 if not typed or no value */
+
+#endif
@@ -21,6 +21,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <pthread.h>
 #include <ctype.h>
 #include "riscv_data.h"
 
@@ -34,42 +35,36 @@
 static struct {
     char *name, *meaning;
 } tab_ext_meaning[] = {
-    { "RV32",  N_("RISC-V 32-bit") },
-    { "RV64",  N_("RISC-V 64-bit") },
-    { "RV128", N_("RISC-V 128-bit") },
-    { "E",     N_("Base embedded integer instructions (15 registers)") },
-    { "I",     N_("Base integer instructions (31 registers)") },
-    { "M",     N_("Hardware integer multiply and divide") },
-    { "A",     N_("Atomic memory operations") },
-    { "C",     N_("Compressed 16-bit instructions") },
-    { "F",     N_("Floating-point instructions, single-precision") },
-    { "D",     N_("Floating-point instructions, double-precision") },
-    { "Q",     N_("Floating-point instructions, quad-precision") },
-    { "B",     N_("Bit manipulation instructions") },
-    { "V",     N_("Vector operations") },
-    { "T",     N_("Transactional memory") },
-    { "P",     N_("Packed SIMD instructions") },
-    { "L",     N_("Decimal floating-point instructions") },
-    { "J",     N_("Dynamically translated languages") },
-    { "N",     N_("User-level interrupts") },
+#define RISCV_EXT_ENTRY(id, name, meaning) { name, meaning },
+    RISCV_EXT_TABLE(RISCV_EXT_ENTRY)
     { NULL, NULL }
 };
 
 static char all_extensions[1024] = "";
 
 #define APPEND_EXT(f) strcat(all_extensions, f); strcat(all_extensions, " ");
-const char *riscv_ext_list() {
-    int i = 0, built = 0;
-    built = strlen(all_extensions);
-    if (!built) {
-        while(tab_ext_meaning[i].name != NULL) {
-            APPEND_EXT(tab_ext_meaning[i].name);
-            i++;
-        }
+static pthread_once_t all_extensions_once = PTHREAD_ONCE_INIT;
+
+static void build_all_extensions(void) {
+    int i = 0;
+    while(tab_ext_meaning[i].name != NULL) {
+        APPEND_EXT(tab_ext_meaning[i].name);
+        i++;
     }
+}
+
+/* built once, never changed after */
+const char *riscv_ext_list() {
+    pthread_once(&all_extensions_once, build_all_extensions);
     return all_extensions;
 }
 
+const char *riscv_ext_name(int id) {
+    if (id >= 0 && id < RISCV_EXT_N_KNOWN)
+        return tab_ext_meaning[id].name;
+    return NULL;
+}
+
 const char *riscv_ext_meaning(const char *ext) {
     int i = 0, l = 0;
     char *c = NULL;
@@ -21,6 +21,14 @@
 #ifndef _RISCVDATA_H_
 #define _RISCVDATA_H_
 
+#include "riscv_exts.h"
+
+#define RISCV_EXT_ENUM(id, name, meaning) RISCV_EXT_##id,
+typedef enum {
+    RISCV_EXT_TABLE(RISCV_EXT_ENUM)
+    RISCV_EXT_N_KNOWN
+} riscv_ext_id;
+
 /* convert RISC-V ISA string to flags list */
 char *riscv_isa_to_flags(const char *isa);
 
@@ -30,4 +38,7 @@ const char *riscv_ext_list(void);
 /* get meaning of flag */
 const char *riscv_ext_meaning(const char *ext);
 
+/* name of a known riscv_ext_id */
+const char *riscv_ext_name(int id);
+
 #endif
@@ -0,0 +1,46 @@
+/*
+ * rpiz - https://github.com/bp0/rpiz
+ * Copyright (C) 2017  Burt P. <pburt0@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+#ifndef _RISCVEXTS_H_
+#define _RISCVEXTS_H_
+
+/* extensions known to riscv_data.c; the order defines the riscv_ext_id values
+ * X(id, name, meaning) */
+#define RISCV_EXT_TABLE(X) \
+    X(RV32,  "RV32",  N_("RISC-V 32-bit")) \
+    X(RV64,  "RV64",  N_("RISC-V 64-bit")) \
+    X(RV128, "RV128", N_("RISC-V 128-bit")) \
+    X(E,     "E",     N_("Base embedded integer instructions (15 registers)")) \
+    X(I,     "I",     N_("Base integer instructions (31 registers)")) \
+    X(M,     "M",     N_("Hardware integer multiply and divide")) \
+    X(A,     "A",     N_("Atomic memory operations")) \
+    X(C,     "C",     N_("Compressed 16-bit instructions")) \
+    X(F,     "F",     N_("Floating-point instructions, single-precision")) \
+    X(D,     "D",     N_("Floating-point instructions, double-precision")) \
+    X(Q,     "Q",     N_("Floating-point instructions, quad-precision")) \
+    X(B,     "B",     N_("Bit manipulation instructions")) \
+    X(V,     "V",     N_("Vector operations")) \
+    X(T,     "T",     N_("Transactional memory")) \
+    X(P,     "P",     N_("Packed SIMD instructions")) \
+    X(L,     "L",     N_("Decimal floating-point instructions")) \
+    X(J,     "J",     N_("Dynamically translated languages")) \
+    X(N,     "N",     N_("User-level interrupts"))
+
+#endif
@@ -22,10 +22,131 @@
 #include <stdio.h>
 #include <string.h>
 #include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#ifdef __has_include
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#endif
+#endif
 #include "util.h"
 
+/* IORING_OP_OPENAT is an enum, not a macro; IORING_FEAT_RW_CUR_POS came
+ * in the same 5.6 header as openat, read and close. Without them
+ * read_batch() uses the pread() pool. */
+#if defined(IORING_FEAT_RW_CUR_POS) && defined(__NR_io_uring_setup)
+#define HAVE_IO_URING 1
+#endif
+
+/* -- per context state, see util_env_use() -- */
+
+typedef struct {
+    char *contents; /* NULL if the file could not be read */
+} probe_entry;
+
+struct util_env {
+    char sysroot[256];
+    int sysroot_set;
+
+    /* probe session */
+    struct {
+        int depth;
+        pthread_mutex_t lock;
+        cpu_string_list *paths; /* same order as entries */
+        probe_entry *entries;
+        int alloc;
+        int dirty; /* read a static file the stored cache did not have */
+    } probe;
+
+    /* stored probe cache */
+    struct {
+        char file[256]; /* "" is off */
+        const char *map;
+        size_t size;
+        const struct pcache_entry *entries;
+        unsigned int count;
+    } pcache;
+
+    probe_stats stats;
+};
+
+static util_env default_env = { "", 0, { 0, PTHREAD_MUTEX_INITIALIZER } };
+static __thread util_env *cur_env = NULL;
+
+static util_env *env(void) {
+    return cur_env ? cur_env : &default_env;
+}
+
+util_env *util_env_new(void) {
+    util_env *e = malloc(sizeof(util_env));
+    if (e) {
+        memset(e, 0, sizeof(*e));
+        pthread_mutex_init(&e->probe.lock, NULL);
+    }
+    return e;
+}
+
+void util_env_free(util_env *e) {
+    if (e && e != &default_env) {
+        if (cur_env == e)
+            cur_env = NULL;
+        pthread_mutex_destroy(&e->probe.lock);
+        free(e);
+    }
+}
+
+util_env *util_env_use(util_env *e) {
+    util_env *prev = cur_env;
+    cur_env = e;
+    return prev;
+}
+
+util_env *util_env_current(void) {
+    return cur_env;
+}
+
+void util_set_root(const char *root) {
+    util_env *e = env();
+    int l;
+    e->sysroot[0] = 0;
+    e->sysroot_set = 0;
+    if (root) {
+        snprintf(e->sysroot, sizeof(e->sysroot), "%s", root);
+        /* no trailing slash, paths are absolute */
+        l = strlen(e->sysroot);
+        while (l > 0 && e->sysroot[l-1] == '/')
+            e->sysroot[--l] = 0;
+        e->sysroot_set = 1;
+    }
+}
+
+const char *util_root(void) {
+    util_env *e = env();
+    if (!e->sysroot_set)
+        util_set_root(getenv(SYSROOT_ENV));
+    if (!e->sysroot_set)
+        e->sysroot_set = 1;
+    return e->sysroot;
+}
+
+char *util_path(char *buf, int size, const char *path) {
+    if (path[0] == '/')
+        snprintf(buf, size, "%s%s", util_root(), path);
+    else
+        snprintf(buf, size, "%s", path);
+    return buf;
+}
+
+#define STAT_ADD(f, n) __atomic_fetch_add(&env()->stats.f, (n), __ATOMIC_RELAXED)
+
 #define GFC_PAGE_SIZE 4096
-char *get_file_contents(const char *file) {
+/* fn is already below the sysroot */
+static char *read_file(const char *fn) {
     FILE *fh;
     char *buff = NULL, *tmp = NULL;
     char *loc = NULL;
@@ -33,9 +154,10 @@ char *get_file_contents(const char *file) {
     unsigned int pages = 1;
     unsigned int fs = 0;
 
-    fh = fopen(file, "r");
+    fh = fopen(fn, "r");
     if (!fh)
         return NULL;
+    STAT_ADD(opened, 1);
 
     buff = malloc( pages * GFC_PAGE_SIZE + 1 );
     if (buff == NULL) {
@@ -60,6 +182,7 @@ char *get_file_contents(const char *file) {
             break;
     }
     fclose(fh);
+    STAT_ADD(bytes, fs);
 
     tmp = malloc(fs + 4);
     if (tmp) {
@@ -75,8 +198,412 @@ char *get_file_contents(const char *file) {
     return buff;
 }
 
+/* -- probe cache, each file is read once between probe_begin() and probe_end() -- */
+
+/* -- stored probe cache --
+ * The static files of a session are written to one file that the next
+ * session maps, for as long as the boot and the online cpus match.
+ * Layout: header, entries sorted by path hash, then the path and
+ * contents bytes the entries point into. */
+
+#define PCACHE_MAGIC "rpizpc1"
+#define PCACHE_VERSION 1
+
+typedef struct {
+    char magic[8];
+    unsigned int version;
+    unsigned int count;
+    char boot_id[40];
+    unsigned long long online_hash; /* also covers the sysroot and kernel */
+    unsigned long long size;        /* whole file */
+} pcache_header;
+
+typedef struct pcache_entry {
+    unsigned long long hash; /* of the path */
+    unsigned int path_off, path_len;
+    unsigned int data_off;
+    int data_len; /* -1 for a file that could not be read */
+} pcache_entry;
+
+static unsigned long long hash_bytes(unsigned long long h, const char *p, size_t len) {
+    /* FNV-1a */
+    while (len--)
+        h = (h ^ (unsigned char)*p++) * 0x100000001b3ULL;
+    return h;
+}
+#define HASH_INIT 0xcbf29ce484222325ULL
+
+void probe_cache_set_file(const char *file) {
+    util_env *e = env();
+    pthread_mutex_lock(&e->probe.lock);
+    snprintf(e->pcache.file, sizeof(e->pcache.file), "%s", file ? file : "");
+    pthread_mutex_unlock(&e->probe.lock);
+}
+
+/* files that stay the same until reboot or cpu hotplug, fn below the sysroot */
+static int probe_static(const char *fn) {
+    static const char *keep[] = {
+        "/proc/cpuinfo", "/proc/device-tree/", "/sys/class/dmi/id/",
+        "/sys/devices/system/cpu/", "/sys/devices/system/node/",
+        "/sys/bus/event_source/devices/", NULL };
+    const char *root = util_root();
+    int i, rl = strlen(root);
+    if (strncmp(fn, root, rl) != 0)
+        return 0;
+    fn += rl;
+    /* governor limits and current values move, as does free memory */
+    if (strstr(fn, "/cpufreq/scaling_") || strstr(fn, "/meminfo"))
+        return 0;
+    for (i = 0; keep[i]; i++)
+        if (strncmp(fn, keep[i], strlen(keep[i])) == 0)
+            return 1;
+    return 0;
+}
+
+/* boot_id and a hash of the online cpus, sysroot and kernel release, the
+ * stored cache is only good for these */
+static void pcache_key(char *boot_id, unsigned long long *online_hash) {
+    char fn[512], *c;
+    const char *root = util_root();
+    memset(boot_id, 0, 40);
+    c = read_file(util_path(fn, sizeof(fn), "/proc/sys/kernel/random/boot_id"));
+    if (c) {
+        strncpy(boot_id, c, 39);
+        free(c);
+    }
+    *online_hash = hash_bytes(HASH_INIT, root, strlen(root) + 1);
+    c = read_file(util_path(fn, sizeof(fn), "/sys/devices/system/cpu/online"));
+    if (c) {
+        *online_hash = hash_bytes(*online_hash, c, strlen(c));
+        free(c);
+    }
+    c = read_file(util_path(fn, sizeof(fn), "/proc/sys/kernel/osrelease"));
+    if (c) {
+        *online_hash = hash_bytes(*online_hash, c, strlen(c));
+        free(c);
+    }
+}
+
+/* called with the lock held */
+static void pcache_load(void) {
+    util_env *e = env();
+    const pcache_header *h;
+    char boot_id[40];
+    unsigned long long online_hash;
+    struct stat st;
+    void *map;
+    int fd;
+
+    if (!e->pcache.file[0]) return;
+    fd = open(e->pcache.file, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(pcache_header)) {
+        close(fd);
+        return;
+    }
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return;
+
+    h = map;
+    pcache_key(boot_id, &online_hash);
+    if (memcmp(h->magic, PCACHE_MAGIC, sizeof(h->magic)) != 0
+        || h->version != PCACHE_VERSION
+        || h->size != (unsigned long long)st.st_size
+        || sizeof(pcache_header) + (unsigned long long)h->count * sizeof(pcache_entry) > h->size
+        || memcmp(h->boot_id, boot_id, sizeof(boot_id)) != 0
+        || h->online_hash != online_hash) {
+        munmap(map, st.st_size);
+        return;
+    }
+    e->pcache.map = map;
+    e->pcache.size = st.st_size;
+    e->pcache.entries = (const pcache_entry *)(e->pcache.map + sizeof(pcache_header));
+    e->pcache.count = h->count;
+}
+
+static void pcache_unload(void) {
+    util_env *e = env();
+    if (e->pcache.map)
+        munmap((void*)e->pcache.map, e->pcache.size);
+    e->pcache.map = NULL;
+    e->pcache.entries = NULL;
+    e->pcache.count = 0;
+}
+
+/* 1 if the stored cache has fn, *data is then NULL for a missing file */
+static int pcache_find(const char *fn, const char **data, int *len) {
+    util_env *e = env();
+    unsigned long long h = hash_bytes(HASH_INIT, fn, strlen(fn));
+    const pcache_entry *ent;
+    unsigned int lo = 0, hi = e->pcache.count, mid;
+    int fl = strlen(fn);
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (e->pcache.entries[mid].hash < h) lo = mid + 1;
+        else hi = mid;
+    }
+    for (; lo < e->pcache.count && e->pcache.entries[lo].hash == h; lo++) {
+        ent = &e->pcache.entries[lo];
+        if ((unsigned long long)ent->path_off + ent->path_len > e->pcache.size
+            || (ent->data_len > 0 && (unsigned long long)ent->data_off + ent->data_len > e->pcache.size))
+            return 0;
+        if ((int)ent->path_len == fl && memcmp(e->pcache.map + ent->path_off, fn, fl) == 0) {
+            *data = (ent->data_len < 0) ? NULL : e->pcache.map + ent->data_off;
+            *len = ent->data_len;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+typedef struct {
+    unsigned long long hash;
+    int index;
+} pcache_sort;
+
+static int pcache_sort_cmp(const void *a, const void *b) {
+    const pcache_sort *x = a, *y = b;
+    return (x->hash > y->hash) - (x->hash < y->hash);
+}
+
+/* called with the lock held, writes the static entries of the session */
+static void pcache_save(void) {
+    util_env *e = env();
+    pcache_header h;
+    pcache_entry *ent = NULL;
+    pcache_sort *order = NULL;
+    char tmp[300];
+    const char *path, *data;
+    unsigned long long off;
+    int i, n = 0, fd;
+    FILE *fh = NULL;
+
+    order = malloc(sizeof(pcache_sort) * (e->probe.paths->count + 1));
+    ent = malloc(sizeof(pcache_entry) * (e->probe.paths->count + 1));
+    if (!order || !ent) goto done;
+    for (i = 0; i < e->probe.paths->count; i++) {
+        path = e->probe.paths->strs[i].str;
+        if (!probe_static(path)) continue;
+        order[n].hash = hash_bytes(HASH_INIT, path, strlen(path));
+        order[n].index = i;
+        n++;
+    }
+    qsort(order, n, sizeof(pcache_sort), pcache_sort_cmp);
+
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, PCACHE_MAGIC, sizeof(h.magic));
+    h.version = PCACHE_VERSION;
+    h.count = n;
+    pcache_key(h.boot_id, &h.online_hash);
+    off = sizeof(h) + sizeof(pcache_entry) * (unsigned long long)n;
+    for (i = 0; i < n; i++) {
+        path = e->probe.paths->strs[order[i].index].str;
+        data = e->probe.entries[order[i].index].contents;
+        ent[i].hash = order[i].hash;
+        ent[i].path_off = off;
+        ent[i].path_len = strlen(path);
+        off += ent[i].path_len;
+        ent[i].data_off = off;
+        ent[i].data_len = data ? (int)strlen(data) : -1;
+        if (data) off += ent[i].data_len;
+    }
+    h.size = off;
+    if (off > 0xffffffffULL) goto done;
+
+    /* readers keep the old file mapped, replace it whole. mkstemp() so
+     * nothing already at the temp name is followed or truncated */
+    snprintf(tmp, sizeof(tmp), "%s.XXXXXX", e->pcache.file);
+    fd = mkstemp(tmp);
+    if (fd < 0) goto done;
+    fchmod(fd, 0644);
+    fh = fdopen(fd, "w");
+    if (!fh) {
+        close(fd);
+        unlink(tmp);
+        goto done;
+    }
+    fwrite(&h, sizeof(h), 1, fh);
+    fwrite(ent, sizeof(pcache_entry), n, fh);
+    for (i = 0; i < n; i++) {
+        path = e->probe.paths->strs[order[i].index].str;
+        data = e->probe.entries[order[i].index].contents;
+        fwrite(path, 1, ent[i].path_len, fh);
+        if (data) fwrite(data, 1, ent[i].data_len, fh);
+    }
+    if (fclose(fh) != 0 || rename(tmp, e->pcache.file) != 0)
+        unlink(tmp);
+done:
+    free(order);
+    free(ent);
+}
+
+void probe_begin(void) {
+    util_env *e = env();
+    pthread_mutex_lock(&e->probe.lock);
+    if (e->probe.depth++ == 0) {
+        e->probe.paths = strlist_new();
+        e->probe.dirty = 0;
+        pcache_load();
+    }
+    pthread_mutex_unlock(&e->probe.lock);
+}
+
+void probe_end(void) {
+    util_env *e = env();
+    int i;
+    pthread_mutex_lock(&e->probe.lock);
+    if (e->probe.depth > 0 && --e->probe.depth == 0) {
+        if (e->probe.dirty && e->pcache.file[0])
+            pcache_save();
+        pcache_unload();
+        for (i = 0; i < e->probe.paths->count; i++)
+            free(e->probe.entries[i].contents);
+        free(e->probe.entries);
+        strlist_free(e->probe.paths);
+        e->probe.entries = NULL;
+        e->probe.paths = NULL;
+        e->probe.alloc = 0;
+    }
+    pthread_mutex_unlock(&e->probe.lock);
+}
+
+int probe_active(void) {
+    util_env *e = env();
+    return __atomic_load_n(&e->probe.depth, __ATOMIC_ACQUIRE) > 0;
+}
+
+void probe_get_stats(probe_stats *st) {
+    util_env *e = env();
+    if (st) {
+        st->opened = __atomic_load_n(&e->stats.opened, __ATOMIC_RELAXED);
+        st->bytes = __atomic_load_n(&e->stats.bytes, __ATOMIC_RELAXED);
+        st->hits = __atomic_load_n(&e->stats.hits, __ATOMIC_RELAXED);
+        st->stored = __atomic_load_n(&e->stats.stored, __ATOMIC_RELAXED);
+    }
+}
+
+void probe_reset_stats(void) {
+    util_env *e = env();
+    __atomic_store_n(&e->stats.opened, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&e->stats.bytes, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&e->stats.hits, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&e->stats.stored, 0, __ATOMIC_RELAXED);
+}
+
+/* called with the lock held */
+static int probe_find(const char *fn, const char **contents) {
+    util_env *e = env();
+    int i = strlist_find(e->probe.paths, fn);
+    if (i >= 0)
+        *contents = e->probe.entries[i].contents;
+    return i >= 0;
+}
+
+/* called with the lock held, takes contents unless another reader got
+ * there first, returns what the session now has for fn */
+static const char *probe_store(const char *fn, char *contents, int from_disk) {
+    util_env *e = env();
+    const char *ret = NULL;
+    probe_entry *tmp;
+    if (probe_find(fn, &ret)) {
+        free(contents);
+        return ret;
+    }
+    if (e->probe.paths->count == e->probe.alloc) {
+        e->probe.alloc = e->probe.alloc ? e->probe.alloc * 2 : 64;
+        tmp = realloc(e->probe.entries, sizeof(probe_entry) * e->probe.alloc);
+        if (!tmp)
+            return contents; /* leaks one file, but stays correct */
+        e->probe.entries = tmp;
+    }
+    e->probe.entries[e->probe.paths->count].contents = contents;
+    strlist_add(e->probe.paths, fn);
+    if (from_disk && e->pcache.file[0] && probe_static(fn))
+        e->probe.dirty = 1;
+    return contents;
+}
+
+const char *probe_file(const char *file) {
+    util_env *e = env();
+    char fn[512];
+    const char *ret = NULL, *data;
+    char *contents = NULL;
+    int len, stored;
+
+    util_path(fn, sizeof(fn), file);
+    pthread_mutex_lock(&e->probe.lock);
+    if (!e->probe.depth) {
+        pthread_mutex_unlock(&e->probe.lock);
+        return NULL;
+    }
+    if (probe_find(fn, &ret)) {
+        pthread_mutex_unlock(&e->probe.lock);
+        STAT_ADD(hits, 1);
+        return ret;
+    }
+    stored = probe_static(fn) && pcache_find(fn, &data, &len);
+    if (stored && data) {
+        contents = malloc(len + 1);
+        if (contents) {
+            memcpy(contents, data, len);
+            contents[len] = 0;
+        } else
+            stored = 0;
+    }
+    pthread_mutex_unlock(&e->probe.lock);
+
+    if (stored)
+        STAT_ADD(stored, 1);
+    else
+        /* read without the lock, par_for() workers probe at the same time */
+        contents = read_file(fn);
+
+    pthread_mutex_lock(&e->probe.lock);
+    ret = probe_store(fn, contents, !stored);
+    pthread_mutex_unlock(&e->probe.lock);
+    return ret;
+}
+
+char *get_file_contents(const char *file) {
+    char fn[512];
+    const char *c;
+    if (probe_active()) {
+        c = probe_file(file);
+        return c ? strdup(c) : NULL;
+    }
+    return read_file(util_path(fn, sizeof(fn), file));
+}
+
+int get_file_buff(const char *file, char *buff, int size) {
+    char fn[512];
+    const char *c;
+    int fd, len;
+    if (!buff || size < 1)
+        return -1;
+    if (probe_active()) {
+        c = probe_file(file);
+        if (!c) return -1;
+        snprintf(buff, size, "%s", c);
+        return strlen(buff);
+    }
+    /* not stdio, so nothing is allocated */
+    fd = open(util_path(fn, sizeof(fn), file), O_RDONLY);
+    if (fd < 0)
+        return -1;
+    STAT_ADD(opened, 1);
+    len = read(fd, buff, size - 1);
+    close(fd);
+    if (len < 0)
+        return -1;
+    STAT_ADD(bytes, len);
+    buff[len] = 0;
+    return len;
+}
+
 int dir_exists(const char* path) {
-    DIR* dir = opendir(path);
+    char fn[512];
+    DIR* dir = opendir(util_path(fn, sizeof(fn), path));
     if (dir) {
         closedir(dir);
         return 1;
@@ -112,64 +639,247 @@ int get_cpu_freq(int id, int *min, int *max, int *cur) {
     return !!ret;
 }
 
+#define STRLIST_CHUNK_SIZE 4096
+
+struct strlist_chunk {
+    strlist_chunk *next;
+    int size, used;
+    char data[];
+};
+
 cpu_string_list *strlist_new(void) {
     cpu_string_list *list = malloc( sizeof(cpu_string_list) );
-    list->count = 0;
-    list->strs = NULL;
+    if (list)
+        memset(list, 0, sizeof(*list));
     return list;
 }
 
 void strlist_free(cpu_string_list *list) {
+    strlist_chunk *c, *n;
+    if (list) {
+        for (c = list->arena; c; c = n) {
+            n = c->next;
+            free(c);
+        }
+        free(list->index);
+        free(list->strs);
+        free(list);
+    }
+}
+
+/* FNV-1a */
+static unsigned int strlist_hash(const char *str, int len) {
+    unsigned int h = 2166136261u;
     int i;
+    for (i = 0; i < len; i++) {
+        h ^= (unsigned char)str[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static char *strlist_arena_dup(cpu_string_list *list, const char *str, int len) {
+    strlist_chunk *c = list->arena;
+    char *ret;
+    int sz;
+    if (!c || c->size - c->used < len + 1) {
+        sz = (len + 1 > STRLIST_CHUNK_SIZE) ? len + 1 : STRLIST_CHUNK_SIZE;
+        c = malloc(sizeof(strlist_chunk) + sz);
+        if (!c) return NULL;
+        c->size = sz;
+        c->used = 0;
+        if (list->arena && len + 1 > STRLIST_CHUNK_SIZE) {
+            /* oversized string, keep filling the current chunk */
+            c->next = list->arena->next;
+            list->arena->next = c;
+        } else {
+            c->next = list->arena;
+            list->arena = c;
+        }
+    }
+    ret = c->data + c->used;
+    memcpy(ret, str, len);
+    ret[len] = 0;
+    c->used += len + 1;
+    return ret;
+}
+
+/* keep the index at most half full */
+static int strlist_grow_index(cpu_string_list *list) {
+    int i, slot, size = list->index_size ? list->index_size * 2 : 16;
+    int *index = malloc(sizeof(int) * size);
+    if (!index) return 0;
+    memset(index, -1, sizeof(int) * size);
     for (i = 0; i < list->count; i++) {
-        free(list->strs[i].str);
+        slot = list->strs[i].hash & (size - 1);
+        while (index[slot] >= 0)
+            slot = (slot + 1) & (size - 1);
+        index[slot] = i;
     }
-    free(list);
-    list = NULL;
+    free(list->index);
+    list->index = index;
+    list->index_size = size;
+    return 1;
 }
 
-char *strlist_add_w(cpu_string_list *list, const char* str, int weight) {
-    int i;
+/* returns the index slot holding str, or the empty slot where it would go */
+static int strlist_lookup(cpu_string_list *list, const char *str, int len, unsigned int hash) {
+    int slot = hash & (list->index_size - 1), i;
+    while ((i = list->index[slot]) >= 0) {
+        if (list->strs[i].hash == hash
+            && strncmp(list->strs[i].str, str, len) == 0 && list->strs[i].str[len] == 0)
+            break;
+        slot = (slot + 1) & (list->index_size - 1);
+    }
+    return slot;
+}
+
+int strlist_find_n(cpu_string_list *list, const char* str, int len) {
+    if (!list || !str || !list->index_size) return -1;
+    return list->index[strlist_lookup(list, str, len, strlist_hash(str, len))];
+}
+
+int strlist_find(cpu_string_list *list, const char* str) {
+    if (!str) return -1;
+    return strlist_find_n(list, str, strlen(str));
+}
+
+char *strlist_add_wn(cpu_string_list *list, const char* str, int len, int weight) {
+    unsigned int hash = strlist_hash(str, len);
     cpu_string *tmp;
-    for (i = 0; i < list->count; i++) {
-        if (strcmp(list->strs[i].str, str) == 0) {
-            /* found */
-            list->strs[i].ref_count += weight;
-            return list->strs[i].str;
-        }
+    int i, slot;
+
+    if ((list->count + 1) * 2 > list->index_size)
+        if (!strlist_grow_index(list))
+            return NULL;
+
+    slot = strlist_lookup(list, str, len, hash);
+    i = list->index[slot];
+    if (i >= 0) {
+        /* found */
+        list->strs[i].ref_count += weight;
+        return list->strs[i].str;
     }
-    /* not found */
-    i = list->count; list->count++;
 
-    if (list->strs == NULL)
-        list->strs = malloc(sizeof(cpu_string));
-    else {
-        tmp = realloc(list->strs, sizeof(cpu_string) * list->count);
-        if (tmp)
-            list->strs = tmp;
-        else
+    /* not found */
+    if (list->count == list->alloc) {
+        tmp = realloc(list->strs, sizeof(cpu_string) * (list->alloc ? list->alloc * 2 : 8));
+        if (!tmp)
             return NULL;
+        list->strs = tmp;
+        list->alloc = list->alloc ? list->alloc * 2 : 8;
     }
 
-    list->strs[i].str = malloc(strlen(str) + 1);
-    if (list->strs[i].str != NULL)
-        strcpy(list->strs[i].str, str);
+    i = list->count;
+    list->strs[i].str = strlist_arena_dup(list, str, len);
+    if (list->strs[i].str == NULL)
+        return NULL;
     list->strs[i].ref_count = weight;
+    list->strs[i].hash = hash;
+    list->index[slot] = i;
+    list->count++;
     return list->strs[i].str;
 }
 
+char *strlist_add_w(cpu_string_list *list, const char* str, int weight) {
+    return strlist_add_wn(list, str, strlen(str), weight);
+}
+
+char *strlist_add_n(cpu_string_list *list, const char* str, int len) {
+    return strlist_add_wn(list, str, len, 1);
+}
+
 char *strlist_add(cpu_string_list *list, const char* str) {
-    return strlist_add_w(list, str, 1);
+    return strlist_add_wn(list, str, strlen(str), 1);
 }
 
-#define MAXLEN_KEY 128
-#define MAXLEN_VALUE 512
+cpu_flagset *flagset_new(const char *(*known_name)(int id), int known) {
+    cpu_flagset *fs = malloc( sizeof(cpu_flagset) );
+    int i;
+    if (fs) {
+        memset(fs, 0, sizeof(*fs));
+        fs->ids = strlist_new();
+        if (!fs->ids) {
+            free(fs);
+            return NULL;
+        }
+        for (i = 0; i < known; i++)
+            strlist_add_w(fs->ids, known_name(i), 0);
+        fs->known = known;
+    }
+    return fs;
+}
 
+void flagset_free(cpu_flagset *fs) {
+    if (fs) {
+        strlist_free(fs->ids);
+        free(fs->bits);
+        free(fs->count);
+        free(fs);
+    }
+}
+
+int flagset_id(cpu_flagset *fs, const char *flag, int len, int add) {
+    int id = strlist_find_n(fs->ids, flag, len);
+    if (id < 0 && add && !fs->bits) {
+        id = fs->ids->count;
+        if (!strlist_add_wn(fs->ids, flag, len, 0))
+            return -1;
+    }
+    return id;
+}
+
+int flagset_alloc(cpu_flagset *fs, int rows) {
+    free(fs->bits);
+    free(fs->count);
+    fs->rows = rows;
+    fs->words = FLAGSET_WORDS(fs->ids->count);
+    fs->bits = calloc((size_t)rows * fs->words + 1, sizeof(unsigned long long));
+    fs->count = calloc(fs->ids->count + 1, sizeof(int));
+    return (fs->bits && fs->count);
+}
+
+void flagset_or(cpu_flagset *fs, int row, const unsigned long long *bits) {
+    unsigned long long *r = fs->bits + (size_t)row * fs->words;
+    int w;
+    for (w = 0; w < fs->words; w++)
+        r[w] |= bits[w];
+}
+
+int flagset_test(const cpu_flagset *fs, int row, int id) {
+    if (fs && fs->bits && row >= 0 && row < fs->rows && id >= 0 && id < fs->ids->count)
+        return FLAGSET_BIT_TEST(fs->bits + (size_t)row * fs->words, id);
+    return 0;
+}
+
+void flagset_count_rows(cpu_flagset *fs) {
+    unsigned long long *r, w;
+    int row, i;
+    memset(fs->count, 0, sizeof(int) * fs->ids->count);
+    for (row = 0; row < fs->rows; row++) {
+        r = fs->bits + (size_t)row * fs->words;
+        for (i = 0; i < fs->words; i++) {
+            w = r[i];
+            while (w) {
+                fs->count[i * 64 + __builtin_ctzll(w)]++;
+                w &= w - 1;
+            }
+        }
+    }
+}
+
+int flagset_count(const cpu_flagset *fs, int id) {
+    if (fs && fs->count && id >= 0 && id < fs->ids->count)
+        return fs->count[id];
+    return 0;
+}
+
+/* The scanner never copies: key and value are slices into the
+ * buffer, so there is no limit on line length. */
 struct kv_scan {
     char *buffer;
     int own_buffer;
-    char *curline, *nextline;
-    char key[MAXLEN_KEY], value[MAXLEN_VALUE];
+    const char *curline;
 };
 
 kv_scan *kv_new(char *buffer) {
@@ -177,11 +887,9 @@ kv_scan *kv_new(char *buffer) {
     if (buffer) {
         s = malloc( sizeof(kv_scan) );
         if (s) {
-            memset(s, 0, sizeof(*s));
             s->buffer = buffer;
             s->own_buffer = 0;
             s->curline = s->buffer;
-            s->nextline = strchr(s->curline, '\n');
         }
     }
     return s;
@@ -189,49 +897,50 @@ kv_scan *kv_new(char *buffer) {
 
 kv_scan *kv_new_file(const char *file) {
     kv_scan *s = NULL;
-    s = malloc( sizeof(kv_scan) );
-    if (s) {
-        memset(s, 0, sizeof(*s));
-        s->buffer = get_file_contents(file);
-        if (s->buffer) {
+    char *buffer;
+    if (probe_active()) {
+        /* scan the shared copy, it outlives the scanner */
+        buffer = (char*)probe_file(file);
+        return buffer ? kv_new(buffer) : NULL;
+    }
+    buffer = get_file_contents(file);
+    if (buffer) {
+        s = kv_new(buffer);
+        if (s)
             s->own_buffer = 1;
-            s->curline = s->buffer;
-            s->nextline = strchr(s->curline, '\n');
-        } else {
-            free(s);
-            return NULL;
-        }
+        else
+            free(buffer);
     }
     return s;
 }
 
-int kv_next(kv_scan *s, char **k, char **v) {
-    int klen, vlen, found = 0;
-    char *nextcol = NULL;
+int kv_next(kv_scan *s, kv_slice *k, kv_slice *v) {
+    const char *line, *eol, *col, *ke;
     if (s) {
-        *k = NULL; *v = NULL;
-        while(s->nextline != NULL) {
-            nextcol = strchr(s->curline, ':');
-            if (nextcol != NULL && nextcol < s->nextline) {
-                klen = nextcol - s->curline;
-                nextcol++; while (*nextcol == ' ') nextcol++; /* skip : and any leading spaces */
-                vlen = s->nextline - nextcol;
-                if (klen > MAXLEN_KEY-1) klen = MAXLEN_KEY-1;
-                if (vlen > MAXLEN_VALUE-1) vlen = MAXLEN_VALUE-1;
-                memset(s->key, 0, MAXLEN_KEY);
-                memset(s->value, 0, MAXLEN_VALUE);
-                strncpy(s->key, s->curline, klen);
-                strncpy(s->value, nextcol, vlen);
-                *k = s->key; *v = s->value; found = 1;
+        k->str = v->str = NULL; k->len = v->len = 0;
+        while(*s->curline) {
+            line = s->curline;
+            eol = strchr(line, '\n');
+            if (eol)
+                s->curline = eol + 1;
+            else {
+                /* last line without a newline */
+                eol = line + strlen(line);
+                s->curline = eol;
             }
-            s->curline = s->nextline + 1;
-            s->nextline = strchr(s->curline, '\n');
-            if (found)
+            col = memchr(line, ':', eol - line);
+            if (col != NULL) {
+                /* key without trailing whitespace */
+                ke = col;
+                while (ke > line && (ke[-1] == ' ' || ke[-1] == '\t')) ke--;
+                col++; while (*col == ' ') col++; /* skip : and any leading spaces */
+                k->str = line; k->len = ke - line;
+                v->str = col;  v->len = eol - col;
                 return 1;
+            }
         }
-        return 0;
-    } else
-        return 0;
+    }
+    return 0;
 }
 
 void kv_free(kv_scan *s) {
@@ -241,3 +950,673 @@ void kv_free(kv_scan *s) {
         free(s);
     }
 }
+
+int kv_slice_eq(const kv_slice *sl, const char *str, int len) {
+    return (sl->len == len && memcmp(sl->str, str, len) == 0);
+}
+
+/* copies at most size-1 bytes and always terminates */
+char *kv_slice_copy(char *dest, int size, const kv_slice *sl) {
+    int len = sl->len;
+    if (len > size - 1) len = size - 1;
+    memcpy(dest, sl->str, len);
+    dest[len] = 0;
+    return dest;
+}
+
+static int par_jobs_set = 0;
+
+void par_set_jobs(int jobs) {
+    if (jobs > PAR_JOBS_MAX) jobs = PAR_JOBS_MAX;
+    par_jobs_set = (jobs < 0) ? 0 : jobs;
+}
+
+int par_jobs(void) {
+    long n;
+    if (par_jobs_set)
+        return par_jobs_set;
+    n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n < 1) n = 1;
+    if (n > PAR_JOBS_MAX) n = PAR_JOBS_MAX;
+    return n;
+}
+
+typedef struct {
+    void (*func)(void *data, int i);
+    void *data;
+    int count;
+    int next; /* shared, taken with __atomic_fetch_add */
+    util_env *env; /* of the caller */
+} par_work;
+
+static __thread int par_depth = 0; /* inside a par_for() on this thread */
+
+static void *par_worker(void *data) {
+    par_work *w = data;
+    int i;
+    util_env_use(w->env);
+    par_depth++;
+    while ((i = __atomic_fetch_add(&w->next, 1, __ATOMIC_RELAXED)) < w->count)
+        w->func(w->data, i);
+    par_depth--;
+    return NULL;
+}
+
+#define PAR_MIN_PER_JOB 8 /* not worth a thread for fewer items */
+void par_for(int count, void (*func)(void *data, int i), void *data) {
+    pthread_t threads[PAR_JOBS_MAX];
+    par_work w = { func, data, count, 0, cur_env };
+    int i, n, started = 0;
+
+    if (count <= 0) return;
+    /* the outer pool already has the threads */
+    n = par_depth ? 1 : par_jobs();
+    if (n > (count + PAR_MIN_PER_JOB - 1) / PAR_MIN_PER_JOB)
+        n = (count + PAR_MIN_PER_JOB - 1) / PAR_MIN_PER_JOB;
+    if (n > 1) {
+        util_root(); /* resolve the sysroot before anyone races to */
+        for (i = 1; i < n; i++) {
+            if (pthread_create(&threads[started], NULL, par_worker, &w) != 0)
+                break;
+            started++;
+        }
+    }
+    /* this thread works too, and does everything if no thread started */
+    par_worker(&w);
+    for (i = 0; i < started; i++)
+        pthread_join(threads[i], NULL);
+}
+
+/* locks are picked by the address of done, so separate objects
+ * (and contexts on other threads) rarely wait for each other */
+#define LAZY_LOCKS 16
+static pthread_mutex_t lazy_lock[LAZY_LOCKS] = {
+    PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER,
+    PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER,
+    PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER,
+    PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER,
+};
+
+void lazy_once(int *done, int bit, lazy_func func, void *data) {
+    pthread_mutex_t *lock;
+    if (__atomic_load_n(done, __ATOMIC_ACQUIRE) & bit)
+        return;
+    lock = &lazy_lock[((unsigned long)done / sizeof(int)) % LAZY_LOCKS];
+    pthread_mutex_lock(lock);
+    if (!(*done & bit)) {
+        func(data);
+        __atomic_or_fetch(done, bit, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(lock);
+}
+
+static int read_mode = READ_BATCH_AUTO;
+
+void read_batch_set_mode(int mode) {
+    read_mode = mode;
+}
+
+int read_batch_mode(void) {
+    return read_mode;
+}
+
+static void read_one(read_req *r) {
+    int fd = open(r->path, O_RDONLY | O_CLOEXEC);
+    r->len = -1;
+    r->buff[0] = 0;
+    if (fd < 0) return;
+    STAT_ADD(opened, 1);
+    r->len = pread(fd, r->buff, READ_REQ_BUFF - 1, 0);
+    if (r->len >= 0) {
+        r->buff[r->len] = 0;
+        STAT_ADD(bytes, r->len);
+    }
+    close(fd);
+}
+
+/* -- io_uring, raw syscalls so there is no liburing dependency -- */
+
+#ifdef HAVE_IO_URING
+
+#define URING_DEPTH 256
+
+typedef struct {
+    int fd;
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *sq_ptr, *cq_ptr;
+    size_t sq_size, cq_size, sqes_size;
+} uring;
+
+static void uring_exit(uring *u) {
+    if (u->sqes) munmap(u->sqes, u->sqes_size);
+    if (u->cq_ptr && u->cq_ptr != u->sq_ptr) munmap(u->cq_ptr, u->cq_size);
+    if (u->sq_ptr) munmap(u->sq_ptr, u->sq_size);
+    if (u->fd >= 0) close(u->fd);
+}
+
+static int uring_init(uring *u, unsigned entries) {
+    struct io_uring_params p;
+    memset(u, 0, sizeof(*u));
+    memset(&p, 0, sizeof(p));
+    u->fd = syscall(__NR_io_uring_setup, entries, &p);
+    if (u->fd < 0)
+        return 0;
+
+    u->sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    u->cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (u->cq_size > u->sq_size) u->sq_size = u->cq_size;
+        u->cq_size = u->sq_size;
+    }
+    u->sq_ptr = mmap(NULL, u->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQ_RING);
+    if (u->sq_ptr == MAP_FAILED) {
+        u->sq_ptr = NULL;
+        uring_exit(u);
+        return 0;
+    }
+    if (p.features & IORING_FEAT_SINGLE_MMAP)
+        u->cq_ptr = u->sq_ptr;
+    else {
+        u->cq_ptr = mmap(NULL, u->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_CQ_RING);
+        if (u->cq_ptr == MAP_FAILED) {
+            u->cq_ptr = NULL;
+            uring_exit(u);
+            return 0;
+        }
+    }
+    u->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+    u->sqes = mmap(NULL, u->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQES);
+    if (u->sqes == MAP_FAILED) {
+        u->sqes = NULL;
+        uring_exit(u);
+        return 0;
+    }
+    u->sq_head = (unsigned*)((char*)u->sq_ptr + p.sq_off.head);
+    u->sq_tail = (unsigned*)((char*)u->sq_ptr + p.sq_off.tail);
+    u->sq_mask = (unsigned*)((char*)u->sq_ptr + p.sq_off.ring_mask);
+    u->sq_array = (unsigned*)((char*)u->sq_ptr + p.sq_off.array);
+    u->cq_head = (unsigned*)((char*)u->cq_ptr + p.cq_off.head);
+    u->cq_tail = (unsigned*)((char*)u->cq_ptr + p.cq_off.tail);
+    u->cq_mask = (unsigned*)((char*)u->cq_ptr + p.cq_off.ring_mask);
+    u->cqes = (struct io_uring_cqe*)((char*)u->cq_ptr + p.cq_off.cqes);
+    return 1;
+}
+
+static struct io_uring_sqe *uring_sqe(uring *u, unsigned n) {
+    unsigned tail = *u->sq_tail + n;
+    unsigned idx = tail & *u->sq_mask;
+    u->sq_array[idx] = idx;
+    memset(&u->sqes[idx], 0, sizeof(struct io_uring_sqe));
+    return &u->sqes[idx];
+}
+
+/* submit n prepared sqes, wait for all of them,
+ * res[user_data] = result */
+static int uring_run(uring *u, unsigned n, int *res) {
+    unsigned head, done = 0;
+    int r;
+    __atomic_store_n(u->sq_tail, *u->sq_tail + n, __ATOMIC_RELEASE);
+    do {
+        r = syscall(__NR_io_uring_enter, u->fd, done ? 0 : n, n - done, IORING_ENTER_GETEVENTS, NULL, 0);
+        if (r < 0 && errno != EINTR)
+            return 0;
+        head = *u->cq_head;
+        while (head != __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE)) {
+            struct io_uring_cqe *cqe = &u->cqes[head & *u->cq_mask];
+            res[cqe->user_data] = cqe->res;
+            head++;
+            done++;
+        }
+        __atomic_store_n(u->cq_head, head, __ATOMIC_RELEASE);
+    } while (done < n);
+    return 1;
+}
+
+/* after a failed submission, the files it left open */
+static void uring_close_fds(int *fds, int n) {
+    int i;
+    for (i = 0; i < n; i++)
+        if (fds[i] >= 0)
+            close(fds[i]);
+}
+
+/* openat, read and close each go out as one submission per chunk,
+ * three io_uring_enter() calls instead of three syscalls per file */
+static int read_batch_uring(read_req *reqs, int count) {
+    uring u;
+    int fds[URING_DEPTH], res[URING_DEPTH];
+    int base, n, i;
+    struct io_uring_sqe *sqe;
+
+    if (!uring_init(&u, URING_DEPTH))
+        return 0;
+    for (base = 0; base < count; base += n) {
+        n = (count - base < URING_DEPTH) ? count - base : URING_DEPTH;
+
+        for (i = 0; i < n; i++) {
+            sqe = uring_sqe(&u, i);
+            sqe->opcode = IORING_OP_OPENAT;
+            sqe->fd = AT_FDCWD;
+            sqe->addr = (unsigned long)reqs[base + i].path;
+            sqe->open_flags = O_RDONLY | O_CLOEXEC;
+            sqe->user_data = i;
+            fds[i] = -1;
+        }
+        if (!uring_run(&u, n, fds) || fds[0] == -EINVAL) { /* -EINVAL: kernel older than 5.6 */
+            uring_close_fds(fds, n);
+            break;
+        }
+
+        for (i = 0; i < n; i++) {
+            sqe = uring_sqe(&u, i);
+            if (fds[i] < 0) {
+                sqe->opcode = IORING_OP_NOP;
+            } else {
+                sqe->opcode = IORING_OP_READ;
+                sqe->fd = fds[i];
+                sqe->addr = (unsigned long)reqs[base + i].buff;
+                sqe->len = READ_REQ_BUFF - 1;
+                sqe->off = 0;
+            }
+            sqe->user_data = i;
+        }
+        if (!uring_run(&u, n, res)) {
+            uring_close_fds(fds, n);
+            break;
+        }
+
+        for (i = 0; i < n; i++) {
+            sqe = uring_sqe(&u, i);
+            if (fds[i] < 0) {
+                sqe->opcode = IORING_OP_NOP;
+            } else {
+                sqe->opcode = IORING_OP_CLOSE;
+                sqe->fd = fds[i];
+            }
+            sqe->user_data = i;
+            reqs[base + i].len = (fds[i] < 0 || res[i] < 0) ? -1 : res[i];
+            if (fds[i] >= 0)
+                STAT_ADD(opened, 1);
+            if (reqs[base + i].len > 0)
+                STAT_ADD(bytes, reqs[base + i].len);
+            reqs[base + i].buff[(reqs[base + i].len > 0) ? reqs[base + i].len : 0] = 0;
+            res[i] = 1; /* close never completes with a positive result */
+        }
+        if (!uring_run(&u, n, res)) {
+            /* close the ones that did not complete */
+            for (i = 0; i < n; i++)
+                if (res[i] != 1)
+                    fds[i] = -1;
+            uring_close_fds(fds, n);
+            break;
+        }
+    }
+    uring_exit(&u);
+    if (base == 0)
+        return 0; /* nothing went through io_uring, the caller falls back */
+    if (base < count) {
+        /* finish what io_uring did not do */
+        for (i = base; i < count; i++)
+            read_one(&reqs[i]);
+    }
+    return 1;
+}
+
+#endif /* HAVE_IO_URING */
+
+/* -- pread() thread pool fallback -- */
+
+static void read_item(void *data, int i) {
+    read_one(&((read_req*)data)[i]);
+}
+
+static int read_batch_threads(read_req *reqs, int count) {
+    par_for(count, read_item, reqs);
+    return 1;
+}
+
+static int read_batch_io(read_req *reqs, int count) {
+    int i;
+    switch (read_mode) {
+        case READ_BATCH_AUTO:
+        case READ_BATCH_URING:
+#ifdef HAVE_IO_URING
+            if (read_batch_uring(reqs, count))
+                return READ_BATCH_URING;
+#endif
+            /* fall through */
+        case READ_BATCH_THREADS:
+            if (read_batch_threads(reqs, count))
+                return READ_BATCH_THREADS;
+            /* fall through */
+        default:
+            for (i = 0; i < count; i++)
+                read_one(&reqs[i]);
+            return READ_BATCH_SERIAL;
+    }
+}
+
+/* in a probe session, static files come from the stored cache and
+ * what is read is kept for the next one */
+int read_batch(read_req *reqs, int count) {
+    util_env *e = env();
+    read_req *miss;
+    const char *data;
+    int *slot, i, n = 0, len, mode;
+
+    if (!reqs || count <= 0)
+        return READ_BATCH_SERIAL;
+    if (!probe_active() || !e->pcache.file[0])
+        return read_batch_io(reqs, count);
+
+    miss = malloc(sizeof(read_req) * count);
+    slot = malloc(sizeof(int) * count);
+    if (!miss || !slot) {
+        free(miss);
+        free(slot);
+        return read_batch_io(reqs, count);
+    }
+    pthread_mutex_lock(&e->probe.lock);
+    for (i = 0; i < count; i++) {
+        if (probe_static(reqs[i].path) && pcache_find(reqs[i].path, &data, &len)) {
+            reqs[i].len = len;
+            reqs[i].buff[0] = 0;
+            if (len >= 0) {
+                if (len > READ_REQ_BUFF - 1)
+                    reqs[i].len = len = READ_REQ_BUFF - 1;
+                memcpy(reqs[i].buff, data, len);
+                reqs[i].buff[len] = 0;
+            }
+            STAT_ADD(stored, 1);
+        } else {
+            miss[n] = reqs[i];
+            slot[n++] = i;
+        }
+    }
+    pthread_mutex_unlock(&e->probe.lock);
+
+    mode = n ? read_batch_io(miss, n) : READ_BATCH_SERIAL;
+
+    pthread_mutex_lock(&e->probe.lock);
+    for (i = 0; i < n; i++) {
+        reqs[slot[i]] = miss[i];
+        /* a full buffer may have been cut short, leave it out */
+        if (e->probe.depth && miss[i].len < READ_REQ_BUFF - 1 && probe_static(miss[i].path))
+            probe_store(miss[i].path, (miss[i].len < 0) ? NULL : strdup(miss[i].buff), 1);
+    }
+    pthread_mutex_unlock(&e->probe.lock);
+    free(miss);
+    free(slot);
+    return mode;
+}
+
+read_req *read_cpu_batch(const int *ids, int count, const char **items, int nitems) {
+    read_req *reqs;
+    char fn[READ_REQ_PATH];
+    int i, k;
+    if (count <= 0 || nitems <= 0) return NULL;
+    reqs = malloc(sizeof(read_req) * count * nitems);
+    if (!reqs) return NULL;
+    for (i = 0; i < count; i++)
+        for (k = 0; k < nitems; k++) {
+            snprintf(fn, sizeof(fn), "/sys/devices/system/cpu/cpu%d/%s", ids[i], items[k]);
+            util_path(reqs[i * nitems + k].path, READ_REQ_PATH, fn);
+        }
+    read_batch(reqs, count * nitems);
+    return reqs;
+}
+
+int read_req_int(const read_req *r) {
+    if (r && r->len > 0)
+        return atol(r->buff);
+    return 0;
+}
+
+int get_cpu_freq_batch(const int *ids, int count, int *min, int *max, int *cur) {
+    static const char *items[] = {
+        "cpufreq/scaling_min_freq",
+        "cpufreq/scaling_max_freq",
+        "cpufreq/scaling_cur_freq",
+    };
+    read_req *reqs;
+    int i, ret = 0;
+    reqs = read_cpu_batch(ids, count, items, 3);
+    if (!reqs) return 0;
+    for (i = 0; i < count; i++) {
+        min[i] = read_req_int(&reqs[i * 3]);
+        max[i] = read_req_int(&reqs[i * 3 + 1]);
+        cur[i] = read_req_int(&reqs[i * 3 + 2]);
+        ret |= min[i] | max[i] | cur[i];
+    }
+    free(reqs);
+    return !!ret;
+}
+
+int get_cpu_freq_cur_batch(const int *ids, int count, int *cur) {
+    static const char *items[] = { "cpufreq/scaling_cur_freq" };
+    read_req *reqs;
+    int i, ret = 0;
+    reqs = read_cpu_batch(ids, count, items, 1);
+    if (!reqs) return 0;
+    for (i = 0; i < count; i++) {
+        cur[i] = read_req_int(&reqs[i]);
+        ret |= cur[i];
+    }
+    free(reqs);
+    return !!ret;
+}
+
+long get_size_str(const char *str) {
+    char *end = NULL;
+    long ret;
+    if (!str) return 0;
+    ret = strtol(str, &end, 10);
+    switch (*end) {
+        case 'K': case 'k':
+            return ret * 1024;
+        case 'M': case 'm':
+            return ret * 1024 * 1024;
+        case 'G': case 'g':
+            return ret * 1024 * 1024 * 1024;
+        default:
+            return ret;
+    }
+}
+
+cpu_mask *cpumask_new(int nbits) {
+    cpu_mask *m = malloc( sizeof(cpu_mask) );
+    if (m) {
+        if (nbits < 64) nbits = 64;
+        m->nbits = FLAGSET_WORDS(nbits) * 64;
+        m->bits = calloc(FLAGSET_WORDS(nbits), sizeof(unsigned long long));
+        if (!m->bits) {
+            free(m);
+            return NULL;
+        }
+    }
+    return m;
+}
+
+cpu_mask *cpumask_copy(const cpu_mask *src) {
+    cpu_mask *m = NULL;
+    if (src) {
+        m = cpumask_new(src->nbits);
+        if (m)
+            memcpy(m->bits, src->bits, sizeof(unsigned long long) * FLAGSET_WORDS(src->nbits));
+    }
+    return m;
+}
+
+void cpumask_free(cpu_mask *m) {
+    if (m) {
+        free(m->bits);
+        free(m);
+    }
+}
+
+int cpumask_set(cpu_mask *m, int cpu) {
+    unsigned long long *tmp;
+    int words;
+    if (!m || cpu < 0) return 0;
+    if (cpu >= m->nbits) {
+        words = FLAGSET_WORDS(cpu + 1);
+        if (words < FLAGSET_WORDS(m->nbits) * 2) words = FLAGSET_WORDS(m->nbits) * 2;
+        tmp = realloc(m->bits, sizeof(unsigned long long) * words);
+        if (!tmp) return 0;
+        memset(tmp + FLAGSET_WORDS(m->nbits), 0, sizeof(unsigned long long) * (words - FLAGSET_WORDS(m->nbits)));
+        m->bits = tmp;
+        m->nbits = words * 64;
+    }
+    FLAGSET_BIT_SET(m->bits, cpu);
+    return 1;
+}
+
+void cpumask_clear(cpu_mask *m, int cpu) {
+    if (m && cpu >= 0 && cpu < m->nbits)
+        m->bits[cpu / 64] &= ~(1ULL << (cpu % 64));
+}
+
+int cpumask_test(const cpu_mask *m, int cpu) {
+    if (m && cpu >= 0 && cpu < m->nbits)
+        return FLAGSET_BIT_TEST(m->bits, cpu);
+    return 0;
+}
+
+int cpumask_count(const cpu_mask *m) {
+    int i, ret = 0;
+    if (m)
+        for (i = 0; i < FLAGSET_WORDS(m->nbits); i++)
+            ret += __builtin_popcountll(m->bits[i]);
+    return ret;
+}
+
+int cpumask_next(const cpu_mask *m, int prev) {
+    unsigned long long w;
+    int i, cpu = prev + 1;
+    if (!m || cpu >= m->nbits) return -1;
+    i = cpu / 64;
+    w = m->bits[i] & (~0ULL << (cpu % 64));
+    while (!w) {
+        if (++i >= FLAGSET_WORDS(m->nbits))
+            return -1;
+        w = m->bits[i];
+    }
+    return i * 64 + __builtin_ctzll(w);
+}
+
+int cpumask_equal(const cpu_mask *a, const cpu_mask *b) {
+    int i, wa, wb;
+    unsigned long long x, y;
+    if (!a || !b) return (a == b);
+    wa = FLAGSET_WORDS(a->nbits);
+    wb = FLAGSET_WORDS(b->nbits);
+    for (i = 0; i < wa || i < wb; i++) {
+        x = (i < wa) ? a->bits[i] : 0;
+        y = (i < wb) ? b->bits[i] : 0;
+        if (x != y) return 0;
+    }
+    return 1;
+}
+
+void cpumask_and(cpu_mask *dst, const cpu_mask *src) {
+    int i, ws;
+    if (!dst || !src) return;
+    ws = FLAGSET_WORDS(src->nbits);
+    for (i = 0; i < FLAGSET_WORDS(dst->nbits); i++)
+        dst->bits[i] &= (i < ws) ? src->bits[i] : 0;
+}
+
+void cpumask_or(cpu_mask *dst, const cpu_mask *src) {
+    int c;
+    if (!dst || !src) return;
+    CPUMASK_FOR_EACH(c, src)
+        cpumask_set(dst, c);
+}
+
+void cpumask_andnot(cpu_mask *dst, const cpu_mask *src) {
+    int i, wd;
+    if (!dst || !src) return;
+    wd = FLAGSET_WORDS(dst->nbits);
+    for (i = 0; i < FLAGSET_WORDS(src->nbits) && i < wd; i++)
+        dst->bits[i] &= ~src->bits[i];
+}
+
+cpu_mask *cpumask_from_list(const char *list) {
+    cpu_mask *m;
+    const char *p = list;
+    char *end;
+    long a, b;
+    if (!list) return NULL;
+    m = cpumask_new(64);
+    if (!m) return NULL;
+    while (*p) {
+        while (*p == ',' || *p == ' ' || *p == '\n') p++;
+        if (!*p) break;
+        a = strtol(p, &end, 10);
+        if (end == p) break; /* not a list */
+        b = a;
+        if (*end == '-') {
+            p = end + 1;
+            b = strtol(p, &end, 10);
+            if (end == p) b = a;
+        }
+        for (; a <= b; a++)
+            cpumask_set(m, a);
+        p = end;
+    }
+    return m;
+}
+
+char *cpumask_to_list(const cpu_mask *m) {
+    char *ret, *tmp;
+    int a, b, l = 0, size = 64;
+    ret = malloc(size);
+    if (!ret) return NULL;
+    ret[0] = 0;
+    a = cpumask_next(m, -1);
+    while (a >= 0) {
+        b = a;
+        while (cpumask_test(m, b + 1)) b++;
+        if (size - l < 32) {
+            size *= 2;
+            tmp = realloc(ret, size);
+            if (!tmp) break;
+            ret = tmp;
+        }
+        if (b > a)
+            l += sprintf(ret + l, "%s%d-%d", l ? "," : "", a, b);
+        else
+            l += sprintf(ret + l, "%s%d", l ? "," : "", a);
+        a = cpumask_next(m, b);
+    }
+    return ret;
+}
+
+cpu_mask *get_cpu_mask(const char *file) {
+    cpu_mask *m = NULL;
+    char *fc = get_file_contents(file);
+    if (fc) {
+        m = cpumask_from_list(fc);
+        free(fc);
+    }
+    return m;
+}
+
+cpu_mask *get_cpu_online(void) {
+    cpu_mask *m = get_cpu_mask("/sys/devices/system/cpu/online");
+    int i;
+    if (!m) {
+        /* count the cpuN directories */
+        char fn[64];
+        m = cpumask_new(64);
+        for (i = 0; m; i++) {
+            snprintf(fn, sizeof(fn), "/sys/devices/system/cpu/cpu%d", i);
+            if (!dir_exists(fn)) break;
+            cpumask_set(m, i);
+        }
+    }
+    return m;
+}
@@ -21,37 +21,211 @@
 #ifndef _UTIL_H_
 #define _UTIL_H_
 
+/* -- sysroot -- */
+
+/* Absolute paths read through util are taken relative to the root
+ * directory, so a captured /proc and /sys tree can be replayed.
+ * Defaults to $CPUINFO_SYSROOT, or "/" if unset. */
+#define SYSROOT_ENV "CPUINFO_SYSROOT"
+void util_set_root(const char *root); /* NULL to go back to the default */
+const char *util_root(void); /* "" for / */
+char *util_path(char *buf, int size, const char *path);
+
+/* The sysroot, probe session and probe_stats belong to an env. Each
+ * thread reads through its current env, or a shared default one, so
+ * several envs can be in use at once on different threads. par_for()
+ * workers run in the env of the thread that called it. */
+typedef struct util_env util_env;
+util_env *util_env_new(void);
+void util_env_free(util_env *);
+util_env *util_env_use(util_env *); /* for this thread, NULL for the default, returns the previous */
+util_env *util_env_current(void); /* NULL for the default */
+
+#ifndef PROC_CPUINFO
+#define PROC_CPUINFO "/proc/cpuinfo"
+#endif
+
 char *get_file_contents(const char *file);
+/* the first size - 1 bytes of file, NUL terminated, for values read
+ * again and again; allocates nothing, returns the length or -1 */
+int get_file_buff(const char *file, char *buff, int size);
+
+/* Between probe_begin() and probe_end() every file is read once, and
+ * get_file_contents() and kv_new_file() are served from that copy.
+ * Sessions nest, the copies go away when the outermost one ends. */
+typedef struct {
+    long long opened; /* files opened successfully, probe or not */
+    long long bytes;  /* bytes read */
+    long long hits;   /* reads served from the probe cache */
+    long long stored; /* reads served from the stored cache file */
+} probe_stats;
+
+void probe_begin(void);
+void probe_end(void);
+int probe_active(void);
+const char *probe_file(const char *file); /* shared, valid until probe_end(), NULL if missing or no probe */
+void probe_get_stats(probe_stats *);
+void probe_reset_stats(void);
+/* Keep the files that only change on reboot or cpu hotplug (cpuinfo,
+ * topology, caches, device-tree, dmi) in file, checked against boot_id
+ * and the online cpus, so later sessions skip reading them. Live values
+ * are always read. NULL, the default, turns it off. */
+void probe_cache_set_file(const char *file);
 int dir_exists(const char* path);
 
 /* -- /sys/devices/system/cpu/.. -- */
 int get_cpu_int(const char* item, int cpuid);
 char *get_cpu_str(const char* item, int cpuid);
 int get_cpu_freq(int id, int *min, int *max, int *cur);
+long get_size_str(const char *str); /* "32K", "8M" to bytes */
+
+/* -- bounded worker pool for independent per-cpu probes -- */
+
+#define PAR_JOBS_MAX 16
+
+void par_set_jobs(int jobs); /* 1 is serial, 0 picks from the online cpus */
+int par_jobs(void);
+/* func(data, i) for i in [0, count), in any order on up to par_jobs()
+ * threads, returns when all are done. func must only write its own
+ * slot i, merge afterwards in index order to keep output deterministic.
+ * A par_for() from inside func runs serially on the calling thread. */
+void par_for(int count, void (*func)(void *data, int i), void *data);
+
+/* -- work done on first use -- */
+
+typedef void (*lazy_func)(void *data);
+/* func(data) the first time bit is not yet set in *done, later calls
+ * return at once. Safe from several threads, but func must not call
+ * lazy_once() itself, so run what it depends on first. */
+void lazy_once(int *done, int bit, lazy_func func, void *data);
+
+/* -- batched reads of many small files -- */
+
+#define READ_BATCH_AUTO    0 /* io_uring, else threads */
+#define READ_BATCH_URING   1
+#define READ_BATCH_THREADS 2 /* pool of pread() threads */
+#define READ_BATCH_SERIAL  3
+
+#define READ_REQ_PATH 160
+#define READ_REQ_BUFF 64 /* sysfs values are short */
+
+typedef struct {
+    char path[READ_REQ_PATH]; /* already below the sysroot */
+    char buff[READ_REQ_BUFF];
+    int len; /* bytes read, -1 if the file could not be read */
+} read_req;
+
+void read_batch_set_mode(int mode); /* for all read_batch() calls */
+int read_batch_mode(void);
+int read_batch(read_req *reqs, int count); /* returns the mode actually used */
+
+/* /sys/devices/system/cpu/cpu<ids[i]>/<items[k]> as reqs[i * nitems + k],
+ * free() the result */
+read_req *read_cpu_batch(const int *ids, int count, const char **items, int nitems);
+int read_req_int(const read_req *);
+/* get_cpu_freq() for many cpus in one batch, arrays of count */
+int get_cpu_freq_batch(const int *ids, int count, int *min, int *max, int *cur);
+int get_cpu_freq_cur_batch(const int *ids, int count, int *cur); /* just scaling_cur_freq */
+
+/* -- cpu masks -- */
+
+typedef struct {
+    int nbits;
+    unsigned long long *bits;
+} cpu_mask;
+
+cpu_mask *cpumask_new(int nbits);
+cpu_mask *cpumask_copy(const cpu_mask *);
+cpu_mask *cpumask_from_list(const char *list); /* "0-3,8,10-11" as in sysfs */
+char *cpumask_to_list(const cpu_mask *); /* free() the result */
+void cpumask_free(cpu_mask *);
+int cpumask_set(cpu_mask *, int cpu); /* grows the mask */
+void cpumask_clear(cpu_mask *, int cpu);
+int cpumask_test(const cpu_mask *, int cpu);
+int cpumask_count(const cpu_mask *);
+int cpumask_next(const cpu_mask *, int prev); /* prev = -1 for first, -1 at end */
+int cpumask_equal(const cpu_mask *, const cpu_mask *);
+void cpumask_and(cpu_mask *dst, const cpu_mask *src);
+void cpumask_or(cpu_mask *dst, const cpu_mask *src);
+void cpumask_andnot(cpu_mask *dst, const cpu_mask *src);
+#define CPUMASK_FOR_EACH(c, m) for ((c) = cpumask_next((m), -1); (c) >= 0; (c) = cpumask_next((m), (c)))
+
+/* read a cpulist file, like /sys/devices/system/cpu/online */
+cpu_mask *get_cpu_mask(const char *file);
+cpu_mask *get_cpu_online(void);
 
 /* -- string structures used in cpu_*  -- */
 
 typedef struct {
     int ref_count;
     char *str;
+    unsigned int hash;
 } cpu_string;
 
+typedef struct strlist_chunk strlist_chunk;
+
+/* strs[] keeps insertion order; strings are interned through a hash
+ * index and live in an arena, so a returned char* stays valid until
+ * strlist_free() even as the list grows */
 typedef struct {
     int count;
     cpu_string *strs;
+
+    int alloc;
+    int *index; /* open addressing: slot -> strs[] index, -1 if empty */
+    int index_size;
+    strlist_chunk *arena;
 } cpu_string_list;
 
 cpu_string_list *strlist_new(void);
 void strlist_free(cpu_string_list *list);
 char *strlist_add_w(cpu_string_list *list, const char* str, int weight);
 char *strlist_add(cpu_string_list *list, const char* str);
+char *strlist_add_wn(cpu_string_list *list, const char* str, int len, int weight);
+char *strlist_add_n(cpu_string_list *list, const char* str, int len);
+int strlist_find(cpu_string_list *list, const char* str); /* index into strs, -1 if not found */
+int strlist_find_n(cpu_string_list *list, const char* str, int len);
+
+/* -- flag bitsets: one row per thread, one bit per flag -- */
+
+typedef struct {
+    cpu_string_list *ids; /* flag -> bit: a static table first, then unknown flags as seen */
+    int known;            /* bits below this come from the static table */
+    int rows, words;
+    unsigned long long *bits; /* rows * words */
+    int *count;           /* rows with each bit set, after flagset_count_rows() */
+} cpu_flagset;
+
+#define FLAGSET_WORDS(nbits) (((nbits) + 63) / 64)
+#define FLAGSET_BIT_SET(bits, id) ((bits)[(id) / 64] |= 1ULL << ((id) % 64))
+#define FLAGSET_BIT_TEST(bits, id) (!!((bits)[(id) / 64] & (1ULL << ((id) % 64))))
+
+cpu_flagset *flagset_new(const char *(*known_name)(int id), int known);
+void flagset_free(cpu_flagset *);
+int flagset_id(cpu_flagset *, const char *flag, int len, int add); /* -1 if not registered */
+int flagset_alloc(cpu_flagset *, int rows); /* after all flags are registered */
+void flagset_or(cpu_flagset *, int row, const unsigned long long *bits);
+int flagset_test(const cpu_flagset *, int row, int id);
+void flagset_count_rows(cpu_flagset *);
+int flagset_count(const cpu_flagset *, int id); /* rows with flag */
 
 /* -- key / value scan  -- */
+
+/* a view into the scanned buffer, not NUL-terminated at len */
+typedef struct {
+    const char *str;
+    int len;
+} kv_slice;
+
 typedef struct kv_scan kv_scan;
 
 kv_scan *kv_new(char *buffer);
 kv_scan *kv_new_file(const char *file);
-int kv_next(kv_scan *, char **key, char **value);
+int kv_next(kv_scan *, kv_slice *key, kv_slice *value);
 void kv_free(kv_scan *);
 
+int kv_slice_eq(const kv_slice *, const char *str, int len);
+char *kv_slice_copy(char *dest, int size, const kv_slice *);
+#define KV_IS(sl, k) kv_slice_eq(sl, k, sizeof(k) - 1)
+
 #endif
@@ -21,8 +21,17 @@
 #ifndef _X86DATA_H_
 #define _X86DATA_H_
 
+#include "x86_flags.h"
+
+#define X86_FLAG_ENUM(id, name, meaning) X86_FLAG_##id,
+typedef enum {
+    X86_FLAG_TABLE(X86_FLAG_ENUM)
+    X86_FLAG_N_KNOWN
+} x86_flag_id;
+
 /* cpu flags from /proc/cpuinfo */
 const char *x86_flag_list(void);                 /* list of all known flags */
 const char *x86_flag_meaning(const char *flag);  /* lookup flag meaning */
+const char *x86_flag_name(int id);               /* name of a known x86_flag_id */
 
 #endif
@@ -0,0 +1,283 @@
+/*
+ * rpiz - https://github.com/bp0/rpiz
+ * Copyright (C) 2017  Burt P. <pburt0@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+#ifndef _X86FLAGS_H_
+#define _X86FLAGS_H_
+
+/* flags known to x86_data.c; the order defines the x86_flag_id values
+ * X(id, name, meaning) */
+#define X86_FLAG_TABLE(X) \
+/* Intel-defined CPU features, CPUID level 0x00000001 (edx) \
+ * See also Wikipedia and table 2-27 in Intel Advanced Vector Extensions Programming Reference */ \
+    X(FPU,                 "fpu",                 N_("Onboard FPU (floating point support)")) \
+    X(VME,                 "vme",                 N_("Virtual 8086 mode enhancements")) \
+    X(DE,                  "de",                  N_("Debugging Extensions (CR4.DE)")) \
+    X(PSE,                 "pse",                 N_("Page Size Extensions (4MB memory pages)")) \
+    X(TSC,                 "tsc",                 N_("Time Stamp Counter (RDTSC)")) \
+    X(MSR,                 "msr",                 N_("Model-Specific Registers (RDMSR, WRMSR)")) \
+    X(PAE,                 "pae",                 N_("Physical Address Extensions (support for more than 4GB of RAM)")) \
+    X(MCE,                 "mce",                 N_("Machine Check Exception")) \
+    X(CX8,                 "cx8",                 N_("CMPXCHG8 instruction (64-bit compare-and-swap)")) \
+    X(APIC,                "apic",                N_("Onboard APIC")) \
+    X(SEP,                 "sep",                 N_("SYSENTER/SYSEXIT")) \
+    X(MTRR,                "mtrr",                N_("Memory Type Range Registers")) \
+    X(PGE,                 "pge",                 N_("Page Global Enable (global bit in PDEs and PTEs)")) \
+    X(MCA,                 "mca",                 N_("Machine Check Architecture")) \
+    X(CMOV,                "cmov",                N_("CMOV instructions (conditional move) (also FCMOV)")) \
+    X(PAT,                 "pat",                 N_("Page Attribute Table")) \
+    X(PSE36,               "pse36",               N_("36-bit PSEs (huge pages)")) \
+    X(PN,                  "pn",                  N_("Processor serial number")) \
+    X(CLFLUSH,             "clflush",             N_("Cache Line Flush instruction")) \
+    X(DTS,                 "dts",                 N_("Debug Store (buffer for debugging and profiling instructions), or alternately: digital thermal sensor")) \
+    X(ACPI,                "acpi",                N_("ACPI via MSR (temperature monitoring and clock speed modulation)")) \
+    X(MMX,                 "mmx",                 N_("Multimedia Extensions")) \
+    X(FXSR,                "fxsr",                N_("FXSAVE/FXRSTOR, CR4.OSFXSR")) \
+    X(SSE,                 "sse",                 N_("Intel SSE vector instructions")) \
+    X(SSE2,                "sse2",                N_("SSE2")) \
+    X(SS,                  "ss",                  N_("CPU self snoop")) \
+    X(HT,                  "ht",                  N_("Hyper-Threading")) \
+    X(TM,                  "tm",                  N_("Automatic clock control (Thermal Monitor)")) \
+    X(IA64,                "ia64",                N_("Intel Itanium Architecture 64-bit (not to be confused with Intel's 64-bit x86 architecture with flag x86-64 or \"AMD64\" bit indicated by flag lm)")) \
+    X(PBE,                 "pbe",                 N_("Pending Break Enable (PBE# pin) wakeup support")) \
+/* AMD-defined CPU features, CPUID level 0x80000001 \
+ * See also Wikipedia and table 2-23 in Intel Advanced Vector Extensions Programming Reference */ \
+    X(SYSCALL,             "syscall",             N_("SYSCALL (Fast System Call) and SYSRET (Return From Fast System Call)")) \
+    X(MP,                  "mp",                  N_("Multiprocessing Capable.")) \
+    X(NX,                  "nx",                  N_("Execute Disable")) \
+    X(MMXEXT,              "mmxext",              N_("AMD MMX extensions")) \
+    X(FXSR_OPT,            "fxsr_opt",            N_("FXSAVE/FXRSTOR optimizations")) \
+    X(PDPE1GB,             "pdpe1gb",             N_("One GB pages (allows hugepagesz=1G)")) \
+    X(RDTSCP,              "rdtscp",              N_("Read Time-Stamp Counter and Processor ID")) \
+    X(LM,                  "lm",                  N_("Long Mode (x86-64: amd64, also known as Intel 64, i.e. 64-bit capable)")) \
+    X(3DNOW,               "3dnow",               N_("3DNow! (AMD vector instructions, competing with Intel's SSE1)")) \
+    X(3DNOWEXT,            "3dnowext",            N_("AMD 3DNow! extensions")) \
+/* Transmeta-defined CPU features, CPUID level 0x80860001 */ \
+    X(RECOVERY,            "recovery",            N_("CPU in recovery mode")) \
+    X(LONGRUN,             "longrun",             N_("Longrun power control")) \
+    X(LRTI,                "lrti",                N_("LongRun table interface")) \
+/* Other features, Linux-defined mapping */ \
+    X(CXMMX,               "cxmmx",               N_("Cyrix MMX extensions")) \
+    X(K6_MTRR,             "k6_mtrr",             N_("AMD K6 nonstandard MTRRs")) \
+    X(CYRIX_ARR,           "cyrix_arr",           N_("Cyrix ARRs (= MTRRs)")) \
+    X(CENTAUR_MCR,         "centaur_mcr",         N_("Centaur MCRs (= MTRRs)")) \
+    X(CONSTANT_TSC,        "constant_tsc",        N_("TSC ticks at a constant rate")) \
+    X(UP,                  "up",                  N_("SMP kernel running on UP")) \
+    X(ART,                 "art",                 N_("Always-Running Timer")) \
+    X(ARCH_PERFMON,        "arch_perfmon",        N_("Intel Architectural PerfMon")) \
+    X(PEBS,                "pebs",                N_("Precise-Event Based Sampling")) \
+    X(BTS,                 "bts",                 N_("Branch Trace Store")) \
+    X(REP_GOOD,            "rep_good",            N_("rep microcode works well")) \
+    X(ACC_POWER,           "acc_power",           N_("AMD accumulated power mechanism")) \
+    X(NOPL,                "nopl",                N_("The NOPL (0F 1F) instructions")) \
+    X(XTOPOLOGY,           "xtopology",           N_("cpu topology enum extensions")) \
+    X(TSC_RELIABLE,        "tsc_reliable",        N_("TSC is known to be reliable")) \
+    X(NONSTOP_TSC,         "nonstop_tsc",         N_("TSC does not stop in C states")) \
+    X(EXTD_APICID,         "extd_apicid",         N_("has extended APICID (8 bits)")) \
+    X(AMD_DCM,             "amd_dcm",             N_("multi-node processor")) \
+    X(APERFMPERF,          "aperfmperf",          N_("APERFMPERF")) \
+    X(EAGERFPU,            "eagerfpu",            N_("Non lazy FPU restore")) \
+    X(NONSTOP_TSC_S3,      "nonstop_tsc_s3",      N_("TSC doesn't stop in S3 state")) \
+    X(MCE_RECOVERY,        "mce_recovery",        N_("CPU has recoverable machine checks")) \
+/* Intel-defined CPU features, CPUID level 0x00000001 (ecx) \
+ * See also Wikipedia and table 2-26 in Intel Advanced Vector Extensions Programming Reference */ \
+    X(PNI,                 "pni",                 N_("SSE-3 (“Prescott New Instructions”)")) \
+    X(PCLMULQDQ,           "pclmulqdq",           N_("Perform a Carry-Less Multiplication of Quadword instruction — accelerator for GCM)")) \
+    X(DTES64,              "dtes64",              N_("64-bit Debug Store")) \
+    X(MONITOR,             "monitor",             N_("Monitor/Mwait support (Intel SSE3 supplements)")) \
+    X(DS_CPL,              "ds_cpl",              N_("CPL Qual. Debug Store")) \
+    X(VMX,                 "vmx",                 N_("Hardware virtualization, Intel VMX")) \
+    X(SMX,                 "smx",                 N_("Safer mode TXT (TPM support)")) \
+    X(EST,                 "est",                 N_("Enhanced SpeedStep")) \
+    X(TM2,                 "tm2",                 N_("Thermal Monitor 2")) \
+    X(SSSE3,               "ssse3",               N_("Supplemental SSE-3")) \
+    X(CID,                 "cid",                 N_("Context ID")) \
+    X(SDBG,                "sdbg",                N_("silicon debug")) \
+    X(FMA,                 "fma",                 N_("Fused multiply-add")) \
+    X(CX16,                "cx16",                N_("CMPXCHG16B")) \
+    X(XTPR,                "xtpr",                N_("Send Task Priority Messages")) \
+    X(PDCM,                "pdcm",                N_("Performance Capabilities")) \
+    X(PCID,                "pcid",                N_("Process Context Identifiers")) \
+    X(DCA,                 "dca",                 N_("Direct Cache Access")) \
+    X(SSE4_1,              "sse4_1",              N_("SSE-4.1")) \
+    X(SSE4_2,              "sse4_2",              N_("SSE-4.2")) \
+    X(X2APIC,              "x2apic",              N_("x2APIC")) \
+    X(MOVBE,               "movbe",               N_("Move Data After Swapping Bytes instruction")) \
+    X(POPCNT,              "popcnt",              N_("Return the Count of Number of Bits Set to 1 instruction (Hamming weight, i.e. bit count)")) \
+    X(TSC_DEADLINE_TIMER,  "tsc_deadline_timer",  N_("Tsc deadline timer")) \
+    X(AES,                 "aes",                 N_("Advanced Encryption Standard (New Instructions)")) \
+    X(XSAVE,               "xsave",               N_("Save Processor Extended States: also provides XGETBY,XRSTOR,XSETBY")) \
+    X(AVX,                 "avx",                 N_("Advanced Vector Extensions")) \
+    X(F16C,                "f16c",                N_("16-bit fp conversions (CVT16)")) \
+    X(RDRAND,              "rdrand",              N_("Read Random Number from hardware random number generator instruction")) \
+    X(HYPERVISOR,          "hypervisor",          N_("Running on a hypervisor")) \
+/* VIA/Cyrix/Centaur-defined CPU features, CPUID level 0xC0000001 */ \
+    X(RNG,                 "rng",                 N_("Random Number Generator present (xstore)")) \
+    X(RNG_EN,              "rng_en",              N_("Random Number Generator enabled")) \
+    X(ACE,                 "ace",                 N_("on-CPU crypto (xcrypt)")) \
+    X(ACE_EN,              "ace_en",              N_("on-CPU crypto enabled")) \
+    X(ACE2,                "ace2",                N_("Advanced Cryptography Engine v2")) \
+    X(ACE2_EN,             "ace2_en",             N_("ACE v2 enabled")) \
+    X(PHE,                 "phe",                 N_("PadLock Hash Engine")) \
+    X(PHE_EN,              "phe_en",              N_("PHE enabled")) \
+    X(PMM,                 "pmm",                 N_("PadLock Montgomery Multiplier")) \
+    X(PMM_EN,              "pmm_en",              N_("PMM enabled")) \
+/* More extended AMD flags: CPUID level 0x80000001, ecx */ \
+    X(LAHF_LM,             "lahf_lm",             N_("Load AH from Flags (LAHF) and Store AH into Flags (SAHF) in long mode")) \
+    X(CMP_LEGACY,          "cmp_legacy",          N_("If yes HyperThreading not valid")) \
+    X(SVM,                 "svm",                 N_("\"Secure virtual machine\": AMD-V")) \
+    X(EXTAPIC,             "extapic",             N_("Extended APIC space")) \
+    X(CR8_LEGACY,          "cr8_legacy",          N_("CR8 in 32-bit mode")) \
+    X(ABM,                 "abm",                 N_("Advanced Bit Manipulation")) \
+    X(SSE4A,               "sse4a",               N_("SSE-4A")) \
+    X(MISALIGNSSE,         "misalignsse",         N_("indicates if a general-protection exception (#GP) is generated when some legacy SSE instructions operate on unaligned data. Also depends on CR0 and Alignment Checking bit")) \
+    X(3DNOWPREFETCH,       "3dnowprefetch",       N_("3DNow prefetch instructions")) \
+    X(OSVW,                "osvw",                N_("indicates OS Visible Workaround, which allows the OS to work around processor errata.")) \
+    X(IBS,                 "ibs",                 N_("Instruction Based Sampling")) \
+    X(XOP,                 "xop",                 N_("extended AVX instructions")) \
+    X(SKINIT,              "skinit",              N_("SKINIT/STGI instructions")) \
+    X(WDT,                 "wdt",                 N_("Watchdog timer")) \
+    X(LWP,                 "lwp",                 N_("Light Weight Profiling")) \
+    X(FMA4,                "fma4",                N_("4 operands MAC instructions")) \
+    X(TCE,                 "tce",                 N_("translation cache extension")) \
+    X(NODEID_MSR,          "nodeid_msr",          N_("NodeId MSR")) \
+    X(TBM,                 "tbm",                 N_("Trailing Bit Manipulation")) \
+    X(TOPOEXT,             "topoext",             N_("Topology Extensions CPUID leafs")) \
+    X(PERFCTR_CORE,        "perfctr_core",        N_("Core Performance Counter Extensions")) \
+    X(PERFCTR_NB,          "perfctr_nb",          N_("NB Performance Counter Extensions")) \
+    X(BPEXT,               "bpext",               N_("data breakpoint extension")) \
+    X(PTSC,                "ptsc",                N_("performance time-stamp counter")) \
+    X(PERFCTR_L2,          "perfctr_l2",          N_("L2 Performance Counter Extensions")) \
+    X(MWAITX,              "mwaitx",              N_("MWAIT extension (MONITORX/MWAITX)")) \
+/* Auxiliary flags: Linux defined - For features scattered in various CPUID levels */ \
+    X(CPB,                 "cpb",                 N_("AMD Core Performance Boost")) \
+    X(EPB,                 "epb",                 N_("IA32_ENERGY_PERF_BIAS support")) \
+    X(HW_PSTATE,           "hw_pstate",           N_("AMD HW-PState")) \
+    X(PROC_FEEDBACK,       "proc_feedback",       N_("AMD ProcFeedbackInterface")) \
+    X(INTEL_PT,            "intel_pt",            N_("Intel Processor Tracing")) \
+/* Virtualization flags: Linux defined */ \
+    X(TPR_SHADOW,          "tpr_shadow",          N_("Intel TPR Shadow")) \
+    X(VNMI,                "vnmi",                N_("Intel Virtual NMI")) \
+    X(FLEXPRIORITY,        "flexpriority",        N_("Intel FlexPriority")) \
+    X(EPT,                 "ept",                 N_("Intel Extended Page Table")) \
+    X(VPID,                "vpid",                N_("Intel Virtual Processor ID")) \
+    X(VMMCALL,             "vmmcall",             N_("prefer VMMCALL to VMCALL")) \
+/* Intel-defined CPU features, CPUID level 0x00000007:0 (ebx) */ \
+    X(FSGSBASE,            "fsgsbase",            N_("{RD/WR}{FS/GS}BASE instructions")) \
+    X(TSC_ADJUST,          "tsc_adjust",          N_("TSC adjustment MSR")) \
+    X(BMI1,                "bmi1",                N_("1st group bit manipulation extensions")) \
+    X(HLE,                 "hle",                 N_("Hardware Lock Elision")) \
+    X(AVX2,                "avx2",                N_("AVX2 instructions")) \
+    X(SMEP,                "smep",                N_("Supervisor Mode Execution Protection")) \
+    X(BMI2,                "bmi2",                N_("2nd group bit manipulation extensions")) \
+    X(ERMS,                "erms",                N_("Enhanced REP MOVSB/STOSB")) \
+    X(INVPCID,             "invpcid",             N_("Invalidate Processor Context ID")) \
+    X(RTM,                 "rtm",                 N_("Restricted Transactional Memory")) \
+    X(CQM,                 "cqm",                 N_("Cache QoS Monitoring")) \
+    X(MPX,                 "mpx",                 N_("Memory Protection Extension")) \
+    X(AVX512F,             "avx512f",             N_("AVX-512 foundation")) \
+    X(AVX512DQ,            "avx512dq",            N_("AVX-512 Double/Quad instructions")) \
+    X(RDSEED,              "rdseed",              N_("The RDSEED instruction")) \
+    X(ADX,                 "adx",                 N_("The ADCX and ADOX instructions")) \
+    X(SMAP,                "smap",                N_("Supervisor Mode Access Prevention")) \
+    X(CLFLUSHOPT,          "clflushopt",          N_("CLFLUSHOPT instruction")) \
+    X(CLWB,                "clwb",                N_("CLWB instruction")) \
+    X(AVX512PF,            "avx512pf",            N_("AVX-512 Prefetch")) \
+    X(AVX512ER,            "avx512er",            N_("AVX-512 Exponential and Reciprocal")) \
+    X(AVX512CD,            "avx512cd",            N_("AVX-512 Conflict Detection")) \
+    X(SHA_NI,              "sha_ni",              N_("SHA1/SHA256 Instruction Extensions")) \
+    X(AVX512BW,            "avx512bw",            N_("AVX-512 Byte/Word instructions")) \
+    X(AVX512VL,            "avx512vl",            N_("AVX-512 128/256 Vector Length extensions")) \
+/* Extended state features, CPUID level 0x0000000d:1 (eax) */ \
+    X(XSAVEOPT,            "xsaveopt",            N_("Optimized XSAVE")) \
+    X(XSAVEC,              "xsavec",              N_("XSAVEC")) \
+    X(XGETBV1,             "xgetbv1",             N_("XGETBV with ECX = 1")) \
+    X(XSAVES,              "xsaves",              N_("XSAVES/XRSTORS")) \
+/* Intel-defined CPU QoS sub-leaf, CPUID level 0x0000000F:0 (edx) */ \
+    X(CQM_LLC,             "cqm_llc",             N_("LLC QoS")) \
+/* Intel-defined CPU QoS sub-leaf, CPUID level 0x0000000F:1 (edx) */ \
+    X(CQM_OCCUP_LLC,       "cqm_occup_llc",       N_("LLC occupancy monitoring")) \
+    X(CQM_MBM_TOTAL,       "cqm_mbm_total",       N_("LLC total MBM monitoring")) \
+    X(CQM_MBM_LOCAL,       "cqm_mbm_local",       N_("LLC local MBM monitoring")) \
+/* AMD-defined CPU features, CPUID level 0x80000008 (ebx) */ \
+    X(CLZERO,              "clzero",              N_("CLZERO instruction")) \
+    X(IRPERF,              "irperf",              N_("instructions retired performance counter")) \
+/* Thermal and Power Management leaf, CPUID level 0x00000006 (eax) */ \
+    X(DTHERM,              "dtherm",              N_("digital thermal sensor")) /* formerly dts */ \
+    X(IDA,                 "ida",                 N_("Intel Dynamic Acceleration")) \
+    X(ARAT,                "arat",                N_("Always Running APIC Timer")) \
+    X(PLN,                 "pln",                 N_("Intel Power Limit Notification")) \
+    X(PTS,                 "pts",                 N_("Intel Package Thermal Status")) \
+    X(HWP,                 "hwp",                 N_("Intel Hardware P-states")) \
+    X(HWP_NOTIFY,          "hwp_notify",          N_("HWP notification")) \
+    X(HWP_ACT_WINDOW,      "hwp_act_window",      N_("HWP Activity Window")) \
+    X(HWP_EPP,             "hwp_epp",             N_("HWP Energy Performance Preference")) \
+    X(HWP_PKG_REQ,         "hwp_pkg_req",         N_("HWP package-level request")) \
+/* AMD SVM Feature Identification, CPUID level 0x8000000a (edx) */ \
+    X(NPT,                 "npt",                 N_("AMD Nested Page Table support")) \
+    X(LBRV,                "lbrv",                N_("AMD LBR Virtualization support")) \
+    X(SVM_LOCK,            "svm_lock",            N_("AMD SVM locking MSR")) \
+    X(NRIP_SAVE,           "nrip_save",           N_("AMD SVM next_rip save")) \
+    X(TSC_SCALE,           "tsc_scale",           N_("AMD TSC scaling support")) \
+    X(VMCB_CLEAN,          "vmcb_clean",          N_("AMD VMCB clean bits support")) \
+    X(FLUSHBYASID,         "flushbyasid",         N_("AMD flush-by-ASID support")) \
+    X(DECODEASSISTS,       "decodeassists",       N_("AMD Decode Assists support")) \
+    X(PAUSEFILTER,         "pausefilter",         N_("AMD filtered pause intercept")) \
+    X(PFTHRESHOLD,         "pfthreshold",         N_("AMD pause filter threshold")) \
+    X(AVIC,                "avic",                N_("Virtual Interrupt Controller")) \
+/* Intel-defined CPU features, CPUID level 0x00000007:0 (ecx) */ \
+    X(PKU,                 "pku",                 N_("Protection Keys for Userspace")) \
+    X(OSPKE,               "ospke",               N_("OS Protection Keys Enable")) \
+/* AMD-defined CPU features, CPUID level 0x80000007 (ebx) */ \
+    X(OVERFLOW_RECOV,      "overflow_recov",      N_("MCA overflow recovery support")) \
+    X(SUCCOR,              "succor",              N_("uncorrectable error containment and recovery")) \
+    X(SMCA,                "smca",                N_("Scalable MCA")) \
+ \
+/* bug workarounds */ \
+    X(BUG_F00F,            "bug:f00f",            N_("Intel F00F bug")) \
+    X(BUG_FDIV,            "bug:fdiv",            N_("FPU FDIV")) \
+    X(BUG_COMA,            "bug:coma",            N_("Cyrix 6x86 coma")) \
+    X(BUG_TLB_MMATCH,      "bug:tlb_mmatch",      N_("AMD Erratum 383")) \
+    X(BUG_APIC_C1E,        "bug:apic_c1e",        N_("AMD Erratum 400")) \
+    X(BUG_11AP,            "bug:11ap",            N_("Bad local APIC aka 11AP")) \
+    X(BUG_FXSAVE_LEAK,     "bug:fxsave_leak",     N_("FXSAVE leaks FOP/FIP/FOP")) \
+    X(BUG_CLFLUSH_MONITOR, "bug:clflush_monitor", N_("AAI65, CLFLUSH required before MONITOR")) \
+    X(BUG_SYSRET_SS_ATTRS, "bug:sysret_ss_attrs", N_("SYSRET doesn't fix up SS attrs")) \
+    X(BUG_ESPFIX,          "bug:espfix",          N_("IRET to 16-bit SS corrupts ESP/RSP high bits")) \
+    X(BUG_NULL_SEG,        "bug:null_seg",        N_("Nulling a selector preserves the base")) /* see: detect_null_seg_behavior() */ \
+    X(BUG_SWAPGS_FENCE,    "bug:swapgs_fence",    N_("SWAPGS without input dep on GS")) \
+    X(BUG_MONITOR,         "bug:monitor",         N_("IPI required to wake up remote CPU")) \
+    X(BUG_AMD_E400,        "bug:amd_e400",        N_("AMD Erratum 400")) \
+/* power management \
+ * ... from arch/x86/kernel/cpu/powerflags.h */ \
+    X(PM_TS,               "pm:ts",               N_("temperature sensor")) \
+    X(PM_FID,              "pm:fid",              N_("frequency id control")) \
+    X(PM_VID,              "pm:vid",              N_("voltage id control")) \
+    X(PM_TTP,              "pm:ttp",              N_("thermal trip")) \
+    X(PM_TM,               "pm:tm",               N_("hardware thermal control")) \
+    X(PM_STC,              "pm:stc",              N_("software thermal control")) \
+    X(PM_100MHZSTEPS,      "pm:100mhzsteps",      N_("100 MHz multiplier control")) \
+    X(PM_HWPSTATE,         "pm:hwpstate",         N_("hardware P-state control")) \
+/*  { "pm:",              N_("tsc invariant mapped to constant_tsc") }, */ \
+    X(PM_CPB,              "pm:cpb",              N_("core performance boost")) \
+    X(PM_EFF_FREQ_RO,      "pm:eff_freq_ro",      N_("Readonly aperf/mperf")) \
+    X(PM_PROC_FEEDBACK,    "pm:proc_feedback",    N_("processor feedback interface")) \
+    X(PM_ACC_POWER,        "pm:acc_power",        N_("accumulated power mechanism"))
+
+#endif